@@ -0,0 +1,441 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   bench.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Times the pieces of obrender one call at a time, for every theme in a
+   directory and a range of sizes:
+
+     render      RrRender of the theme's appearance, as it is drawn
+     gradient    RrRender of the same appearance without its bevel and
+                 border, so render - gradient is what those cost
+     reduce      RrReduceDepth of the rendered pixels for the X visual
+     paint       RrPaintPixmap, which renders and uploads to the X server
+     text_size   RrFontMeasureString of a window title
+     text_paint  RrPaintPixmap of a window title in the theme's label
+     icon        RrImageDrawRGBA scaling a 128x128 icon down to the size
+
+   Each result is printed as a line of JSON, with the percentiles of the
+   time per call, and a checksum of what was drawn so that a change which
+   draws something different shows up as well as one which is slower.
+
+     obrender-bench [-n CALLS] THEMEDIR [THEME...]
+*/
+
+#include "render.h"
+#include "theme.h"
+#include "gradient.h"
+#include "color.h"
+#include "image.h"
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define WARMUP_CALLS 20
+#define ICON_SIZE 128
+
+typedef struct _BenchCase BenchCase;
+
+struct _BenchCase {
+    const RrInstance *inst;
+    RrAppearance *a;
+    gint w, h;
+    const gchar *text;
+    XImage *im;
+    RrPixel32 *scratch;
+    RrTextureRGBA icon;
+    RrPixel32 *target;
+    RrRect area;
+};
+
+typedef struct _BenchTest {
+    const gchar *name;
+    void (*func)(BenchCase *c);
+    guint32 (*sum)(BenchCase *c);
+} BenchTest;
+
+static const struct {
+    const gchar *name;
+    gint w, h;
+} sizes[] = {
+    { "button", 18, 18 },
+    { "title", 300, 22 },
+    { "wide", 1600, 24 },
+    { "menu", 250, 400 }
+};
+
+static gint calls = 200;
+static gdouble *times;
+
+static const gchar *title_text =
+    "obrender-bench - a window title which is long enough to be ellipsized";
+
+/* FNV-1a */
+static guint32 checksum(const void *data, gsize len)
+{
+    const guchar *p = data;
+    guint32 h = 2166136261u;
+    gsize i;
+
+    for (i = 0; i < len; ++i)
+        h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+static guint32 sum_pixels(BenchCase *c)
+{
+    return checksum(c->a->surface.pixel_data,
+                    c->w * c->h * sizeof(RrPixel32));
+}
+
+static guint32 sum_pixmap(BenchCase *c)
+{
+    XImage *im;
+    guint32 h;
+
+    im = XGetImage(RrDisplay(c->inst), c->a->pixmap, 0, 0, c->w, c->h,
+                   AllPlanes, ZPixmap);
+    if (!im) return 0;
+    h = checksum(im->data, im->bytes_per_line * im->height);
+    XDestroyImage(im);
+    return h;
+}
+
+static void bench_render(BenchCase *c)
+{
+    RrRender(c->a, c->w, c->h);
+}
+
+static void bench_reduce(BenchCase *c)
+{
+    /* RrReduceDepth points the image at the pixels, when they are already
+       in the format of the visual */
+    c->im->data = (gchar*)c->scratch;
+    RrReduceDepth(c->inst, c->a->surface.pixel_data, c->im);
+}
+
+static guint32 sum_reduce(BenchCase *c)
+{
+    return checksum(c->im->data, c->im->bytes_per_line * c->im->height);
+}
+
+static void bench_paint(BenchCase *c)
+{
+    RrPaintPixmap(c->a, c->w, c->h);
+    /* include the time the server takes to draw it */
+    XSync(RrDisplay(c->inst), FALSE);
+}
+
+static void bench_text_size(BenchCase *c)
+{
+    RrSize *s;
+
+    s = RrFontMeasureString(c->a->texture[0].data.text.font, c->text,
+                            0, 0, FALSE, 0);
+    g_slice_free(RrSize, s);
+}
+
+static guint32 sum_text_size(BenchCase *c)
+{
+    RrSize *s;
+    guint32 h;
+
+    s = RrFontMeasureString(c->a->texture[0].data.text.font, c->text,
+                            0, 0, FALSE, 0);
+    h = checksum(s, sizeof(RrSize));
+    g_slice_free(RrSize, s);
+    return h;
+}
+
+static void bench_icon(BenchCase *c)
+{
+    RrImageDrawRGBA(c->target, &c->icon, c->w, c->h, &c->area);
+}
+
+static guint32 sum_icon(BenchCase *c)
+{
+    return checksum(c->target, c->w * c->h * sizeof(RrPixel32));
+}
+
+static const BenchTest surface_tests[] = {
+    { "render", bench_render, sum_pixels },
+    { "reduce", bench_reduce, sum_reduce },
+    { "paint", bench_paint, sum_pixmap }
+};
+
+static gint cmp_double(gconstpointer a, gconstpointer b)
+{
+    const gdouble da = *(const gdouble*)a, db = *(const gdouble*)b;
+    return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+static void run(const gchar *theme, const gchar *appearance,
+                const gchar *size, const BenchTest *t, BenchCase *c)
+{
+    GTimer *timer;
+    gdouble sum = 0;
+    gint i;
+
+    for (i = 0; i < WARMUP_CALLS; ++i)
+        t->func(c);
+
+    timer = g_timer_new();
+    for (i = 0; i < calls; ++i) {
+        g_timer_start(timer);
+        t->func(c);
+        times[i] = g_timer_elapsed(timer, NULL) * 1000000.0;
+        sum += times[i];
+    }
+    g_timer_destroy(timer);
+    qsort(times, calls, sizeof(gdouble), cmp_double);
+
+    g_print("{\"theme\": \"%s\", \"test\": \"%s\", \"appearance\": \"%s\", "
+            "\"size\": \"%s\", \"width\": %d, \"height\": %d, "
+            "\"calls\": %d, \"mean_us\": %.2f, \"p50_us\": %.2f, "
+            "\"p95_us\": %.2f, \"p99_us\": %.2f, \"checksum\": \"%08x\"}\n",
+            theme, t->name, appearance, size, c->w, c->h, calls,
+            sum / calls, times[calls / 2], times[calls * 95 / 100],
+            times[calls * 99 / 100], t->sum(c));
+}
+
+/* Use a copy of the appearance, with its own pixel buffer of the size */
+static RrAppearance* appearance_at_size(RrAppearance *a, gint w, gint h)
+{
+    a = RrAppearanceCopy(a);
+    g_free(a->surface.pixel_data);
+    a->surface.pixel_data = g_new(RrPixel32, w * h);
+    a->w = w;
+    a->h = h;
+    return a;
+}
+
+static void bench_surface(const gchar *theme, const gchar *name,
+                          RrAppearance *look, const RrInstance *inst)
+{
+    guint i, j;
+
+    /* these are drawn from their parent, not on their own */
+    if (look->surface.grad == RR_SURFACE_PARENTREL)
+        return;
+
+    for (i = 0; i < G_N_ELEMENTS(sizes); ++i) {
+        BenchCase c;
+        BenchTest flat = { "gradient", bench_render, sum_pixels };
+
+        memset(&c, 0, sizeof(c));
+        c.inst = inst;
+        c.w = sizes[i].w;
+        c.h = sizes[i].h;
+        c.a = appearance_at_size(look, c.w, c.h);
+        c.im = XCreateImage(RrDisplay(inst), RrVisual(inst), RrDepth(inst),
+                            ZPixmap, 0, NULL, c.w, c.h, 32, 0);
+        c.scratch = g_new(RrPixel32, c.w * c.h);
+
+        for (j = 0; j < G_N_ELEMENTS(surface_tests); ++j)
+            run(theme, name, sizes[i].name, &surface_tests[j], &c);
+
+        c.a->surface.relief = RR_RELIEF_FLAT;
+        c.a->surface.border = FALSE;
+        run(theme, name, sizes[i].name, &flat, &c);
+
+        c.im->data = NULL;
+        XDestroyImage(c.im);
+        g_free(c.scratch);
+        RrAppearanceFree(c.a);
+    }
+}
+
+static void bench_text(const gchar *theme, RrTheme *th,
+                       const RrInstance *inst)
+{
+    static const BenchTest tests[] = {
+        { "text_size", bench_text_size, sum_text_size },
+        { "text_paint", bench_paint, sum_pixmap }
+    };
+    BenchCase c;
+    guint i;
+
+    memset(&c, 0, sizeof(c));
+    c.inst = inst;
+    c.w = sizes[1].w;
+    c.h = th->label_height;
+    c.text = title_text;
+    c.a = appearance_at_size(th->a_focused_label, c.w, c.h);
+    /* the label is usually drawn on the title, so give it a background of
+       its own */
+    if (c.a->surface.grad == RR_SURFACE_PARENTREL) {
+        c.a->surface.grad = RR_SURFACE_SOLID;
+        if (!c.a->surface.primary)
+            c.a->surface.primary =
+                RrColorCopy(th->a_focused_title->surface.primary);
+    }
+    c.a->texture[0].data.text.string = c.text;
+
+    for (i = 0; i < G_N_ELEMENTS(tests); ++i)
+        run(theme, "a_focused_label", sizes[1].name, &tests[i], &c);
+
+    RrAppearanceFree(c.a);
+}
+
+static void bench_icons(const RrInstance *inst)
+{
+    static const BenchTest test = { "icon", bench_icon, sum_icon };
+    static const gint icon_sizes[] = { 16, 24, 32, 48, 64 };
+    RrPixel32 *data;
+    guint i;
+    gint x, y;
+
+    /* a picture with some detail, and some transparency */
+    data = g_new(RrPixel32, ICON_SIZE * ICON_SIZE);
+    for (y = 0; y < ICON_SIZE; ++y)
+        for (x = 0; x < ICON_SIZE; ++x)
+            data[y * ICON_SIZE + x] =
+                ((guint32)((x + y) * 255 / (2 * ICON_SIZE))
+                 << RrDefaultAlphaOffset) +
+                ((guint32)(x * 2) << RrDefaultRedOffset) +
+                ((guint32)(y * 2) << RrDefaultGreenOffset) +
+                ((guint32)((x ^ y) & 0xff) << RrDefaultBlueOffset);
+
+    for (i = 0; i < G_N_ELEMENTS(icon_sizes); ++i) {
+        BenchCase c;
+        gchar *size;
+
+        memset(&c, 0, sizeof(c));
+        c.inst = inst;
+        c.w = c.h = icon_sizes[i];
+        c.icon.width = c.icon.height = ICON_SIZE;
+        c.icon.alpha = 0xff;
+        c.icon.data = data;
+        c.target = g_new0(RrPixel32, c.w * c.h);
+        RECT_SET(c.area, 0, 0, c.w, c.h);
+
+        size = g_strdup_printf("%dx%d", c.w, c.h);
+        run("-", "icon", size, &test, &c);
+        g_free(size);
+        g_free(c.target);
+    }
+    g_free(data);
+}
+
+static void bench_theme(const gchar *dir, const gchar *name,
+                        const RrInstance *inst)
+{
+    static const struct {
+        const gchar *name;
+        gsize offset;
+    } looks[] = {
+        { "a_focused_title", G_STRUCT_OFFSET(RrTheme, a_focused_title) },
+        { "a_focused_handle", G_STRUCT_OFFSET(RrTheme, a_focused_handle) },
+        { "a_menu", G_STRUCT_OFFSET(RrTheme, a_menu) },
+        { "a_menu_selected", G_STRUCT_OFFSET(RrTheme, a_menu_selected) },
+        { "osd_hilite_bg", G_STRUCT_OFFSET(RrTheme, osd_hilite_bg) }
+    };
+    RrTheme *th;
+    gchar *path;
+    guint i;
+
+    /* RrThemeNew looks for a theme in the data directories, unless it is
+       given an absolute path */
+    if (g_path_is_absolute(dir))
+        path = g_build_filename(dir, name, NULL);
+    else {
+        gchar *cwd = g_get_current_dir();
+        path = g_build_filename(cwd, dir, name, NULL);
+        g_free(cwd);
+    }
+    th = RrThemeNew(inst, path, FALSE, NULL, NULL, NULL, NULL, NULL, NULL);
+    g_free(path);
+    if (!th) {
+        g_printerr("Unable to load the theme '%s'\n", name);
+        return;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(looks); ++i)
+        bench_surface(name, looks[i].name,
+                      G_STRUCT_MEMBER(RrAppearance*, th, looks[i].offset),
+                      inst);
+    bench_text(name, th, inst);
+
+    RrThemeFree(th);
+}
+
+static gint cmp_str(gconstpointer a, gconstpointer b)
+{
+    return strcmp(*(gchar*const*)a, *(gchar*const*)b);
+}
+
+gint main(gint argc, gchar **argv)
+{
+    Display *display;
+    RrInstance *inst;
+    gint i;
+
+    i = 1;
+    if (argc > 2 && !strcmp(argv[1], "-n")) {
+        calls = atoi(argv[2]);
+        i = 3;
+    }
+    if (i >= argc || calls <= 0) {
+        g_printerr("usage: %s [-n CALLS] THEMEDIR [THEME...]\n", argv[0]);
+        return 1;
+    }
+
+    if (!(display = XOpenDisplay(NULL))) {
+        g_printerr("couldn't connect to X server\n");
+        return 1;
+    }
+    inst = RrInstanceNew(display, DefaultScreen(display));
+    times = g_new(gdouble, calls);
+
+    if (i + 1 < argc) {
+        /* the themes named */
+        gint j;
+        for (j = i + 1; j < argc; ++j)
+            bench_theme(argv[i], argv[j], inst);
+    } else {
+        /* every theme in the directory */
+        GPtrArray *names = g_ptr_array_new();
+        GDir *dir;
+        const gchar *n;
+        guint j;
+
+        if ((dir = g_dir_open(argv[i], 0, NULL))) {
+            while ((n = g_dir_read_name(dir))) {
+                gchar *rc = g_build_filename(argv[i], n, "openbox-3",
+                                             "themerc", NULL);
+                if (g_file_test(rc, G_FILE_TEST_IS_REGULAR))
+                    g_ptr_array_add(names, g_strdup(n));
+                g_free(rc);
+            }
+            g_dir_close(dir);
+        }
+        g_ptr_array_sort(names, cmp_str);
+        for (j = 0; j < names->len; ++j) {
+            bench_theme(argv[i], g_ptr_array_index(names, j), inst);
+            g_free(g_ptr_array_index(names, j));
+        }
+        g_ptr_array_free(names, TRUE);
+    }
+    bench_icons(inst);
+
+    g_free(times);
+    RrInstanceFree(inst);
+    XCloseDisplay(display);
+    return 0;
+}
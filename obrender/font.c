@@ -31,6 +31,125 @@
 #include <stdlib.h>
 #include <locale.h>
 
+typedef struct _RrFontLayout
+{
+    /* these identify the layout */
+    gchar *string;
+    gint width; /* in pango units, or -1 for no limit */
+    PangoEllipsizeMode ellipsize;
+    gboolean flow;
+    gint shortcut_pos; /* -1 when there is no shortcut to underline */
+
+    PangoLayout *layout;
+    PangoRectangle extents; /* the logical extents, in pango units */
+    PangoRectangle pixel_extents; /* the logical extents, in pixels */
+    GList *lru_link; /* the layout's link in the font's lru queue */
+} RrFontLayout;
+
+static guint font_layout_hash(gconstpointer key)
+{
+    const RrFontLayout *l = key;
+
+    return g_str_hash(l->string) ^ (guint)l->width ^
+        ((guint)l->ellipsize << 24) ^ ((guint)l->flow << 28) ^
+        ((guint)l->shortcut_pos << 12);
+}
+
+static gboolean font_layout_equal(gconstpointer a, gconstpointer b)
+{
+    const RrFontLayout *la = a, *lb = b;
+
+    return la->width == lb->width && la->ellipsize == lb->ellipsize &&
+        la->flow == lb->flow && la->shortcut_pos == lb->shortcut_pos &&
+        !strcmp(la->string, lb->string);
+}
+
+static void font_layout_free(RrFont *f, RrFontLayout *l)
+{
+    g_hash_table_remove(f->layouts, l);
+    g_queue_delete_link(f->layouts_lru, l->lru_link);
+    g_object_unref(l->layout);
+    g_free(l->string);
+    g_slice_free(RrFontLayout, l);
+}
+
+static void font_layouts_clear(RrFont *f)
+{
+    RrFontLayout *l;
+
+    while ((l = g_queue_peek_head(f->layouts_lru)))
+        font_layout_free(f, l);
+}
+
+/*! Find a layout for the string with the given settings, shaping the text
+  only if it has not been laid out that way recently */
+static RrFontLayout* font_layout(const RrFont *f, const gchar *str,
+                                 gint width, PangoEllipsizeMode ell,
+                                 gboolean flow, gint shortcut_pos)
+{
+    RrFontLayout key, *l;
+    RrFont *font = (RrFont*)f; /* the cache is not part of the font's state */
+
+    key.string = (gchar*)str;
+    key.width = width;
+    key.ellipsize = ell;
+    key.flow = flow;
+    key.shortcut_pos = shortcut_pos;
+
+    if ((l = g_hash_table_lookup(font->layouts, &key))) {
+        /* it was used again, move it to the front */
+        g_queue_unlink(font->layouts_lru, l->lru_link);
+        g_queue_push_head_link(font->layouts_lru, l->lru_link);
+        return l;
+    }
+
+    /* make room by dropping the least recently used layout */
+    if (g_queue_get_length(font->layouts_lru) >= RR_FONT_LAYOUT_CACHE_SIZE)
+        font_layout_free(font, g_queue_peek_tail(font->layouts_lru));
+
+    l = g_slice_new(RrFontLayout);
+    l->string = g_strdup(str);
+    l->width = width;
+    l->ellipsize = ell;
+    l->flow = flow;
+    l->shortcut_pos = shortcut_pos;
+
+    l->layout = pango_layout_new(f->inst->pango);
+    pango_layout_set_font_description(l->layout, f->font_desc);
+    pango_layout_set_wrap(l->layout, PANGO_WRAP_WORD_CHAR);
+    pango_layout_set_text(l->layout, str, -1);
+    pango_layout_set_width(l->layout, width);
+    pango_layout_set_ellipsize(l->layout, ell);
+    pango_layout_set_single_paragraph_mode(l->layout, !flow);
+
+    if (shortcut_pos >= 0) {
+        PangoAttrList *attrlist;
+        PangoAttribute *underline;
+        const gchar *s = str + shortcut_pos;
+
+        underline = pango_attr_underline_new(PANGO_UNDERLINE_SINGLE);
+        underline->start_index = shortcut_pos;
+        underline->end_index = shortcut_pos + (g_utf8_next_char(s) - s);
+
+        attrlist = pango_attr_list_new();
+        /* the underline is owned by the attrlist */
+        pango_attr_list_insert(attrlist, underline);
+        /* the attributes are owned by the layout */
+        pango_layout_set_attributes(l->layout, attrlist);
+        pango_attr_list_unref(attrlist);
+    }
+
+    /* this is where the text gets shaped, so only do it once */
+    pango_layout_get_extents(l->layout, NULL, &l->extents);
+    pango_layout_get_pixel_extents(l->layout, NULL, &l->pixel_extents);
+
+    g_queue_push_head(font->layouts_lru, l);
+    l->lru_link = g_queue_peek_head_link(font->layouts_lru);
+    g_hash_table_insert(font->layouts, l, l);
+
+    return l;
+}
+
 static void measure_font(const RrInstance *inst, RrFont *f)
 {
     PangoFontMetrics *metrics;
@@ -66,7 +185,8 @@ void RrFontDescriptionFromString(RrFont *font, gchar *description)
     desc = pango_font_description_from_string(description);
     pango_font_description_merge(font->font_desc, desc, TRUE);
     pango_font_description_free(desc);
-    pango_layout_set_font_description(font->layout, font->font_desc);
+    /* the layouts were made with the old font */
+    font_layouts_clear(font);
 }
 
 RrFont *RrFontOpen(const RrInstance *inst, const gchar *name, gint size,
@@ -75,23 +195,13 @@ RrFont *RrFontOpen(const RrInstance *inst, const gchar *name, gint size,
     RrFont *out;
     PangoWeight pweight;
     PangoStyle pstyle;
-    PangoAttrList *attrlist;
 
     out = g_slice_new(RrFont);
     out->inst = inst;
     out->ref = 1;
     out->font_desc = pango_font_description_new();
-    out->layout = pango_layout_new(inst->pango);
-    out->shortcut_underline = pango_attr_underline_new(PANGO_UNDERLINE_SINGLE);
-    out->shortcut_underline->start_index = 0;
-    out->shortcut_underline->end_index = 0;
-
-    attrlist = pango_attr_list_new();
-    /* shortcut_underline is owned by the attrlist */
-    pango_attr_list_insert(attrlist, out->shortcut_underline);
-    /* the attributes are owned by the layout */
-    pango_layout_set_attributes(out->layout, attrlist);
-    pango_attr_list_unref(attrlist);
+    out->layouts = g_hash_table_new(font_layout_hash, font_layout_equal);
+    out->layouts_lru = g_queue_new();
 
     switch (weight) {
     case RR_FONTWEIGHT_LIGHT:     pweight = PANGO_WEIGHT_LIGHT;     break;
@@ -118,10 +228,6 @@ RrFont *RrFontOpen(const RrInstance *inst, const gchar *name, gint size,
     else
         pango_font_description_set_size(out->font_desc, size * PANGO_SCALE);
 
-    /* setup the layout */
-    pango_layout_set_font_description(out->layout, out->font_desc);
-    pango_layout_set_wrap(out->layout, PANGO_WRAP_WORD_CHAR);
-
     /* get the ascent and descent */
     measure_font(inst, out);
 
@@ -143,7 +249,9 @@ void RrFontClose(RrFont *f)
 {
     if (f) {
         if (--f->ref < 1) {
-            g_object_unref(f->layout);
+            font_layouts_clear(f);
+            g_hash_table_unref(f->layouts);
+            g_queue_free(f->layouts_lru);
             pango_font_description_free(f->font_desc);
             g_slice_free(RrFont, f);
         }
@@ -154,24 +262,19 @@ static void font_measure_full(const RrFont *f, const gchar *str,
                               gint *x, gint *y, gint shadow_x, gint shadow_y,
                               gboolean flow, gint maxwidth)
 {
+    RrFontLayout *l;
     PangoRectangle rect;
 
-    pango_layout_set_text(f->layout, str, -1);
-    if (flow) {
-        pango_layout_set_single_paragraph_mode(f->layout, FALSE);
-        pango_layout_set_width(f->layout, maxwidth * PANGO_SCALE);
-        pango_layout_set_ellipsize(f->layout, PANGO_ELLIPSIZE_NONE);
-    }
-    else {
+    if (flow)
+        l = font_layout(f, str, maxwidth * PANGO_SCALE, PANGO_ELLIPSIZE_NONE,
+                        TRUE, -1);
+    else
         /* single line mode */
-        pango_layout_set_single_paragraph_mode(f->layout, TRUE);
-        pango_layout_set_width(f->layout, -1);
-        pango_layout_set_ellipsize(f->layout, PANGO_ELLIPSIZE_MIDDLE);
-    }
+        l = font_layout(f, str, -1, PANGO_ELLIPSIZE_MIDDLE, FALSE, -1);
 
     /* pango_layout_get_pixel_extents lies! this is the right way to get the
        size of the text's area */
-    pango_layout_get_extents(f->layout, NULL, &rect);
+    rect = l->extents;
 #if PANGO_VERSION_MAJOR > 1 || \
     (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
     /* pass the logical rect as the ink rect, this is on purpose so we get the
@@ -232,9 +335,8 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
     gint x,y,w;
     XftColor c;
     gint mw;
-    PangoRectangle rect;
-    PangoAttrList *attrlist;
     PangoEllipsizeMode ell;
+    RrFontLayout *l;
 
     g_assert(!t->flow || t->maxwidth > 0);
 
@@ -275,15 +377,9 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
         }
     }
 
-    pango_layout_set_text(t->font->layout, t->string, -1);
-    pango_layout_set_width(t->font->layout, w * PANGO_SCALE);
-    pango_layout_set_ellipsize(t->font->layout, ell);
-    pango_layout_set_single_paragraph_mode(t->font->layout, !t->flow);
-
-    /* * * end of setting up the layout * * */
-
-    pango_layout_get_pixel_extents(t->font->layout, NULL, &rect);
-    mw = rect.width;
+    l = font_layout(t->font, t->string, w * PANGO_SCALE, ell, t->flow,
+                    (t->shortcut ? t->shortcut_pos : -1));
+    mw = l->pixel_extents.width;
 
     /* pango_layout_set_alignment doesn't work with
        pango_xft_render_layout_line */
@@ -324,15 +420,15 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
                 (d, &c,
 #if PANGO_VERSION_MAJOR > 1 || \
     (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
-                 pango_layout_get_line_readonly(t->font->layout, 0),
+                 pango_layout_get_line_readonly(l->layout, 0),
 #else
-                 pango_layout_get_line(t->font->layout, 0),
+                 pango_layout_get_line(l->layout, 0),
 #endif
                  (x + t->shadow_offset_x) * PANGO_SCALE,
                  (y + t->shadow_offset_y) * PANGO_SCALE);
         }
         else {
-            pango_xft_render_layout(d, &c, t->font->layout,
+            pango_xft_render_layout(d, &c, l->layout,
                                     (x + t->shadow_offset_x) * PANGO_SCALE,
                                     (y + t->shadow_offset_y) * PANGO_SCALE);
         }
@@ -344,22 +440,6 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
     c.color.alpha = 0xff | 0xff << 8; /* fully opaque text */
     c.pixel = t->color->pixel;
 
-    if (t->shortcut) {
-        const gchar *s = t->string + t->shortcut_pos;
-
-        t->font->shortcut_underline->start_index = t->shortcut_pos;
-        t->font->shortcut_underline->end_index = t->shortcut_pos +
-            (g_utf8_next_char(s) - s);
-
-        /* the attributes are owned by the layout.
-           re-add the attributes to the layout after changing the
-           start and end index */
-        attrlist = pango_layout_get_attributes(t->font->layout);
-        pango_attr_list_ref(attrlist);
-        pango_layout_set_attributes(t->font->layout, attrlist);
-        pango_attr_list_unref(attrlist);
-    }
-
     /* layout_line() uses y to specify the baseline
        The line doesn't need to be freed, it's a part of the layout */
     if (!t->flow) {
@@ -367,28 +447,16 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
             (d, &c,
 #if PANGO_VERSION_MAJOR > 1 || \
     (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
-             pango_layout_get_line_readonly(t->font->layout, 0),
+             pango_layout_get_line_readonly(l->layout, 0),
 #else
-             pango_layout_get_line(t->font->layout, 0),
+             pango_layout_get_line(l->layout, 0),
 #endif
              x * PANGO_SCALE,
              y * PANGO_SCALE);
     }
     else {
-        pango_xft_render_layout(d, &c, t->font->layout,
+        pango_xft_render_layout(d, &c, l->layout,
                                 x * PANGO_SCALE,
                                 y * PANGO_SCALE);
     }
-
-    if (t->shortcut) {
-        t->font->shortcut_underline->start_index = 0;
-        t->font->shortcut_underline->end_index = 0;
-        /* the attributes are owned by the layout.
-           re-add the attributes to the layout after changing the
-           start and end index */
-        attrlist = pango_layout_get_attributes(t->font->layout);
-        pango_attr_list_ref(attrlist);
-        pango_layout_set_attributes(t->font->layout, attrlist);
-        pango_attr_list_unref(attrlist);
-    }
 }
@@ -23,12 +23,19 @@
 #include "geom.h"
 #include <pango/pango.h>
 
+/*! The most layouts kept for each font */
+#define RR_FONT_LAYOUT_CACHE_SIZE 64
+
 struct _RrFont {
     const RrInstance *inst;
     gint ref;
     PangoFontDescription *font_desc;
-    PangoLayout *layout; /*!< Used for measuring and rendering strings */
-    PangoAttribute *shortcut_underline; /*< For underlining the shortcut key */
+    /*! Layouts for measuring and rendering strings, which are kept around so
+      that drawing the same string again does not need to shape it again.
+      Maps an RrFontLayout to itself. */
+    GHashTable *layouts;
+    /*! The layouts, from most to least recently used */
+    GQueue *layouts_lru;
     gint ascent; /*!< The font's ascent in pango-units */
     gint descent; /*!< The font's descent in pango-units */
 };
@@ -30,12 +30,20 @@
 #endif
 
 #include <math.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 
 #define FRACTION        12
 #define FLOOR(i)        ((i) & (~0UL << FRACTION))
 #define AVERAGE(a, b)   (((((a) ^ (b)) & 0xfefefefeL) >> 1) + ((a) & (b)))
 
+/*! The number of bytes in an RrImagePic's data */
+#define PIC_BYTES(p) ((gsize)(p)->width * (gsize)(p)->height * \
+                      sizeof(RrPixel32))
+
 /************************************************************************
  RrImagePic functions.
 
@@ -56,26 +64,35 @@
 */
 static void RrImagePicInit(RrImagePic *pic, gint w, gint h, RrPixel32 *data)
 {
-    gint i;
+    pic->width = w;
+    pic->height = h;
+    pic->data = data;
+    RrImagePicDigest(pic, FALSE);
+}
 
+/*! Set up an RrImagePic, like RrImagePicInit, from picture data in the
+  ARGB32 format used by _NET_WM_ICON.  The data is converted in place.
+*/
+static void RrImagePicInitARGB(RrImagePic *pic, gint w, gint h,
+                               RrPixel32 *data)
+{
     pic->width = w;
     pic->height = h;
     pic->data = data;
-    pic->sum = 0;
-    for (i = w*h; i > 0; --i)
-        pic->sum += *(data++);
+    RrImagePicDigest(pic, TRUE);
 }
 
-/*! Create a new RrImagePic from some picture data.
-  This makes a duplicate of the data.
+/*! Create a new RrImagePic from a temporary one.
+  This makes a duplicate of the data, but keeps the sum and hash that were
+  already found for it.
 */
-static RrImagePic* RrImagePicNew(gint w, gint h, RrPixel32 *data)
+static RrImagePic* RrImagePicDup(const RrImagePic *src)
 {
     RrImagePic *pic;
-    const gsize data_size = (gsize)w * (gsize)h * sizeof(RrPixel32);
 
     pic = g_slice_new(RrImagePic);
-    RrImagePicInit(pic, w, h, g_memdup2(data, data_size));
+    *pic = *src;
+    pic->data = g_memdup2(src->data, PIC_BYTES(src));
     return pic;
 }
 
@@ -91,6 +108,30 @@ static void RrImagePicFree(RrImagePic *pic)
     }
 }
 
+/*! A block of picture data which pictures that haven't been converted yet
+  point into.  It is freed once none of them need it any more. */
+typedef struct _RrImageRaw {
+    gint ref;
+    RrPixel32 *data;
+} RrImageRaw;
+
+/*! A picture which hasn't been converted yet, because it hasn't been needed
+  for drawing yet.  It is not in the image cache. */
+typedef struct _RrImageLazyPic {
+    gint width, height;
+    /*! The picture's ARGB32 data, inside raw->data */
+    RrPixel32 *data;
+    RrImageRaw *raw;
+} RrImageLazyPic;
+
+static void RrImageRawUnref(RrImageRaw *raw)
+{
+    if (raw && --raw->ref == 0) {
+        g_free(raw->data);
+        g_slice_free(RrImageRaw, raw);
+    }
+}
+
 /************************************************************************
  RrImageSet functions.
 
@@ -109,6 +150,17 @@ static void RrImagePicFree(RrImagePic *pic)
 **************************************************************************/
 
 
+/*! Remove a picture in an RrImageSet from the cache, before it is freed. */
+static void RrImageCacheForgetPic(RrImageCache *cache, RrImagePic *pic)
+{
+    g_hash_table_remove(cache->pic_table, pic);
+    cache->stats.bytes -= PIC_BYTES(pic);
+    if (pic->lru) {
+        g_queue_delete_link(&cache->resized, pic->lru);
+        pic->lru = NULL;
+    }
+}
+
 /*! Free an RrImageSet and the stuff inside it.
   This should only occur when there are no more RrImages pointing to the set.
 */
@@ -131,15 +183,18 @@ static void RrImageSetFree(RrImageSet *self)
            be keys in the cache to RrImageSet objects, so remove them from
            the cache's pic_table as well. */
         for (i = 0; i < self->n_original; ++i) {
-            g_hash_table_remove(self->cache->pic_table, self->original[i]);
+            RrImageCacheForgetPic(self->cache, self->original[i]);
             RrImagePicFree(self->original[i]);
         }
         g_free(self->original);
         for (i = 0; i < self->n_resized; ++i) {
-            g_hash_table_remove(self->cache->pic_table, self->resized[i]);
+            RrImageCacheForgetPic(self->cache, self->resized[i]);
             RrImagePicFree(self->resized[i]);
         }
         g_free(self->resized);
+        for (i = 0; i < self->n_lazy; ++i)
+            RrImageRawUnref(self->lazy[i].raw);
+        g_free(self->lazy);
 
         g_slice_free(RrImageSet, self);
     }
@@ -171,7 +226,7 @@ static void RrImageSetRemovePictureAt(RrImageSet *self, gint i,
     g_assert(i >= 0 && i < *len);
 
     /* remove the picture data as a key in the cache */
-    g_hash_table_remove(self->cache->pic_table, (*list)[i]);
+    RrImageCacheForgetPic(self->cache, (*list)[i]);
 
     /* free the picture being removed */
     RrImagePicFree((*list)[i]);
@@ -199,6 +254,9 @@ static void RrImageSetAddPicture(RrImageSet *self, RrImagePic *pic,
     g_assert(pic->width > 0 && pic->height > 0);
     g_assert(g_hash_table_lookup(self->cache->pic_table, pic) == NULL);
 
+    /* make room for the picture under the cache's memory limit */
+    RrImageCacheTrim(self->cache, PIC_BYTES(pic));
+
     /* choose which list in the RrImageSet to add the new picture to. */
     if (original) {
         /* remove the resized picture of the same size if one exists */
@@ -227,6 +285,16 @@ static void RrImageSetAddPicture(RrImageSet *self, RrImagePic *pic,
 
     /* add the picture as a key to point to this image in the cache */
     g_hash_table_insert(self->cache->pic_table, (*list)[0], self);
+    self->cache->stats.bytes += PIC_BYTES(pic);
+
+    /* resized pictures can be thrown away when the cache is full, starting
+       with the one that was used the longest time ago */
+    if (original)
+        pic->lru = NULL;
+    else {
+        g_queue_push_head(&self->cache->resized, pic);
+        pic->lru = self->cache->resized.head;
+    }
 
 /*
 #ifdef DEBUG
@@ -238,12 +306,28 @@ static void RrImageSetAddPicture(RrImageSet *self, RrImagePic *pic,
 */
 }
 
+/*! Returns TRUE if the RrImageSet has an original picture, converted or not,
+  of the given size. */
+static gboolean RrImageSetHasSize(RrImageSet *self, gint w, gint h)
+{
+    gint i;
+
+    for (i = 0; i < self->n_original; ++i)
+        if (self->original[i]->width == w && self->original[i]->height == h)
+            return TRUE;
+    for (i = 0; i < self->n_lazy; ++i)
+        if (self->lazy[i].width == w && self->lazy[i].height == h)
+            return TRUE;
+    return FALSE;
+}
+
 /*! Merges two image sets, destroying one, and returning the other. */
 RrImageSet* RrImageSetMergeSets(RrImageSet *b, RrImageSet *a)
 {
     gint a_i, b_i, merged_i;
     RrImagePic **original, **resized;
-    gint n_original, n_resized, tmp;
+    RrImageLazyPic *lazy;
+    gint n_original, n_resized, n_lazy, tmp;
     GSList *it;
 
     gint max_resized;
@@ -297,18 +381,32 @@ RrImageSet* RrImageSetMergeSets(RrImageSet *b, RrImageSet *a)
     */
     tmp = a_i;
     for (; a_i < a->n_resized; ++a_i) {
-        g_hash_table_remove(a->cache->pic_table, a->resized[a_i]);
+        RrImageCacheForgetPic(a->cache, a->resized[a_i]);
         RrImagePicFree(a->resized[a_i]);
     }
     a->n_resized = tmp;
 
     tmp = b_i;
     for (; b_i < b->n_resized; ++b_i) {
-        g_hash_table_remove(a->cache->pic_table, b->resized[b_i]);
+        RrImageCacheForgetPic(a->cache, b->resized[b_i]);
         RrImagePicFree(b->resized[b_i]);
     }
     b->n_resized = tmp;
 
+    /* keep the pictures waiting to be converted, except where both sets
+       have a picture of the same size.  the sets hold the same image, so
+       those would be the same picture twice. */
+    n_lazy = 0;
+    lazy = g_new(RrImageLazyPic, a->n_lazy + b->n_lazy);
+    for (a_i = 0; a_i < a->n_lazy; ++a_i)
+        lazy[n_lazy++] = a->lazy[a_i];
+    for (b_i = 0; b_i < b->n_lazy; ++b_i) {
+        if (RrImageSetHasSize(a, b->lazy[b_i].width, b->lazy[b_i].height))
+            RrImageRawUnref(b->lazy[b_i].raw);
+        else
+            lazy[n_lazy++] = b->lazy[b_i];
+    }
+
     /* we will use the a object as the merge destination, so things in b will
        be moving.
 
@@ -341,19 +439,25 @@ RrImageSet* RrImageSetMergeSets(RrImageSet *b, RrImageSet *a)
     a->names = g_slist_concat(a->names, b->names);
     b->names = NULL;
 
-    a->n_original = a->n_resized = 0;
+    a->n_original = a->n_resized = a->n_lazy = 0;
     g_free(a->original);
     g_free(a->resized);
+    g_free(a->lazy);
     a->original = a->resized = NULL;
-    b->n_original = b->n_resized = 0;
+    a->lazy = NULL;
+    b->n_original = b->n_resized = b->n_lazy = 0;
     g_free(b->original);
     g_free(b->resized);
+    g_free(b->lazy);
     b->original = b->resized = NULL;
+    b->lazy = NULL;
 
     a->n_original = n_original;
     a->original = original;
     a->n_resized = n_resized;
     a->resized = resized;
+    a->n_lazy = n_lazy;
+    a->lazy = lazy;
 
     RrImageSetFree(b);
 
@@ -414,40 +518,68 @@ void RrImageSetDestroyFunc(RrImage *self, RrImageDestroyFunc func,
     self->destroy_data = data;
 }
 
-void RrImageAddFromData(RrImage *self, RrPixel32 *data, gint w, gint h)
+/*! Look for a picture in the cache, and count how it went.
+  @return The RrImageSet holding the picture, or NULL if it's not in the
+    cache.
+*/
+static RrImageSet* RrImageCacheFind(RrImageCache *cache, const RrImagePic *pic)
 {
-    RrImagePic pic, *ppic;
     RrImageSet *set;
 
-    g_return_if_fail(self != NULL);
-    g_return_if_fail(data != NULL);
-    g_return_if_fail(w > 0 && h > 0);
+    set = g_hash_table_lookup(cache->pic_table, pic);
 
-    RrImagePicInit(&pic, w, h, data);
-    set = g_hash_table_lookup(self->set->cache->pic_table, &pic);
+    ++cache->stats.lookups;
+    if (set) {
+        ++cache->stats.hits;
+        cache->stats.bytes_saved += PIC_BYTES(pic);
+    }
+    else
+        ++cache->stats.misses;
+    return set;
+}
+
+void RrImageCacheTrim(RrImageCache *self, gsize bytes)
+{
+    if (!self->max_bytes) return;
+
+    while (self->stats.bytes + bytes > self->max_bytes &&
+           !g_queue_is_empty(&self->resized))
+    {
+        RrImagePic *pic;
+        RrImageSet *set;
+        gint i;
+
+        pic = g_queue_peek_tail(&self->resized);
+        set = g_hash_table_lookup(self->pic_table, pic);
+        g_assert(set != NULL);
+
+        for (i = 0; i < set->n_resized && set->resized[i] != pic; ++i);
+        g_assert(i < set->n_resized);
+        RrImageSetRemovePictureAt(set, i, FALSE);
+
+        ++self->stats.evictions;
+    }
+}
+
+static void RrImageAddPic(RrImage *self, const RrImagePic *pic)
+{
+    RrImageSet *set;
+
+    set = RrImageCacheFind(self->set->cache, pic);
     if (set)
         self->set = RrImageSetMergeSets(self->set, set);
-    else {
-        ppic = RrImagePicNew(w, h, data);
-        RrImageSetAddPicture(self->set, ppic, TRUE);
-    }
+    else
+        RrImageSetAddPicture(self->set, RrImagePicDup(pic), TRUE);
 }
 
-RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
-                            gint w, gint h)
+static RrImage* RrImageNewFromPic(RrImageCache *cache, const RrImagePic *pic)
 {
-    RrImagePic pic, *ppic;
     RrImage *self;
     RrImageSet *set;
 
-    g_return_val_if_fail(cache != NULL, NULL);
-    g_return_val_if_fail(data != NULL, NULL);
-    g_return_val_if_fail(w > 0 && h > 0, NULL);
-
     /* finds a picture in the cache, if it is already in there, and use the
        RrImageSet the picture lives in. */
-    RrImagePicInit(&pic, w, h, data);
-    set = g_hash_table_lookup(cache->pic_table, &pic);
+    set = RrImageCacheFind(cache, pic);
     if (set) {
         self = set->images->data; /* just grab any RrImage from the list */
         RrImageRef(self);
@@ -464,8 +596,95 @@ RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
     self->set->cache = cache;
     self->set->images = g_slist_append(self->set->images, self);
 
-    ppic = RrImagePicNew(w, h, data);
-    RrImageSetAddPicture(self->set, ppic, TRUE);
+    RrImageSetAddPicture(self->set, RrImagePicDup(pic), TRUE);
+
+    return self;
+}
+
+void RrImageAddFromData(RrImage *self, RrPixel32 *data, gint w, gint h)
+{
+    RrImagePic pic;
+
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(data != NULL);
+    g_return_if_fail(w > 0 && h > 0);
+
+    RrImagePicInit(&pic, w, h, data);
+    RrImageAddPic(self, &pic);
+}
+
+void RrImageAddFromARGB(RrImage *self, RrPixel32 *data, gint w, gint h)
+{
+    RrImagePic pic;
+
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(data != NULL);
+    g_return_if_fail(w > 0 && h > 0);
+
+    RrImagePicInitARGB(&pic, w, h, data);
+    RrImageAddPic(self, &pic);
+}
+
+RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
+                            gint w, gint h)
+{
+    RrImagePic pic;
+
+    g_return_val_if_fail(cache != NULL, NULL);
+    g_return_val_if_fail(data != NULL, NULL);
+    g_return_val_if_fail(w > 0 && h > 0, NULL);
+
+    RrImagePicInit(&pic, w, h, data);
+    return RrImageNewFromPic(cache, &pic);
+}
+
+RrImage* RrImageNewFromARGB(RrImageCache *cache, RrPixel32 *data,
+                            gint w, gint h)
+{
+    RrImagePic pic;
+
+    g_return_val_if_fail(cache != NULL, NULL);
+    g_return_val_if_fail(data != NULL, NULL);
+    g_return_val_if_fail(w > 0 && h > 0, NULL);
+
+    RrImagePicInitARGB(&pic, w, h, data);
+    return RrImageNewFromPic(cache, &pic);
+}
+
+RrImage* RrImageNewFromARGBIndex(RrImageCache *cache, RrPixel32 *data,
+                                 const RrImagePicIndex *index, gint n)
+{
+    RrImage *self;
+    RrImageRaw *raw;
+    gint i;
+
+    g_return_val_if_fail(cache != NULL, NULL);
+    g_return_val_if_fail(data != NULL, NULL);
+    g_return_val_if_fail(index != NULL && n > 0, NULL);
+
+    /* each picture holds a reference on the data until it is converted */
+    raw = g_slice_new(RrImageRaw);
+    raw->ref = n;
+    raw->data = data;
+
+    /* nothing has been looked at, so there is nothing to find in the cache
+       yet.  the pictures are put in the cache as they are converted. */
+    self = g_slice_new0(RrImage);
+    self->ref = 1;
+    self->set = g_slice_new0(RrImageSet);
+    self->set->cache = cache;
+    self->set->images = g_slist_append(self->set->images, self);
+
+    self->set->n_lazy = n;
+    self->set->lazy = g_new(RrImageLazyPic, n);
+    for (i = 0; i < n; ++i) {
+        g_assert(index[i].width > 0 && index[i].height > 0);
+
+        self->set->lazy[i].width = index[i].width;
+        self->set->lazy[i].height = index[i].height;
+        self->set->lazy[i].data = data + index[i].offset;
+        self->set->lazy[i].raw = raw;
+    }
 
     return self;
 }
@@ -647,6 +866,224 @@ RsvgLoader* LoadWithRsvg(gchar *path,
 }
 #endif  /* USE_LIBRSVG */
 
+/*! Identifies a file in the disk cache of loaded images */
+#define DISK_CACHE_MAGIC 0x4f424931 /* OBI1 */
+/*! Don't save images bigger than this in the disk cache */
+#define DISK_CACHE_MAX_SIZE 1024
+/*! Files in the disk cache which are not used for this long are removed */
+#define DISK_CACHE_MAX_AGE (30 * 24 * 60 * 60)
+/*! The disk cache is kept below this many bytes, by removing the files that
+  were used the longest time ago */
+#define DISK_CACHE_MAX_BYTES (32 * 1024 * 1024)
+
+typedef struct _DiskCacheEntry {
+    gchar *file;
+    time_t mtime;
+    goffset size;
+} DiskCacheEntry;
+
+/*! Returns the file in the disk cache for an image file.  It is named from
+  the file's path, size and modification time, so that it is not found
+  again once the image file is changed. */
+static gchar* DiskCacheFile(const gchar *path, const struct stat *st)
+{
+    gchar *key, *sum, *file;
+
+    key = g_strdup_printf("%s\n%ld\n%ld",
+                          path, (glong)st->st_mtime, (glong)st->st_size);
+    sum = g_compute_checksum_for_string(G_CHECKSUM_MD5, key, -1);
+    file = g_build_filename(g_get_user_cache_dir(),
+                            "openbox", "icons", sum, NULL);
+    g_free(sum);
+    g_free(key);
+    return file;
+}
+
+/*! Read an image from the disk cache, as it was loaded from the file before.
+  The file holds the magic number, the width and the height, then the
+  picture's RrPixel32 data. */
+static gboolean DiskCacheRead(const gchar *file, RrPixel32 **data,
+                              gint *w, gint *h)
+{
+    gchar *contents;
+    gsize len;
+    guint32 head[3];
+
+    if (!g_file_get_contents(file, &contents, &len, NULL))
+        return FALSE;
+
+    if (len < sizeof(head)) {
+        g_free(contents);
+        return FALSE;
+    }
+    memcpy(head, contents, sizeof(head));
+    if (head[0] != DISK_CACHE_MAGIC ||
+        head[1] == 0 || head[1] > DISK_CACHE_MAX_SIZE ||
+        head[2] == 0 || head[2] > DISK_CACHE_MAX_SIZE ||
+        len != sizeof(head) + head[1] * head[2] * sizeof(RrPixel32))
+    {
+        g_free(contents);
+        return FALSE;
+    }
+
+    *w = head[1];
+    *h = head[2];
+    /* mark it as used, so the sweep keeps the files that are in use */
+    g_utime(file, NULL);
+    /* move the picture to the front to use the buffer for it */
+    memmove(contents, contents + sizeof(head), len - sizeof(head));
+    *data = (RrPixel32*)contents;
+    return TRUE;
+}
+
+static gint DiskCacheEntryCompare(gconstpointer a, gconstpointer b)
+{
+    const DiskCacheEntry *ea = a, *eb = b;
+    return ea->mtime < eb->mtime ? -1 : (ea->mtime > eb->mtime ? 1 : 0);
+}
+
+/*! Remove the files in the disk cache which have not been used in a long
+  time, and then the oldest ones until it fits in DISK_CACHE_MAX_BYTES. */
+static void DiskCacheSweep(const gchar *dir)
+{
+    GDir *d;
+    const gchar *name;
+    GArray *entries;
+    DiskCacheEntry e;
+    struct stat st;
+    time_t now;
+    guint64 total;
+    guint i;
+
+    if (!(d = g_dir_open(dir, 0, NULL)))
+        return;
+
+    now = time(NULL);
+    total = 0;
+    entries = g_array_new(FALSE, FALSE, sizeof(DiskCacheEntry));
+    while ((name = g_dir_read_name(d))) {
+        e.file = g_build_filename(dir, name, NULL);
+        if (g_stat(e.file, &st) != 0 || !S_ISREG(st.st_mode))
+            g_free(e.file);
+        else if (now - st.st_mtime > DISK_CACHE_MAX_AGE) {
+            g_unlink(e.file);
+            g_free(e.file);
+        }
+        else {
+            e.mtime = st.st_mtime;
+            e.size = st.st_size;
+            total += st.st_size;
+            g_array_append_val(entries, e);
+        }
+    }
+    g_dir_close(d);
+
+    g_array_sort(entries, DiskCacheEntryCompare);
+    for (i = 0; i < entries->len; ++i) {
+        DiskCacheEntry *it = &g_array_index(entries, DiskCacheEntry, i);
+        if (total > DISK_CACHE_MAX_BYTES) {
+            g_unlink(it->file);
+            total -= it->size;
+        }
+        g_free(it->file);
+    }
+    g_array_free(entries, TRUE);
+}
+
+/*! Save an image in the disk cache, so it does not have to be decoded again
+  the next time the file is loaded.  The first time in each run, the cache
+  is swept so that it does not grow forever. */
+static void DiskCacheWrite(const gchar *file, const RrPixel32 *data,
+                           gint w, gint h)
+{
+    static gsize swept = 0;
+    gchar *dir, *contents;
+    gsize len;
+    guint32 head[3];
+
+    if (w > DISK_CACHE_MAX_SIZE || h > DISK_CACHE_MAX_SIZE)
+        return;
+
+    dir = g_path_get_dirname(file);
+    /* this can be called from many loading threads at once */
+    if (g_once_init_enter(&swept)) {
+        DiskCacheSweep(dir);
+        g_once_init_leave(&swept, 1);
+    }
+    if (g_mkdir_with_parents(dir, 0700) == 0) {
+        head[0] = DISK_CACHE_MAGIC;
+        head[1] = w;
+        head[2] = h;
+        len = sizeof(head) + (gsize)w * h * sizeof(RrPixel32);
+        contents = g_malloc(len);
+        memcpy(contents, head, sizeof(head));
+        memcpy(contents + sizeof(head), data, len - sizeof(head));
+        /* this is written to a temporary file and renamed, so a reader
+           never sees half of it */
+        g_file_set_contents(file, contents, len, NULL);
+        g_free(contents);
+    }
+    g_free(dir);
+}
+
+#if defined(USE_IMLIB2)
+/* Imlib2 keeps its state in global variables, so only one thread can use it
+   at a time */
+G_LOCK_DEFINE_STATIC(imlib);
+#endif
+
+/*! Load an image file into a newly allocated buffer.  This is safe to call
+  from any thread, as it does not touch the image cache. */
+static gboolean LoadImageFile(const gchar *path, RrPixel32 **data,
+                              gint *w, gint *h)
+{
+    struct stat st;
+    gchar *cache_file;
+    gboolean loaded;
+
+    if (g_stat(path, &st) != 0)
+        return FALSE;
+
+    cache_file = DiskCacheFile(path, &st);
+    if (DiskCacheRead(cache_file, data, w, h)) {
+        g_free(cache_file);
+        return TRUE;
+    }
+
+    loaded = FALSE;
+#if defined(USE_LIBRSVG)
+    if (!loaded) {
+        RsvgLoader *rsvg_loader;
+
+        if ((rsvg_loader = LoadWithRsvg((gchar*)path, data, w, h))) {
+            /* keep the data that the loader made */
+            rsvg_loader->pixel_data = NULL;
+            DestroyRsvgLoader(rsvg_loader);
+            loaded = TRUE;
+        }
+    }
+#endif
+#if defined(USE_IMLIB2)
+    if (!loaded) {
+        ImlibLoader *imlib_loader;
+
+        G_LOCK(imlib);
+        if ((imlib_loader = LoadWithImlib((gchar*)path, data, w, h))) {
+            /* the data belongs to imlib, so copy it */
+            *data = g_memdup2(*data, (gsize)*w * *h * sizeof(RrPixel32));
+            DestroyImlibLoader(imlib_loader);
+            loaded = TRUE;
+        }
+        G_UNLOCK(imlib);
+    }
+#endif
+
+    if (loaded)
+        DiskCacheWrite(cache_file, *data, *w, *h);
+    g_free(cache_file);
+    return loaded;
+}
+
 RrImage* RrImageNewFromName(RrImageCache *cache, const gchar *name)
 {
     RrImage *self;
@@ -654,51 +1091,27 @@ RrImage* RrImageNewFromName(RrImageCache *cache, const gchar *name)
     gint w, h;
     RrPixel32 *data;
     gchar *path;
-    gboolean loaded;
-
-#if defined(USE_IMLIB2)
-    ImlibLoader *imlib_loader = NULL;
-#endif
-#if defined(USE_LIBRSVG)
-    RsvgLoader *rsvg_loader = NULL;
-#endif
 
     g_return_val_if_fail(cache != NULL, NULL);
     g_return_val_if_fail(name != NULL, NULL);
 
     set = g_hash_table_lookup(cache->name_table, name);
+    ++cache->stats.lookups;
     if (set) {
+        ++cache->stats.hits;
         self = set->images->data;
         RrImageRef(self);
         return self;
     }
+    ++cache->stats.misses;
 
-    /* XXX find the path via freedesktop icon spec (use obt) ! */
+    /* the name is the file's path.  icon names are found in icon themes by
+       the caller, with obt */
     path = g_strdup(name);
 
-    loaded = FALSE;
-#if defined(USE_LIBRSVG)
-    if (!loaded) {
-        rsvg_loader = LoadWithRsvg(path, &data, &w, &h);
-        loaded = !!rsvg_loader;
-    }
-#endif
-#if defined(USE_IMLIB2)
-    if (!loaded) {
-        imlib_loader = LoadWithImlib(path, &data, &w, &h);
-        loaded = !!imlib_loader;
-    }
-#endif
-
-    if (!loaded) {
+    if (!LoadImageFile(path, &data, &w, &h)) {
         g_message("Cannot load image \"%s\" from file \"%s\"", name, path);
         g_free(path);
-#if defined(USE_LIBRSVG)
-        DestroyRsvgLoader(rsvg_loader);
-#endif
-#if defined(USE_IMLIB2)
-        DestroyImlibLoader(imlib_loader);
-#endif
         return NULL;
     }
 
@@ -717,12 +1130,130 @@ RrImage* RrImageNewFromName(RrImageCache *cache, const gchar *name)
     self = RrImageNewFromData(cache, data, w, h);
     RrImageSetAddName(self->set, name);
 
-#if defined(USE_LIBRSVG)
-    DestroyRsvgLoader(rsvg_loader);
-#endif
-#if defined(USE_IMLIB2)
-    DestroyImlibLoader(imlib_loader);
+    g_free(data);
+
+    return self;
+}
+
+/*! The most image files to load at the same time */
+#define LOAD_THREADS 2
+
+/*! An image file being loaded in the background */
+typedef struct _RrImageLoad {
+    /*! The image to put the picture in, which this holds a reference on */
+    RrImage *image;
+    gchar *name;
+    gchar *path;
+
+    /* filled in by the loading thread */
+    gboolean loaded;
+    RrPixel32 *data;
+    gint w, h;
+} RrImageLoad;
+
+static GThreadPool *load_pool = NULL;
+
+/*! Back in the main thread, put the loaded picture into the image */
+static gboolean LoadImageDone(gpointer data)
+{
+    RrImageLoad *load = data;
+    RrImage *self = load->image;
+    RrImageCache *cache = self->set->cache;
+
+    if (load->loaded) {
+        RrImagePic pic;
+
+        /* this may merge the image with another one in the cache that has
+           the same picture */
+        RrImagePicInit(&pic, load->w, load->h, load->data);
+        RrImageAddPic(self, &pic);
+        g_free(load->data);
+
+        if (cache->loaded_func)
+            cache->loaded_func(self, TRUE, cache->loaded_data);
+    }
+    else {
+        GSList *it;
+
+        g_message("Cannot load image \"%s\" from file \"%s\"",
+                  load->name, load->path);
+
+        /* forget the name so that the file will be tried again the next
+           time it is asked for */
+        for (it = self->set->names; it; it = g_slist_next(it))
+            if (!strcmp(it->data, load->name)) {
+                g_hash_table_remove(cache->name_table, it->data);
+                g_free(it->data);
+                self->set->names = g_slist_delete_link(self->set->names, it);
+                break;
+            }
+
+        if (cache->loaded_func)
+            cache->loaded_func(self, FALSE, cache->loaded_data);
+    }
+
+    RrImageUnref(self);
+    RrImageCacheUnref(cache);
+    g_free(load->name);
+    g_free(load->path);
+    g_slice_free(RrImageLoad, load);
+    return FALSE; /* only once */
+}
+
+/*! Runs in a loading thread */
+static void LoadImageThread(gpointer data, gpointer user_data)
+{
+    RrImageLoad *load = data;
+
+    load->loaded = LoadImageFile(load->path, &load->data, &load->w, &load->h);
+    g_idle_add(LoadImageDone, load);
+}
+
+RrImage* RrImageNewFromNameAsync(RrImageCache *cache, const gchar *name)
+{
+    RrImage *self;
+    RrImageSet *set;
+    RrImageLoad *load;
+
+    g_return_val_if_fail(cache != NULL, NULL);
+    g_return_val_if_fail(name != NULL, NULL);
+
+    /* this is found if the file is loaded, or still loading */
+    set = g_hash_table_lookup(cache->name_table, name);
+    ++cache->stats.lookups;
+    if (set) {
+        ++cache->stats.hits;
+        self = set->images->data;
+        RrImageRef(self);
+        return self;
+    }
+    ++cache->stats.misses;
+
+    if (!load_pool) {
+#if !GLIB_CHECK_VERSION(2, 32, 0)
+        if (!g_thread_supported()) g_thread_init(NULL);
 #endif
+        load_pool = g_thread_pool_new(LoadImageThread, NULL, LOAD_THREADS,
+                                      FALSE, NULL);
+    }
+
+    /* make an empty image for the picture to go in, with the name, so that
+       it isn't loaded twice */
+    self = g_slice_new0(RrImage);
+    self->ref = 1;
+    self->set = g_slice_new0(RrImageSet);
+    self->set->cache = cache;
+    self->set->images = g_slist_append(self->set->images, self);
+    RrImageSetAddName(self->set, name);
+
+    /* keep the image, and its cache, until the picture is put in it */
+    load = g_slice_new0(RrImageLoad);
+    load->image = self;
+    RrImageRef(self);
+    RrImageCacheRef(cache);
+    load->name = g_strdup(name);
+    load->path = g_strdup(name);
+    g_thread_pool_push(load_pool, load, NULL);
 
     return self;
 }
@@ -937,6 +1468,120 @@ void RrImageDrawRGBA(RrPixel32 *target, RrTextureRGBA *rgba,
   pictures will be resized and used (and stored in the RrImage as a "resized"
   picture).
  */
+/*! Returns TRUE if a picture can be drawn in the area without resizing it.
+  Only the larger of w or h has to be right, cuz we maintain aspect ratios.
+*/
+#define PIC_FITS_AREA(w, h, area) \
+    (((w) >= (h) && (w) == (area)->width) || \
+     ((w) <= (h) && (h) == (area)->height))
+
+/*! Our size difference metric, for how far a picture is from the size of the
+  area it is going to be drawn in */
+static gint RrImagePicSizeDiff(gint w, gint h, const RrRect *area)
+{
+    gint wdiff, hdiff;
+
+    wdiff = w - area->width;
+    if (wdiff < 0) wdiff *= 2; /* prefer scaling down than up */
+    hdiff = h - area->height;
+    if (hdiff < 0) hdiff *= 2; /* prefer scaling down than up */
+    return (wdiff * wdiff) + (hdiff * hdiff);
+}
+
+/*! Converts a picture that was waiting to be needed, and makes it an
+  original.
+  @return The RrImageSet, which may have been merged with another one
+*/
+static RrImageSet* RrImageSetConvertLazy(RrImageSet *self, gint i)
+{
+    RrImageLazyPic lazy;
+    RrImagePic pic;
+    RrImageSet *cache_set;
+
+    /* take it out of the list of pictures waiting */
+    lazy = self->lazy[i];
+    for (i = i+1; i < self->n_lazy; ++i)
+        self->lazy[i-1] = self->lazy[i];
+    --self->n_lazy;
+    self->lazy = g_renew(RrImageLazyPic, self->lazy, self->n_lazy);
+
+    RrImagePicInitARGB(&pic, lazy.width, lazy.height, lazy.data);
+
+    /* is it already in the cache ? */
+    cache_set = RrImageCacheFind(self->cache, &pic);
+    if (cache_set)
+        /* then the two sets are the same image, and the picture is in the
+           merged set already */
+        self = RrImageSetMergeSets(self, cache_set);
+    else
+        RrImageSetAddPicture(self, RrImagePicDup(&pic), TRUE);
+
+    RrImageRawUnref(lazy.raw);
+    return self;
+}
+
+/*! If one of the pictures waiting to be converted is the best one to draw in
+  the area, then convert it, so that it can be chosen from the originals.
+  @return The RrImageSet, which may have been merged with another one
+*/
+static RrImageSet* RrImageSetConvertForArea(RrImageSet *self,
+                                            const RrRect *area)
+{
+    gint i, diff, min_diff, min_i, min_aspect_diff, min_aspect_i;
+    gdouble aspect;
+
+    if (!self->n_lazy) return self;
+
+    /* an original, or resized picture, of the right size is used first */
+    for (i = 0; i < self->n_original; ++i)
+        if (PIC_FITS_AREA(self->original[i]->width,
+                          self->original[i]->height, area))
+            return self;
+    for (i = 0; i < self->n_lazy; ++i)
+        if (PIC_FITS_AREA(self->lazy[i].width, self->lazy[i].height, area))
+            return RrImageSetConvertLazy(self, i);
+    for (i = 0; i < self->n_resized; ++i)
+        if (PIC_FITS_AREA(self->resized[i]->width,
+                          self->resized[i]->height, area))
+            return self;
+
+    /* otherwise, the closest size is resized, preferring the ones with the
+       same aspect ratio.  look through the originals and then the pictures
+       waiting, as if they were one list. */
+    min_diff = min_aspect_diff = -1;
+    min_i = min_aspect_i = -1;
+    aspect = ((gdouble)area->width) / area->height;
+    for (i = 0; i < self->n_original + self->n_lazy; ++i) {
+        gint w, h;
+
+        if (i < self->n_original) {
+            w = self->original[i]->width;
+            h = self->original[i]->height;
+        } else {
+            w = self->lazy[i - self->n_original].width;
+            h = self->lazy[i - self->n_original].height;
+        }
+
+        diff = RrImagePicSizeDiff(w, h, area);
+        if (min_diff < 0 || diff < min_diff) {
+            min_diff = diff;
+            min_i = i;
+        }
+        if (ABS(aspect - ((gdouble)w) / h) < 0.0000001 &&
+            (min_aspect_diff < 0 || diff < min_aspect_diff))
+        {
+            min_aspect_diff = diff;
+            min_aspect_i = i;
+        }
+    }
+    if (min_aspect_i >= 0)
+        min_i = min_aspect_i;
+
+    if (min_i >= self->n_original)
+        self = RrImageSetConvertLazy(self, min_i - self->n_original);
+    return self;
+}
+
 void RrImageDrawImage(RrPixel32 *target, RrTextureImage *img,
                       gint target_w, gint target_h,
                       RrRect *area)
@@ -952,6 +1597,13 @@ void RrImageDrawImage(RrPixel32 *target, RrTextureImage *img,
     pic = NULL;
     free_pic = FALSE;
 
+    /* convert the picture to draw from, if it hasn't been needed before */
+    set = RrImageSetConvertForArea(set, area);
+
+    /* the picture is still being loaded */
+    if (!set->n_original)
+        return;
+
     /* is there an original of this size? (only the larger of
        w or h has to be right cuz we maintain aspect ratios) */
     for (i = 0; i < set->n_original; ++i)
@@ -984,6 +1636,10 @@ void RrImageDrawImage(RrPixel32 *target, RrTextureImage *img,
             /* and move the selected one to the top of the list */
             set->resized[0] = saved;
 
+            /* and to the top of the cache's list too */
+            g_queue_unlink(&set->cache->resized, saved->lru);
+            g_queue_push_head_link(&set->cache->resized, saved->lru);
+
             pic = set->resized[0];
             break;
         }
@@ -1059,10 +1715,6 @@ void RrImageDrawImage(RrPixel32 *target, RrTextureImage *img,
         }
     }
 
-    /* The RrImageSet may have changed if we merged it with another, so the
-       RrImage object needs to be updated to use the new merged RrImageSet. */
-    self->set = set;
-
     g_assert(pic != NULL);
 
     DrawRGBA(target, target_w, target_h,
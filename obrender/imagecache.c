@@ -32,9 +32,17 @@ RrImageCache* RrImageCacheNew(gint max_resized_saved)
     self = g_slice_new(RrImageCache);
     self->ref = 1;
     self->max_resized_saved = max_resized_saved;
+    self->max_bytes = 0;
+    g_queue_init(&self->resized);
     self->pic_table = g_hash_table_new((GHashFunc)RrImagePicHash,
                                        (GEqualFunc)RrImagePicEqual);
     self->name_table = g_hash_table_new(g_str_hash, g_str_equal);
+    self->stats.lookups = self->stats.hits = self->stats.misses = 0;
+    self->stats.evictions = 0;
+    self->stats.bytes = 0;
+    self->stats.bytes_saved = 0;
+    self->loaded_func = NULL;
+    self->loaded_data = NULL;
     return self;
 }
 
@@ -54,10 +62,31 @@ void RrImageCacheUnref(RrImageCache *self)
         g_hash_table_destroy(self->name_table);
         self->name_table = NULL;
 
+        g_assert(g_queue_is_empty(&self->resized));
+        g_assert(self->stats.bytes == 0);
+
         g_slice_free(RrImageCache, self);
     }
 }
 
+void RrImageCacheSetMaxBytes(RrImageCache *self, gsize max_bytes)
+{
+    self->max_bytes = max_bytes;
+    RrImageCacheTrim(self, 0);
+}
+
+void RrImageCacheSetLoadedFunc(RrImageCache *self, RrImageLoadedFunc func,
+                               gpointer data)
+{
+    self->loaded_func = func;
+    self->loaded_data = data;
+}
+
+void RrImageCacheGetStats(const RrImageCache *self, RrImageCacheStats *stats)
+{
+    *stats = self->stats;
+}
+
 #define hashsize(n) ((RrPixel32)1<<(n))
 #define hashmask(n) (hashsize(n)-1)
 #define rot(x,k) (((x)<<(k)) | ((x)>>(32-(k))))
@@ -83,58 +112,81 @@ void RrImageCacheUnref(RrImageCache *self)
   c ^= b; c -= rot(b,24); \
 }
 
+/*! This is some arbitrary initial value for the hashing function.  It's
+  constant so that you get the same result from the same data each time.
+*/
+#define HASH_INITVAL 0xf00d
+
+/* takes the next pixel, converting it from ARGB32 if needed, and adds it
+   to the sum */
+#if RrDefaultAlphaOffset == 24 && RrDefaultRedOffset == 16 && \
+    RrDefaultGreenOffset == 8 && RrDefaultBlueOffset == 0
+/* RrPixel32s are laid out the same as ARGB32 data, so there is nothing to
+   convert */
+#define DIGEST_PIXEL(p, argb, sum) ((sum) += (p), (p))
+#else
+#define ARGB_TO_PIXEL(v) \
+    (((RrPixel32)(((v) >> 24) & 0xff) << RrDefaultAlphaOffset) + \
+     ((RrPixel32)(((v) >> 16) & 0xff) << RrDefaultRedOffset)   + \
+     ((RrPixel32)(((v) >>  8) & 0xff) << RrDefaultGreenOffset) + \
+     ((RrPixel32)(((v) >>  0) & 0xff) << RrDefaultBlueOffset))
+#define DIGEST_PIXEL(p, argb, sum) \
+    ((argb) ? ((p) = ARGB_TO_PIXEL(p)) : 0, (sum) += (p), (p))
+#endif
+
 /* This is a fast, reversable hash function called "lookup3", found here:
    http://burtleburtle.net/bob/c/lookup3.c, by Bob Jenkins
 
    This hashing algorithm is "reversible", that is, not cryptographically
    secure at all.  But we don't care about that, we just want something to
    tell when images are the same or different relatively quickly.
+
+   The pixels are converted and summed as they are hashed, so the picture's
+   data is only read through once.
 */
-guint32 hashword(const guint32 *key, gint length, guint32 initval)
+void RrImagePicDigest(RrImagePic *p, gboolean argb)
 {
-    guint32 a,b,c;
+    RrPixel32 *key = p->data;
+    gint length = p->width * p->height;
+    guint32 a, b, c;
+    gint sum = 0;
 
     /* Set up the internal state */
-    a = b = c = 0xdeadbeef + (((guint32)length)<<2) + initval;
+    a = b = c = 0xdeadbeef + (((guint32)length)<<2) + HASH_INITVAL;
 
-    /* handle most of the key */
     while (length > 3)
     {
-        a += key[0];
-        b += key[1];
-        c += key[2];
+        a += DIGEST_PIXEL(key[0], argb, sum);
+        b += DIGEST_PIXEL(key[1], argb, sum);
+        c += DIGEST_PIXEL(key[2], argb, sum);
         mix(a,b,c);
         length -= 3;
         key += 3;
     }
 
-    /* handle the last 3 guint32's */
+    /* handle the last 3 pixels */
     switch(length)      /* all the case statements fall through */
-    { 
-    case 3: c+=key[2];
-    case 2: b+=key[1];
-    case 1: a+=key[0];
+    {
+    case 3: c += DIGEST_PIXEL(key[2], argb, sum);
+    case 2: b += DIGEST_PIXEL(key[1], argb, sum);
+    case 1: a += DIGEST_PIXEL(key[0], argb, sum);
         final(a,b,c);
     case 0:             /* case 0: nothing left to add */
         break;
     }
-    /* report the result */
-    return c;
-}
 
-/*! This is some arbitrary initial value for the hashing function.  It's
-  constant so that you get the same result from the same data each time.
-*/
-#define HASH_INITVAL 0xf00d
+    p->sum = sum;
+    p->hash = c;
+}
 
 guint RrImagePicHash(const RrImagePic *p)
 {
-    return hashword(p->data, p->width * p->height, HASH_INITVAL);
+    return p->hash;
 }
 
 static gboolean RrImagePicEqual(const RrImagePic *p1,
                                 const RrImagePic *p2)
 {
     return p1->width == p2->width && p1->height == p2->height &&
-        p1->sum == p2->sum;
+        p1->hash == p2->hash && p1->sum == p2->sum;
 }
@@ -25,6 +25,17 @@ struct _RrImagePic;
 
 guint RrImagePicHash(const struct _RrImagePic *p);
 
+/*! Find the sum and hash of a picture's data, in a single pass over it.
+  @param argb If TRUE, the data is in the ARGB32 format used by _NET_WM_ICON,
+    and is converted to RrPixel32s in place in the same pass
+*/
+void RrImagePicDigest(struct _RrImagePic *p, gboolean argb);
+
+/*! Throw away the least recently used resized pictures in the cache, until
+  the given number of bytes can be added without going over its memory
+  limit. */
+void RrImageCacheTrim(struct _RrImageCache *self, gsize bytes);
+
 /*! Create a new image cache.  An image cache is basically a hash table to look
   up RrImages.  Each RrImage in the cache may contain one or more Pictures,
   that is one or more actual copies of image data at various sizes.  For eg,
@@ -45,6 +56,15 @@ struct _RrImageCache {
     */
     gint max_resized_saved;
 
+    /*! The most bytes of picture data to keep in the cache, or 0 for no
+      limit.  When this would be exceeded, the least recently used resized
+      picture, from any RrImage in the cache, is deleted. */
+    gsize max_bytes;
+
+    /*! Every resized picture in the cache, ordered from the most to the
+      least recently used.  The RrImagePic holds its own link in the list. */
+    GQueue resized;
+
     /*! A hash table of image sets in the cache that don't have a file name
       attached to them, with their key being a hash of the contents of the
       image. */
@@ -53,6 +73,13 @@ struct _RrImageCache {
     /*! Used to find out if an image file has already been loaded into an
       image set. Provides a quick file_name -> RrImageSet lookup. */
     GHashTable *name_table;
+
+    /*! How well the cache is sharing pictures between image sets */
+    RrImageCacheStats stats;
+
+    /*! Called when an image file loaded in the background is ready */
+    RrImageLoadedFunc loaded_func;
+    gpointer loaded_data;
 };
 
 #endif
@@ -240,6 +240,12 @@ struct _RrImagePic {
     /* The sum of all the pixels.  This is used to compare pictures if their
        hashes match. */
     gint sum;
+    /* The hash of the picture's data, found along with the sum so the data
+       is only read once */
+    guint hash;
+    /* The picture's place in its image cache's list of resized pictures,
+       from most to least recently used.  NULL for original pictures. */
+    GList *lru;
 };
 
 typedef void (*RrImageDestroyFunc)(RrImage *image, gpointer data);
@@ -285,6 +291,11 @@ struct _RrImageSet
       RrImage. */
     RrImagePic **resized;
     gint n_resized;
+    /*! Pictures which were given to the RrImageSet, but have not been needed
+      for drawing yet, so they have not been converted or added to the cache.
+      When one is needed, it is moved to the "originals". */
+    struct _RrImageLazyPic *lazy;
+    gint n_lazy;
 };
 
 struct _RrButton {
@@ -423,6 +434,35 @@ RrImageCache* RrImageCacheNew(gint max_resized_saved);
 void          RrImageCacheRef(RrImageCache *self);
 void          RrImageCacheUnref(RrImageCache *self);
 
+/*! Limit the memory used by the pictures in an image cache.  When adding a
+  picture would go over the limit, the least recently drawn resized pictures,
+  from any image in the cache, are thrown away to make room.  Original
+  pictures are never thrown away, so the limit can still be exceeded by them.
+  @param max_bytes The most bytes of picture data to keep, or 0 for no limit
+*/
+void RrImageCacheSetMaxBytes(RrImageCache *self, gsize max_bytes);
+
+/*! How well an image cache is sharing its pictures */
+typedef struct _RrImageCacheStats {
+    /*! How many times a picture, or an image file, was looked for in the
+      cache */
+    guint lookups;
+    /*! How many of those lookups found the picture already in the cache */
+    guint hits;
+    /*! How many of those lookups did not find the picture in the cache */
+    guint misses;
+    /*! How many resized pictures were thrown away to stay under the cache's
+      memory limit */
+    guint evictions;
+    /*! The bytes of picture data held in the cache right now */
+    gsize bytes;
+    /*! The bytes of picture data which were not copied into the cache,
+      because the picture was found in it already */
+    guint64 bytes_saved;
+} RrImageCacheStats;
+
+void RrImageCacheGetStats(const RrImageCache *self, RrImageCacheStats *stats);
+
 /*! Create a new image, or return one from the cache that matches.
   @param cache The image cache.
   @param old The current RrImage, which the new image should be added to.
@@ -435,6 +475,26 @@ void          RrImageCacheUnref(RrImageCache *self);
 */
 RrImage* RrImageNewFromName(RrImageCache *cache, const gchar *name);
 
+/*! Create a new image from a file, like RrImageNewFromName, but load the file
+  in a separate thread.  If the file is in the cache already, the image is
+  returned ready to draw.  Otherwise the image is empty, and draws nothing,
+  until the file is loaded, and then the image cache's loaded function is
+  called with it.  If the file can't be loaded, the image stays empty, and
+  the loaded function is told so that the image can be let go of.
+  @param cache The image cache.
+  @param name The name of the icon to be loaded off disk, or used in the cache
+*/
+RrImage* RrImageNewFromNameAsync(RrImageCache *cache, const gchar *name);
+
+typedef void (*RrImageLoadedFunc)(RrImage *image, gboolean loaded,
+                                  gpointer data);
+
+/*! Set the function to call when an image from RrImageNewFromNameAsync has
+  finished loading, so that whatever shows it can be drawn again.  @loaded
+  is FALSE if the file could not be loaded and the image will stay empty. */
+void RrImageCacheSetLoadedFunc(RrImageCache *self, RrImageLoadedFunc func,
+                               gpointer data);
+
 /*! Create a new image, or return one from the cache that matches.
   @param cache The image cache.
   @param data The image data in RGBA32 format.  There should be @w * @h many
@@ -456,6 +516,38 @@ RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
 */
 void RrImageAddFromData(RrImage *image, RrPixel32 *data, gint w, gint h);
 
+/*! Like RrImageNewFromData, but the data is in the ARGB32 format used by
+  _NET_WM_ICON.  The data is converted in place, in the same pass that
+  finds its hash for the cache.
+*/
+RrImage* RrImageNewFromARGB(RrImageCache *cache, RrPixel32 *data,
+                            gint w, gint h);
+
+/*! Like RrImageAddFromData, but the data is in the ARGB32 format used by
+  _NET_WM_ICON, and is converted in place. */
+void RrImageAddFromARGB(RrImage *image, RrPixel32 *data, gint w, gint h);
+
+/*! Where to find one size of a picture in a block of picture data */
+typedef struct _RrImagePicIndex {
+    gint width, height;
+    /*! The position of the picture's first pixel in the data */
+    gsize offset;
+} RrImagePicIndex;
+
+/*! Create a new image from several sizes of a picture, all in one block of
+  data in the ARGB32 format used by _NET_WM_ICON.  None of the sizes are
+  converted or copied here.  Each is converted the first time it is the
+  best size for drawing the image, so sizes which are never drawn never
+  cost more than the data they came in.
+  @param cache The image cache.
+  @param data The picture data.  The image takes ownership of this, and
+    frees it with g_free().
+  @param index Where each size of the picture is found in the data.
+  @param n The number of sizes in the index.
+*/
+RrImage* RrImageNewFromARGBIndex(RrImageCache *cache, RrPixel32 *data,
+                                 const RrImagePicIndex *index, gint n);
+
 void RrImageRef(RrImage *im);
 void RrImageUnref(RrImage *im);
 
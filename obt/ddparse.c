@@ -24,6 +24,10 @@
 #ifdef HAVE_STDIO_H
 #include <stdio.h>
 #endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#include <glib/gstdio.h>
 
 typedef struct _ObtDDParse ObtDDParse;
 
@@ -31,7 +35,7 @@ typedef struct _ObtDDParse ObtDDParse;
    key
    Return TRUE if it is added to the hash table, and FALSE if not.
 */
-typedef gboolean (*ObtDDParseValueFunc)(gchar *key, const gchar *val,
+typedef gboolean (*ObtDDParseValueFunc)(const gchar *key, const gchar *val,
                                         ObtDDParse *parse, gboolean *error);
 
 
@@ -45,20 +49,26 @@ enum {
 };
 
 struct _ObtDDParse {
-    gchar *filename;
+    const gchar *filename;
     gulong lineno;
     gulong flags;
     ObtDDParseGroup *group;
     /* the key is a group name, the value is a ObtDDParseGroup */
     GHashTable *group_hash;
+    /* the name the first group in the file must have */
+    const gchar *first_group;
+    /* parses the keys in groups that are found, other than the first one */
+    ObtDDParseValueFunc group_value_func;
+    /* warn about keys that the group's value_func does not know */
+    gboolean warn_unknown;
 };
 
 struct _ObtDDParseGroup {
-    gchar *name;
+    const gchar *name; /* interned */
     gboolean seen;
     ObtDDParseValueFunc value_func;
-    /* the key is a string (a key inside the group in the .desktop).
-       the value is an ObtDDParseValue */
+    /* the key is an interned string (a key inside the group in the
+       .desktop).  the value is an ObtDDParseValue */
     GHashTable *key_hash;
 };
 
@@ -99,21 +109,21 @@ static void parse_value_free(ObtDDParseValue *v)
     g_slice_free(ObtDDParseValue, v);
 }
 
-static ObtDDParseGroup* parse_group_new(gchar *name, ObtDDParseValueFunc f)
+static ObtDDParseGroup* parse_group_new(const gchar *name,
+                                        ObtDDParseValueFunc f)
 {
     ObtDDParseGroup *g = g_slice_new(ObtDDParseGroup);
-    g->name = name;
+    g->name = g_intern_string(name);
     g->value_func = f;
     g->seen = FALSE;
     g->key_hash = g_hash_table_new_full(g_str_hash, g_str_equal,
-                                        g_free,
+                                        NULL,
                                         (GDestroyNotify)parse_value_free);
     return g;
 }
 
 static void parse_group_free(ObtDDParseGroup *g)
 {
-    g_free(g->name);
     g_hash_table_destroy(g->key_hash);
     g_slice_free(ObtDDParseGroup, g);
 }
@@ -318,100 +328,16 @@ static gfloat parse_value_numeric(const gchar *in,
     return out;
 }
 
-static gboolean parse_file_line(FILE *f, gchar **buf,
-                                gulong *size, gulong *read,
-                                ObtDDParse *parse, gboolean *error)
-{
-    const gulong BUFMUL = 80;
-    size_t ret;
-    gulong i, null;
-
-    if (*size == 0) {
-        g_assert(*read == 0);
-        *size = BUFMUL;
-        *buf = g_new(char, *size);
-    }
-
-    /* remove everything up to a null zero already in the buffer and shift
-       the rest to the front */
-    null = *size;
-    for (i = 0; i < *read; ++i) {
-        if (null < *size)
-            (*buf)[i-null-1] = (*buf)[i];
-        else if ((*buf)[i] == '\0')
-            null = i;
-    }
-    if (null < *size)
-        *read -= null + 1;
-
-    /* is there already a newline in the buffer? */
-    for (i = 0; i < *read; ++i)
-        if ((*buf)[i] == '\n') {
-            /* turn it into a null zero and done */
-            (*buf)[i] = '\0';
-            return TRUE;
-        }
-
-    /* we need to read some more to find a newline */
-    while (TRUE) {
-        gulong eol;
-        gchar *newread;
-
-        newread = *buf + *read;
-        ret = fread(newread, sizeof(char), *size-*read, f);
-        if (ret < *size - *read && !feof(f)) {
-            parse_error("Error reading", parse, error);
-            return FALSE;
-        }
-        *read += ret;
-
-        /* strip out null zeros in the input and look for an endofline */
-        null = 0;
-        eol = *size;
-        for (i = newread-*buf; i < *read; ++i) {
-            if (null > 0)
-                (*buf)[i] = (*buf)[i+null];
-            if ((*buf)[i] == '\0') {
-                ++null;
-                --(*read);
-                --i; /* try again */
-            }
-            else if ((*buf)[i] == '\n' && eol == *size) {
-                eol = i;
-                /* turn it into a null zero */
-                (*buf)[i] = '\0';
-            }
-        }
-
-        if (eol != *size)
-            /* found an endofline, done */
-            break;
-        else if (feof(f) && *read < *size) {
-            /* found the endoffile, done (if there is space) */
-            if (*read > 0) {
-                /* stick a null zero on if there is test on the last line */
-                (*buf)[(*read)++] = '\0';
-            }
-            break;
-        }
-        else {
-            /* read more */
-            size += BUFMUL;
-            *buf = g_renew(char, *buf, *size);
-        }
-    }
-    return *read > 0;
-}
-
-static void parse_group(const gchar *buf, gulong len,
+static void parse_group(gchar *buf, gulong len,
                         ObtDDParse *parse, gboolean *error)
 {
     ObtDDParseGroup *g;
     gchar *group;
     gulong i;
 
-    /* get the group name */
-    group = g_strndup(buf+1, len-2);
+    /* get the group name, in place in the line */
+    group = buf+1;
+    buf[len-1] = '\0';
     for (i = 0; i < len-2; ++i)
         if ((guchar)group[i] < 32 || (guchar)group[i] >= 127) {
             /* valid ASCII only */
@@ -424,37 +350,33 @@ static void parse_group(const gchar *buf, gulong len,
     g = g_hash_table_lookup(parse->group_hash, group);
     if (g && g->seen) {
         parse_error("Duplicate group found", parse, error);
-        g_free(group);
         return;
     }
-    /* if it's the first group, make sure it's named Desktop Entry */
-    else if (!parse->group && strcmp(group, "Desktop Entry") != 0)
+    /* if it's the first group, make sure it's named correctly */
+    else if (!parse->group && strcmp(group, parse->first_group) != 0)
     {
-        parse_error("Incorrect group found, "
-                    "expected [Desktop Entry]",
-                    parse, error);
-        g_free(group);
+        gchar *m = g_strdup_printf("Incorrect group found, expected [%s]",
+                                   parse->first_group);
+        parse_error(m, parse, error);
+        g_free(m);
         return;
     }
     else {
         if (!g) {
-            g = parse_group_new(group, NULL);
-            g_hash_table_insert(parse->group_hash, g->name, g);
+            g = parse_group_new(group, parse->group_value_func);
+            g_hash_table_insert(parse->group_hash, (gpointer)g->name, g);
         }
-        else
-            g_free(group);
 
         g->seen = TRUE;
         parse->group = g;
-        g_print("Found group %s\n", g->name);
     }
 }
 
-static void parse_key_value(const gchar *buf, gulong len,
+static void parse_key_value(gchar *buf, gulong len,
                             ObtDDParse *parse, gboolean *error)
 {
     gulong i, keyend, valstart, eq;
-    char *key;
+    const gchar *key;
 
     /* find the end of the key */
     for (i = 0; i < len; ++i)
@@ -471,6 +393,9 @@ static void parse_key_value(const gchar *buf, gulong len,
         parse_error("Empty key", parse, error);
         return;
     }
+    /* keys for a locale, like Name[de], are not used */
+    if (keyend < len && buf[keyend] == '[')
+        return;
     /* find the = character */
     for (i = keyend; i < len; ++i) {
         if (buf[i] == '=') {
@@ -497,46 +422,122 @@ static void parse_key_value(const gchar *buf, gulong len,
         return;
     }
 
-    key = g_strndup(buf, keyend);
+    /* end the key in place.  keys are from a small set of names, so they
+       are interned instead of copied for each file */
+    buf[keyend] = '\0';
+    key = g_intern_string(buf);
     if (g_hash_table_lookup(parse->group->key_hash, key)) {
         parse_error("Duplicate key found", parse, error);
-        g_free(key);
         return;
     }
-    g_print("Found key/value %s=%s.\n", key, buf+valstart);
-    if (parse->group->value_func)
-        if (!parse->group->value_func(key, buf+valstart, parse, error)) {
+    /* groups that nothing reads, such as a .desktop file's actions, are
+       skipped without a word */
+    if (parse->group->value_func &&
+        !parse->group->value_func(key, buf+valstart, parse, error))
+    {
+        if (parse->warn_unknown)
             parse_error("Unknown key", parse, error);
-            g_free(key);
-        }
+    }
+}
+
+/*! Take the null zeros out of a file's contents, as they aren't valid in
+  it.  Returns the new length. */
+static gsize strip_nulls(gchar *buf, gsize len)
+{
+    gsize i, o;
+
+    for (i = o = 0; i < len; ++i)
+        if (buf[i] != '\0')
+            buf[o++] = buf[i];
+    return o;
+}
+
+static void parse_line(gchar *buf, gulong len,
+                       ObtDDParse *parse, gboolean *error)
+{
+    if (buf[0] == '#' || buf[0] == '\0')
+        ; /* ignore comment lines */
+    else if (buf[0] == '[' && buf[len-1] == ']')
+        parse_group(buf, len, parse, error);
+    else if (!parse->group)
+        /* just ignore keys outside of groups */
+        parse_error("Key found before group", parse, NULL);
+    else
+        /* ignore errors in key-value pairs and continue */
+        parse_key_value(buf, len, parse, NULL);
 }
 
-static gboolean parse_file(FILE *f, ObtDDParse *parse)
+/*! Parse a file's contents.  The lines are split apart in place, by making
+  each newline a null zero, so the buffer is changed.
+*/
+static gboolean parse_buffer(gchar *buf, gsize len, ObtDDParse *parse)
 {
-    gchar *buf = NULL;
-    gulong bytes = 0, read = 0;
+    gchar *p, *end, *last;
     gboolean error = FALSE;
 
-    while (!error && parse_file_line(f, &buf, &bytes, &read, parse, &error)) {
-        gulong len = strlen(buf);
-        if (buf[0] == '#' || buf[0] == '\0')
-            ; /* ignore comment lines */
-        else if (buf[0] == '[' && buf[len-1] == ']')
-            parse_group(buf, len, parse, &error);
-        else if (!parse->group)
-            /* just ignore keys outside of groups */
-            parse_error("Key found before group", parse, NULL);
-        else
-            /* ignore errors in key-value pairs and continue */
-            parse_key_value(buf, len, parse, NULL);
+    if (len == 0) return TRUE;
+
+    if (memchr(buf, '\0', len))
+        len = strip_nulls(buf, len);
+
+    last = NULL;
+    p = buf;
+    end = buf + len;
+    while (!error && p < end) {
+        gchar *line, *nl;
+        gulong n;
+
+        if ((nl = memchr(p, '\n', end - p))) {
+            *nl = '\0';
+            line = p;
+            n = nl - p;
+            p = nl + 1;
+        }
+        else {
+            /* there is no newline at the end of the last line to put the
+               null zero in */
+            line = last = g_strndup(p, end - p);
+            n = end - p;
+            p = end;
+        }
+
+        parse_line(line, n, parse, &error);
         ++parse->lineno;
     }
 
-    if (buf) g_free(buf);
+    g_free(last);
     return !error;
 }
 
-static gboolean parse_desktop_entry_value(gchar *key, const gchar *val,
+/*! Parse a file, mapping it into memory rather than reading it.
+  Returns FALSE if the file can't be opened or has errors.
+*/
+static gboolean parse_file(const gchar *path, ObtDDParse *parse)
+{
+    GMappedFile *map;
+    gboolean success;
+
+    /* the mapping is writable to split the lines in place, but the changes
+       are private, and never written to the file */
+    if (!(map = g_mapped_file_new(path, TRUE, NULL)))
+        return FALSE;
+
+    parse->filename = path;
+    parse->lineno = 1;
+    parse->flags = 0;
+    success = parse_buffer(g_mapped_file_get_contents(map),
+                           g_mapped_file_get_length(map),
+                           parse);
+#if GLIB_CHECK_VERSION(2, 22, 0)
+    g_mapped_file_unref(map);
+#else
+    g_mapped_file_free(map);
+#endif
+    return success;
+}
+
+static gboolean parse_desktop_entry_value(const gchar *key,
+                                          const gchar *val,
                                           ObtDDParse *parse, gboolean *error)
 {
     ObtDDParseValue v, *pv;
@@ -743,64 +744,115 @@ static gboolean parse_desktop_entry_value(gchar *key, const gchar *val,
 
     pv = g_slice_new(ObtDDParseValue);
     *pv = v;
-    g_hash_table_insert(parse->group->key_hash, key, pv);
+    g_hash_table_insert(parse->group->key_hash, (gpointer)key, pv);
     return TRUE;
 }
 
-GHashTable* obt_ddparse_file(const gchar *name, GSList *paths)
+static gboolean parse_icon_theme_value(const gchar *key,
+                                       const gchar *val,
+                                       ObtDDParse *parse, gboolean *error)
+{
+    ObtDDParseValue v, *pv;
+
+    /* the lists in an icon theme are separated by commas, so they are left
+       as strings to be split by the reader */
+    if (!strcmp(key, "Name") || !strcmp(key, "Comment"))
+        v.type = OBT_DDPARSE_LOCALESTRING;
+    else if (!strcmp(key, "Inherits") || !strcmp(key, "Directories") ||
+             !strcmp(key, "ScaledDirectories") || !strcmp(key, "Example"))
+        v.type = OBT_DDPARSE_STRING;
+    else if (!strcmp(key, "Hidden"))
+        v.type = OBT_DDPARSE_BOOLEAN;
+    else
+        return FALSE;
+
+    switch (v.type) {
+    case OBT_DDPARSE_STRING:
+    case OBT_DDPARSE_LOCALESTRING:
+        v.value.string = parse_value_string(val,
+                                            v.type == OBT_DDPARSE_LOCALESTRING,
+                                            FALSE, NULL, parse, error);
+        g_assert(v.value.string);
+        break;
+    case OBT_DDPARSE_BOOLEAN:
+        v.value.boolean = parse_value_boolean(val, parse, error);
+        break;
+    default:
+        g_assert_not_reached();
+    }
+
+    pv = g_slice_new(ObtDDParseValue);
+    *pv = v;
+    g_hash_table_insert(parse->group->key_hash, (gpointer)key, pv);
+    return TRUE;
+}
+
+static gboolean parse_icon_dir_value(const gchar *key, const gchar *val,
+                                     ObtDDParse *parse, gboolean *error)
+{
+    ObtDDParseValue v, *pv;
+
+    if (!strcmp(key, "Size") || !strcmp(key, "Scale") ||
+        !strcmp(key, "MinSize") || !strcmp(key, "MaxSize") ||
+        !strcmp(key, "Threshold"))
+    {
+        v.type = OBT_DDPARSE_NUMERIC;
+        v.value.numeric = parse_value_numeric(val, parse, error);
+    }
+    else if (!strcmp(key, "Type") || !strcmp(key, "Context")) {
+        v.type = OBT_DDPARSE_STRING;
+        v.value.string = parse_value_string(val, FALSE, FALSE, NULL,
+                                            parse, error);
+        g_assert(v.value.string);
+    }
+    else
+        return FALSE;
+
+    pv = g_slice_new(ObtDDParseValue);
+    *pv = v;
+    g_hash_table_insert(parse->group->key_hash, (gpointer)key, pv);
+    return TRUE;
+}
+
+/* Sets up a parse for a file with the given first group, and the function
+   to parse the values in that group */
+static void parse_init(ObtDDParse *parse, const gchar *first_group,
+                       ObtDDParseValueFunc first_value_func)
+{
+    ObtDDParseGroup *g;
+
+    parse->filename = NULL;
+    parse->lineno = 0;
+    parse->flags = 0;
+    parse->group = NULL;
+    parse->group_hash = g_hash_table_new_full(g_str_hash,
+                                              g_str_equal,
+                                              NULL,
+                                              (GDestroyNotify)parse_group_free);
+    parse->first_group = first_group;
+    parse->group_value_func = NULL;
+    parse->warn_unknown = TRUE;
+
+    g = parse_group_new(first_group, first_value_func);
+    g_hash_table_insert(parse->group_hash, (gpointer)g->name, g);
+}
+
+GHashTable* obt_ddparse_icon_theme_file(const gchar *name, GSList *paths)
 {
     ObtDDParse parse;
-    ObtDDParseGroup *desktop_entry;
     GSList *it;
-    FILE *f;
     gboolean success;
 
-    parse.filename = NULL;
-    parse.lineno = 0;
-    parse.group = NULL;
-    parse.group_hash = g_hash_table_new_full(g_str_hash,
-                                             g_str_equal,
-                                             NULL,
-                                             (GDestroyNotify)parse_group_free);
-
-    /* set up the groups (there's only one right now) */
-    desktop_entry = parse_group_new(g_strdup("Desktop Entry"),
-                                    parse_desktop_entry_value);
-    g_hash_table_insert(parse.group_hash, desktop_entry->name, desktop_entry);
+    parse_init(&parse, "Icon Theme", parse_icon_theme_value);
+    parse.group_value_func = parse_icon_dir_value;
+    parse.warn_unknown = FALSE;
 
+    /* the first index.theme found is the one used, as with the theme's
+       directories it is shadowing the rest */
     success = FALSE;
     for (it = paths; it && !success; it = g_slist_next(it)) {
         gchar *path = g_strdup_printf("%s/%s", (char*)it->data, name);
-        if ((f = fopen(path, "r"))) {
-            parse.filename = path;
-            parse.lineno = 1;
-            parse.flags = 0;
-            if ((success = parse_file(f, &parse))) {
-                /* check that required keys exist */
-
-                if (!(parse.flags & DE_TYPE)) {
-                    g_warning("Missing Type key in %s", path);
-                    success = FALSE;
-                }
-                if (!(parse.flags & DE_NAME)) {
-                    g_warning("Missing Name key in %s", path);
-                    success = FALSE;
-                }
-                if (parse.flags & DE_TYPE_APPLICATION &&
-                    !(parse.flags & DE_EXEC))
-                {
-                    g_warning("Missing Exec key for Application in %s",
-                              path);
-                    success = FALSE;
-                }
-                else if (parse.flags & DE_TYPE_LINK && !(parse.flags & DE_URL))
-                {
-                    g_warning("Missing URL key for Link in %s", path);
-                    success = FALSE;
-                }
-            }
-            fclose(f);
-        }
+        success = parse_file(path, &parse);
         g_free(path);
     }
     if (!success) {
@@ -810,6 +862,183 @@ GHashTable* obt_ddparse_file(const gchar *name, GSList *paths)
     return parse.group_hash;
 }
 
+/*! Check that the keys required for the type of desktop entry were found */
+static gboolean check_desktop_keys(ObtDDParse *parse)
+{
+    gboolean success = TRUE;
+
+    if (!(parse->flags & DE_TYPE)) {
+        g_warning("Missing Type key in %s", parse->filename);
+        success = FALSE;
+    }
+    if (!(parse->flags & DE_NAME)) {
+        g_warning("Missing Name key in %s", parse->filename);
+        success = FALSE;
+    }
+    if (parse->flags & DE_TYPE_APPLICATION && !(parse->flags & DE_EXEC)) {
+        g_warning("Missing Exec key for Application in %s", parse->filename);
+        success = FALSE;
+    }
+    else if (parse->flags & DE_TYPE_LINK && !(parse->flags & DE_URL)) {
+        g_warning("Missing URL key for Link in %s", parse->filename);
+        success = FALSE;
+    }
+    return success;
+}
+
+/*! Parse a single .desktop file, returning its groups or NULL if it can't
+  be used */
+static GHashTable* parse_desktop_file(const gchar *path)
+{
+    ObtDDParse parse;
+
+    parse_init(&parse, "Desktop Entry", parse_desktop_entry_value);
+    if (!parse_file(path, &parse) || !check_desktop_keys(&parse)) {
+        g_hash_table_destroy(parse.group_hash);
+        return NULL;
+    }
+    return parse.group_hash;
+}
+
+GHashTable* obt_ddparse_file(const gchar *name, GSList *paths)
+{
+    GSList *it;
+    GHashTable *groups;
+
+    groups = NULL;
+    for (it = paths; it && !groups; it = g_slist_next(it)) {
+        gchar *path = g_strdup_printf("%s/%s", (char*)it->data, name);
+        groups = parse_desktop_file(path);
+        g_free(path);
+    }
+    return groups;
+}
+
+/* below this many files, starting threads costs more than it saves */
+#define DIR_MIN_THREADED 64
+
+typedef struct _ObtDDParseDirEntry {
+    gchar *path;
+    const gchar *name; /* relative to the directory, points into path */
+    GHashTable *groups;
+} ObtDDParseDirEntry;
+
+/* a directory which was looked in already, so that symlinks to it, or to
+   one of its parents, don't make it be read again */
+typedef struct _ObtDDParseDirSeen {
+    dev_t dev;
+    ino_t ino;
+} ObtDDParseDirSeen;
+
+static void dir_collect(const gchar *path, gsize rootlen, GPtrArray *entries,
+                        GArray *seen)
+{
+    GDir *dir;
+    const gchar *n;
+    struct stat st;
+    ObtDDParseDirSeen s;
+    guint i;
+
+    if (g_stat(path, &st) != 0)
+        return;
+    for (i = 0; i < seen->len; ++i) {
+        ObtDDParseDirSeen *it = &g_array_index(seen, ObtDDParseDirSeen, i);
+        if (it->dev == st.st_dev && it->ino == st.st_ino)
+            return;
+    }
+    s.dev = st.st_dev;
+    s.ino = st.st_ino;
+    g_array_append_val(seen, s);
+
+    if (!(dir = g_dir_open(path, 0, NULL)))
+        return;
+
+    while ((n = g_dir_read_name(dir))) {
+        gchar *full = g_build_filename(path, n, NULL);
+
+        if (g_str_has_suffix(n, ".desktop")) {
+            ObtDDParseDirEntry *e = g_slice_new(ObtDDParseDirEntry);
+            e->path = full;
+            e->name = full + rootlen + 1;
+            e->groups = NULL;
+            g_ptr_array_add(entries, e);
+        }
+        else {
+            /* only stat the things which might be subdirectories */
+            if (g_file_test(full, G_FILE_TEST_IS_DIR))
+                dir_collect(full, rootlen, entries, seen);
+            g_free(full);
+        }
+    }
+    g_dir_close(dir);
+}
+
+static void dir_parse_entry(gpointer data, gpointer user_data)
+{
+    ObtDDParseDirEntry *e = data;
+    e->groups = parse_desktop_file(e->path);
+}
+
+static gint dir_entry_cmp(gconstpointer a, gconstpointer b)
+{
+    const ObtDDParseDirEntry *ea = *(ObtDDParseDirEntry*const*)a;
+    const ObtDDParseDirEntry *eb = *(ObtDDParseDirEntry*const*)b;
+    return strcmp(ea->name, eb->name);
+}
+
+void obt_ddparse_dir(const gchar *path, ObtDDParseDirFunc func, gpointer data)
+{
+    GPtrArray *entries;
+    GArray *seen;
+    GThreadPool *pool;
+    guint i;
+
+    entries = g_ptr_array_new();
+    seen = g_array_new(FALSE, FALSE, sizeof(ObtDDParseDirSeen));
+    dir_collect(path, strlen(path), entries, seen);
+    g_array_free(seen, TRUE);
+
+    pool = NULL;
+    if (entries->len >= DIR_MIN_THREADED) {
+        gint n;
+
+#if GLIB_CHECK_VERSION(2, 36, 0)
+        n = g_get_num_processors();
+#else
+        n = 4;
+#endif
+#if !GLIB_CHECK_VERSION(2, 32, 0)
+        if (!g_thread_supported()) g_thread_init(NULL);
+#endif
+        if (n > 1)
+            pool = g_thread_pool_new(dir_parse_entry, NULL, n, TRUE, NULL);
+    }
+
+    /* each file is parsed on its own, into its own groups, and the interned
+       key and group names are the only thing shared between them */
+    for (i = 0; i < entries->len; ++i) {
+        if (pool)
+            g_thread_pool_push(pool, g_ptr_array_index(entries, i), NULL);
+        else
+            dir_parse_entry(g_ptr_array_index(entries, i), NULL);
+    }
+    /* wait for all of the files to be parsed */
+    if (pool)
+        g_thread_pool_free(pool, FALSE, TRUE);
+
+    /* give them back in the same order every time, no matter which thread
+       finished first */
+    g_ptr_array_sort(entries, dir_entry_cmp);
+    for (i = 0; i < entries->len; ++i) {
+        ObtDDParseDirEntry *e = g_ptr_array_index(entries, i);
+        if (e->groups)
+            func(e->name, e->groups, data);
+        g_free(e->path);
+        g_slice_free(ObtDDParseDirEntry, e);
+    }
+    g_ptr_array_free(entries, TRUE);
+}
+
 GHashTable* obt_ddparse_group_keys(ObtDDParseGroup *g)
 {
     return g->key_hash;
@@ -52,6 +52,26 @@ typedef struct _ObtDDParseValue {
    ObtDDParseGroups */
 GHashTable* obt_ddparse_file(const gchar *name, GSList *paths);
 
+/* Returns a hash table like obt_ddparse_file, for an icon theme's index.theme
+   file.  The [Icon Theme] group has the keys for the theme, and the other
+   groups have the keys for each of the theme's directories.  Keys which are
+   not known are skipped quietly, as themes often hold extra keys. */
+GHashTable* obt_ddparse_icon_theme_file(const gchar *name, GSList *paths);
+
+/*! Called for each .desktop file found by obt_ddparse_dir.
+  @param name The path of the file, relative to the directory it was found in
+  @param groups A hash table like those returned by obt_ddparse_file, which
+    is owned by the function, and must be destroyed by it
+*/
+typedef void (*ObtDDParseDirFunc)(const gchar *name, GHashTable *groups,
+                                  gpointer data);
+
+/* Parses every .desktop file in the directory @dir and its subdirectories.
+   The files are parsed on several threads at once, but @func is always called
+   in the caller's thread, in order of the files' names, and only for the
+   files which parse without errors. */
+void obt_ddparse_dir(const gchar *dir, ObtDDParseDirFunc func, gpointer data);
+
 /* Returns a hash table where the keys are "keys" in the .desktop file,
    and the values are "values" in the .desktop file, for the group @g. */
 GHashTable* obt_ddparse_group_keys(ObtDDParseGroup *g);
@@ -157,8 +157,9 @@ static gint xerror_handler(Display *d, XErrorEvent *e)
     return 0;
 }
 
-void obt_display_ignore_errors(gboolean ignore)
+void (obt_display_ignore_errors)(gboolean ignore)
 {
+    OBT_ROUNDTRIP("XSync");
     XSync(obt_display, FALSE);
     xerror_ignore = ignore;
     if (ignore) obt_display_error_occured = FALSE;
@@ -19,6 +19,8 @@
 #ifndef __obt_display_h
 #define __obt_display_h
 
+#include "obt/roundtrip.h"
+
 #include <X11/Xlib.h>
 #include <glib.h>
 
@@ -62,6 +64,9 @@ gboolean obt_display_open(const char *display_name);
 void     obt_display_close(void);
 
 void     obt_display_ignore_errors(gboolean ignore);
+/* count the XSync it makes against the caller */
+#define  obt_display_ignore_errors(ignore) \
+    (OBT_ROUNDTRIP_CALLER(NULL), obt_display_ignore_errors(ignore))
 
 #define  obt_root(screen) (RootWindow(obt_display, screen))
 
@@ -0,0 +1,626 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obt/icontheme.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "obt/icontheme.h"
+#include "obt/ddparse.h"
+#include "obt/paths.h"
+
+#ifdef HAVE_STDIO_H
+#  include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#  include <string.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#  include <sys/stat.h>
+#endif
+#ifdef HAVE_SYS_TYPES_H
+#  include <sys/types.h>
+#endif
+
+/*! The first line of an index saved in the cache, which changes when the
+  format of the index does */
+#define INDEX_HEADER "obt-icon-theme-index 1"
+
+typedef enum {
+    ICON_DIR_FIXED,
+    ICON_DIR_SCALABLE,
+    ICON_DIR_THRESHOLD
+} ObtIconDirType;
+
+/*! One of the directories listed in an icon theme's index.theme */
+typedef struct _ObtIconDir {
+    gchar *name; /*!< The directory's path inside the theme */
+    ObtIconDirType type;
+    gint size;
+    gint min_size;
+    gint max_size;
+    gint threshold;
+} ObtIconDir;
+
+/*! Where a file for an icon is in a theme */
+typedef struct _ObtIconFile {
+    guint base; /*!< The base directory that holds the file's theme */
+    guint dir;  /*!< The theme directory that holds the file */
+    guint ext;  /*!< The file's extension */
+} ObtIconFile;
+
+typedef struct _ObtIconThemeIndex {
+    gchar *name;
+    ObtIconDir *dirs;
+    guint n_dirs;
+    /*! The key is an icon name, the value is a GArray of ObtIconFiles, in
+      the order that they are searched */
+    GHashTable *icons;
+} ObtIconThemeIndex;
+
+struct _ObtIconTheme {
+    gint ref;
+    /*! The directories which hold icon themes, in the order they are
+      searched */
+    gchar **bases;
+    guint n_bases;
+    /*! ObtIconThemeIndex for the theme, then the themes it inherits from, in
+      the order they are searched */
+    GPtrArray *themes;
+    /*! The key is an icon name, the value is the path of an icon that is
+      not in any theme */
+    GHashTable *unthemed;
+};
+
+/* the extensions for icon files, in the order they are preferred */
+static const gchar *const extensions[] = { ".png", ".svg", ".xpm" };
+#define N_EXTENSIONS G_N_ELEMENTS(extensions)
+
+/*! Returns the index of the extension that the file name ends with, or -1 if
+  it is not an icon file */
+static gint find_extension(const gchar *file, gsize len)
+{
+    guint i;
+
+    for (i = 0; i < N_EXTENSIONS; ++i) {
+        const gsize elen = strlen(extensions[i]);
+        if (len > elen && !strcmp(file + len - elen, extensions[i]))
+            return i;
+    }
+    return -1;
+}
+
+static gint64 path_mtime(const gchar *path)
+{
+    struct stat st;
+
+    if (stat(path, &st) != 0)
+        return 0;
+    return st.st_mtime;
+}
+
+static void file_array_free(GArray *a)
+{
+    g_array_free(a, TRUE);
+}
+
+static gint file_cmp(const ObtIconFile *a, const ObtIconFile *b)
+{
+    if (a->dir != b->dir) return a->dir < b->dir ? -1 : 1;
+    if (a->base != b->base) return a->base < b->base ? -1 : 1;
+    if (a->ext != b->ext) return a->ext < b->ext ? -1 : 1;
+    return 0;
+}
+
+static void file_array_sort(gpointer key, GArray *a, gpointer data)
+{
+    g_array_sort(a, (GCompareFunc)file_cmp);
+}
+
+static void theme_index_add(ObtIconThemeIndex *ti, const gchar *icon,
+                            guint base, guint dir, guint ext)
+{
+    GArray *a;
+    ObtIconFile f;
+
+    if (!(a = g_hash_table_lookup(ti->icons, icon))) {
+        a = g_array_new(FALSE, FALSE, sizeof(ObtIconFile));
+        g_hash_table_insert(ti->icons, g_strdup(icon), a);
+    }
+    f.base = base;
+    f.dir = dir;
+    f.ext = ext;
+    g_array_append_val(a, f);
+}
+
+static void theme_index_free(ObtIconThemeIndex *ti)
+{
+    guint i;
+
+    for (i = 0; i < ti->n_dirs; ++i)
+        g_free(ti->dirs[i].name);
+    g_free(ti->dirs);
+    g_hash_table_destroy(ti->icons);
+    g_free(ti->name);
+    g_slice_free(ObtIconThemeIndex, ti);
+}
+
+static gint key_int(GHashTable *keys, const gchar *key, gint def)
+{
+    ObtDDParseValue *v;
+
+    if ((v = g_hash_table_lookup(keys, key)))
+        return (gint)v->value.numeric;
+    return def;
+}
+
+/*! Read a theme's index.theme, to find the theme's directories and their
+  sizes, and the themes that it inherits from.
+  @param inherits Returns a NULL-terminated list of the themes inherited from,
+    or NULL if there are none
+*/
+static ObtIconThemeIndex* theme_index_read(ObtIconTheme *t,
+                                           const gchar *name,
+                                           gchar ***inherits)
+{
+    ObtIconThemeIndex *ti;
+    GHashTable *groups, *keys;
+    ObtDDParseGroup *g;
+    ObtDDParseValue *v;
+    GSList *paths;
+    gchar *file, **dirs;
+    guint i;
+
+    paths = NULL;
+    for (i = 0; i < t->n_bases; ++i)
+        paths = g_slist_append(paths, t->bases[i]);
+    file = g_strconcat(name, "/index.theme", NULL);
+    groups = obt_ddparse_icon_theme_file(file, paths);
+    g_free(file);
+    g_slist_free(paths);
+    if (!groups) return NULL;
+
+    g = g_hash_table_lookup(groups, "Icon Theme");
+    g_assert(g != NULL);
+    keys = obt_ddparse_group_keys(g);
+
+    *inherits = NULL;
+    if ((v = g_hash_table_lookup(keys, "Inherits")))
+        *inherits = g_strsplit(v->value.string, ",", 0);
+    dirs = NULL;
+    if ((v = g_hash_table_lookup(keys, "Directories")))
+        dirs = g_strsplit(v->value.string, ",", 0);
+
+    ti = g_slice_new0(ObtIconThemeIndex);
+    ti->name = g_strdup(name);
+    ti->icons = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                      (GDestroyNotify)file_array_free);
+    ti->dirs = g_new(ObtIconDir, dirs ? g_strv_length(dirs) : 0);
+
+    for (i = 0; dirs && dirs[i]; ++i) {
+        ObtIconDir *d;
+        gchar *dname = g_strstrip(dirs[i]);
+
+        if (!*dname || !(g = g_hash_table_lookup(groups, dname)))
+            continue;
+        keys = obt_ddparse_group_keys(g);
+
+        /* a directory needs a size, and the ones for scaled up screens are
+           not used */
+        if (!g_hash_table_lookup(keys, "Size") ||
+            key_int(keys, "Scale", 1) != 1)
+            continue;
+
+        d = &ti->dirs[ti->n_dirs++];
+        d->name = g_strdup(dname);
+        d->size = key_int(keys, "Size", 0);
+        d->min_size = key_int(keys, "MinSize", d->size);
+        d->max_size = key_int(keys, "MaxSize", d->size);
+        d->threshold = key_int(keys, "Threshold", 2);
+        d->type = ICON_DIR_THRESHOLD;
+        if ((v = g_hash_table_lookup(keys, "Type"))) {
+            if (!strcmp(v->value.string, "Fixed"))
+                d->type = ICON_DIR_FIXED;
+            else if (!strcmp(v->value.string, "Scalable"))
+                d->type = ICON_DIR_SCALABLE;
+        }
+    }
+
+    g_strfreev(dirs);
+    g_hash_table_destroy(groups);
+    return ti;
+}
+
+/*! Returns the paths whose modification times tell if a theme's saved index
+  is still right.  They are the same paths, in the same order, as long as
+  the theme's index.theme and the base directories don't change. */
+static GPtrArray* theme_index_stamps(ObtIconTheme *t, ObtIconThemeIndex *ti)
+{
+    GPtrArray *a;
+    guint i, j;
+
+    a = g_ptr_array_new();
+    for (i = 0; i < t->n_bases; ++i) {
+        g_ptr_array_add(a, g_strconcat(t->bases[i], "/", ti->name,
+                                       "/index.theme", NULL));
+        for (j = 0; j < ti->n_dirs; ++j)
+            g_ptr_array_add(a, g_strconcat(t->bases[i], "/", ti->name, "/",
+                                           ti->dirs[j].name, NULL));
+    }
+    return a;
+}
+
+static void stamps_free(GPtrArray *a)
+{
+    guint i;
+
+    for (i = 0; i < a->len; ++i)
+        g_free(g_ptr_array_index(a, i));
+    g_ptr_array_free(a, TRUE);
+}
+
+/*! Look through the theme's directories for its icons */
+static void theme_index_scan(ObtIconTheme *t, ObtIconThemeIndex *ti)
+{
+    guint i, j;
+
+    for (j = 0; j < ti->n_dirs; ++j)
+        for (i = 0; i < t->n_bases; ++i) {
+            gchar *path;
+            GDir *dir;
+            const gchar *file;
+
+            path = g_strconcat(t->bases[i], "/", ti->name, "/",
+                               ti->dirs[j].name, NULL);
+            if ((dir = g_dir_open(path, 0, NULL))) {
+                while ((file = g_dir_read_name(dir))) {
+                    const gsize len = strlen(file);
+                    const gint ext = find_extension(file, len);
+
+                    if (ext >= 0) {
+                        gchar *icon;
+
+                        icon = g_strndup(file, len - strlen(extensions[ext]));
+                        theme_index_add(ti, icon, i, j, ext);
+                        g_free(icon);
+                    }
+                }
+                g_dir_close(dir);
+            }
+            g_free(path);
+        }
+
+    /* put each icon's files in the order to search them */
+    g_hash_table_foreach(ti->icons, (GHFunc)file_array_sort, NULL);
+}
+
+/*! Read a theme's index from the cache, if none of the theme's directories
+  have changed since it was saved.
+  @return TRUE if the index was read from the cache
+*/
+static gboolean theme_index_load(ObtIconTheme *t, ObtIconThemeIndex *ti,
+                                 const gchar *file, GPtrArray *stamps)
+{
+    gchar *contents, **lines;
+    guint i, n_stamps;
+    gboolean ok;
+
+    if (!g_file_get_contents(file, &contents, NULL, NULL))
+        return FALSE;
+    lines = g_strsplit(contents, "\n", 0);
+    g_free(contents);
+
+    ok = lines[0] && !strcmp(lines[0], INDEX_HEADER);
+    n_stamps = 0;
+    for (i = 1; ok && lines[i]; ++i) {
+        const gchar *l = lines[i];
+        gint64 mtime;
+        guint base, dir, ext;
+        gint n;
+
+        if (l[0] == 'd') {
+            n = 0;
+            ok = sscanf(l, "d %" G_GINT64_FORMAT " %n", &mtime, &n) == 1 &&
+                n > 0 && n_stamps < stamps->len &&
+                !strcmp(l + n, g_ptr_array_index(stamps, n_stamps)) &&
+                mtime == path_mtime(l + n);
+            ++n_stamps;
+        }
+        else if (l[0] == 'f') {
+            /* the directories are all checked before any icons are read */
+            n = 0;
+            ok = n_stamps == stamps->len &&
+                sscanf(l, "f %u %u %u %n", &base, &dir, &ext, &n) == 3 &&
+                n > 0 && l[n] &&
+                base < t->n_bases && dir < ti->n_dirs && ext < N_EXTENSIONS;
+            if (ok)
+                theme_index_add(ti, l + n, base, dir, ext);
+        }
+        else if (l[0] != '\0')
+            ok = FALSE;
+    }
+    ok = ok && n_stamps == stamps->len;
+    g_strfreev(lines);
+
+    if (!ok)
+        g_hash_table_remove_all(ti->icons);
+    return ok;
+}
+
+typedef struct _ObtIconIndexWrite {
+    GString *s;
+    ObtIconThemeIndex *ti;
+} ObtIconIndexWrite;
+
+static void write_files(const gchar *icon, GArray *a, ObtIconIndexWrite *w)
+{
+    guint i;
+
+    for (i = 0; i < a->len; ++i) {
+        const ObtIconFile *f = &g_array_index(a, ObtIconFile, i);
+        g_string_append_printf(w->s, "f %u %u %u %s\n",
+                               f->base, f->dir, f->ext, icon);
+    }
+}
+
+/*! Save a theme's index in the cache, along with the modification times that
+  its directories had before they were read */
+static void theme_index_save(ObtIconThemeIndex *ti, const gchar *file,
+                             GPtrArray *stamps, const gint64 *mtimes)
+{
+    ObtIconIndexWrite w;
+    gchar *dir;
+    guint i;
+
+    w.s = g_string_new(INDEX_HEADER "\n");
+    w.ti = ti;
+    for (i = 0; i < stamps->len; ++i)
+        g_string_append_printf(w.s, "d %" G_GINT64_FORMAT " %s\n",
+                               mtimes[i],
+                               (gchar*)g_ptr_array_index(stamps, i));
+    g_hash_table_foreach(ti->icons, (GHFunc)write_files, &w);
+
+    dir = g_path_get_dirname(file);
+    if (obt_paths_mkdir_path(dir, 0700))
+        g_file_set_contents(file, w.s->str, w.s->len, NULL);
+    g_free(dir);
+    g_string_free(w.s, TRUE);
+}
+
+/*! Load a theme and then the themes it inherits from */
+static void theme_load(ObtIconTheme *t, const gchar *name,
+                       const gchar *cache_dir)
+{
+    ObtIconThemeIndex *ti;
+    GPtrArray *stamps;
+    gchar **inherits, *file;
+    guint i;
+
+    /* each theme is only searched once, which also stops inheritance from
+       going around in circles */
+    for (i = 0; i < t->themes->len; ++i) {
+        ti = g_ptr_array_index(t->themes, i);
+        if (!strcmp(ti->name, name))
+            return;
+    }
+    if (!*name || strchr(name, '/'))
+        return;
+
+    if (!(ti = theme_index_read(t, name, &inherits)))
+        return;
+    g_ptr_array_add(t->themes, ti);
+
+    stamps = theme_index_stamps(t, ti);
+    file = g_strconcat(cache_dir, "/", name, ".index", NULL);
+    if (!theme_index_load(t, ti, file, stamps)) {
+        gint64 *mtimes;
+
+        /* find the times first, so that a change made while reading the
+           directories is noticed next time */
+        mtimes = g_new(gint64, stamps->len);
+        for (i = 0; i < stamps->len; ++i)
+            mtimes[i] = path_mtime(g_ptr_array_index(stamps, i));
+
+        theme_index_scan(t, ti);
+        theme_index_save(ti, file, stamps, mtimes);
+        g_free(mtimes);
+    }
+    g_free(file);
+    stamps_free(stamps);
+
+    for (i = 0; inherits && inherits[i]; ++i)
+        theme_load(t, g_strstrip(inherits[i]), cache_dir);
+    g_strfreev(inherits);
+}
+
+/*! Find the icons in a directory which are not part of any theme */
+static void unthemed_scan(ObtIconTheme *t, const gchar *path)
+{
+    GDir *dir;
+    const gchar *file;
+
+    if (!(dir = g_dir_open(path, 0, NULL)))
+        return;
+
+    while ((file = g_dir_read_name(dir))) {
+        const gsize len = strlen(file);
+        const gint ext = find_extension(file, len);
+        gchar *icon;
+
+        if (ext < 0) continue;
+
+        /* the first one found is used */
+        icon = g_strndup(file, len - strlen(extensions[ext]));
+        if (!g_hash_table_lookup(t->unthemed, icon))
+            g_hash_table_insert(t->unthemed, icon,
+                                g_strconcat(path, "/", file, NULL));
+        else
+            g_free(icon);
+    }
+    g_dir_close(dir);
+}
+
+ObtIconTheme* obt_icon_theme_new(ObtPaths *p, const gchar *name)
+{
+    ObtIconTheme *t;
+    GPtrArray *bases;
+    GSList *it;
+    gchar *cache_dir;
+    guint i;
+
+    t = g_slice_new0(ObtIconTheme);
+    t->ref = 1;
+
+    bases = g_ptr_array_new();
+    g_ptr_array_add(bases, g_build_filename(g_get_home_dir(), ".icons",
+                                            NULL));
+    for (it = obt_paths_data_dirs(p); it; it = g_slist_next(it))
+        g_ptr_array_add(bases, g_build_filename(it->data, "icons", NULL));
+    t->n_bases = bases->len;
+    g_ptr_array_add(bases, NULL);
+    t->bases = (gchar**)g_ptr_array_free(bases, FALSE);
+
+    t->themes = g_ptr_array_new();
+    cache_dir = g_build_filename(obt_paths_cache_home(p),
+                                 "openbox", "icon-themes", NULL);
+    theme_load(t, name, cache_dir);
+    /* every theme falls back to hicolor last */
+    theme_load(t, "hicolor", cache_dir);
+    g_free(cache_dir);
+
+    t->unthemed = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                        g_free, g_free);
+    for (i = 0; i < t->n_bases; ++i)
+        unthemed_scan(t, t->bases[i]);
+    for (it = obt_paths_data_dirs(p); it; it = g_slist_next(it)) {
+        gchar *path = g_build_filename(it->data, "pixmaps", NULL);
+        unthemed_scan(t, path);
+        g_free(path);
+    }
+
+    return t;
+}
+
+void obt_icon_theme_ref(ObtIconTheme *t)
+{
+    ++t->ref;
+}
+
+void obt_icon_theme_unref(ObtIconTheme *t)
+{
+    if (t && --t->ref == 0) {
+        guint i;
+
+        for (i = 0; i < t->themes->len; ++i)
+            theme_index_free(g_ptr_array_index(t->themes, i));
+        g_ptr_array_free(t->themes, TRUE);
+        g_hash_table_destroy(t->unthemed);
+        g_strfreev(t->bases);
+        g_slice_free(ObtIconTheme, t);
+    }
+}
+
+static gboolean dir_matches_size(const ObtIconDir *d, gint size)
+{
+    switch (d->type) {
+    case ICON_DIR_FIXED:
+        return size == d->size;
+    case ICON_DIR_SCALABLE:
+        return size >= d->min_size && size <= d->max_size;
+    case ICON_DIR_THRESHOLD:
+        return size >= d->size - d->threshold &&
+            size <= d->size + d->threshold;
+    }
+    g_assert_not_reached();
+    return FALSE;
+}
+
+static gint dir_size_distance(const ObtIconDir *d, gint size)
+{
+    switch (d->type) {
+    case ICON_DIR_FIXED:
+        return ABS(d->size - size);
+    case ICON_DIR_SCALABLE:
+        if (size < d->min_size) return d->min_size - size;
+        if (size > d->max_size) return size - d->max_size;
+        return 0;
+    case ICON_DIR_THRESHOLD:
+        if (size < d->size - d->threshold)
+            return d->size - d->threshold - size;
+        if (size > d->size + d->threshold)
+            return size - d->size - d->threshold;
+        return 0;
+    }
+    g_assert_not_reached();
+    return 0;
+}
+
+gchar* obt_icon_theme_lookup(ObtIconTheme *t, const gchar *icon, gint size)
+{
+    gchar *name, *path;
+    const gchar *file;
+    gsize len;
+    gint ext;
+    guint i, j;
+
+    if (g_path_is_absolute(icon))
+        return g_strdup(icon);
+
+    /* an icon's file name is often given instead of its name */
+    len = strlen(icon);
+    if ((ext = find_extension(icon, len)) >= 0)
+        name = g_strndup(icon, len - strlen(extensions[ext]));
+    else
+        name = g_strdup(icon);
+
+    path = NULL;
+    for (i = 0; i < t->themes->len && !path; ++i) {
+        ObtIconThemeIndex *ti = g_ptr_array_index(t->themes, i);
+        const ObtIconFile *best;
+        GArray *files;
+        gint best_dist;
+
+        if (!(files = g_hash_table_lookup(ti->icons, name)))
+            continue;
+
+        /* use the first file for the size, or else the closest one in this
+           theme */
+        best = NULL;
+        best_dist = G_MAXINT;
+        for (j = 0; j < files->len; ++j) {
+            const ObtIconFile *f = &g_array_index(files, ObtIconFile, j);
+            gint dist;
+
+            if (dir_matches_size(&ti->dirs[f->dir], size)) {
+                best = f;
+                break;
+            }
+            dist = dir_size_distance(&ti->dirs[f->dir], size);
+            if (dist < best_dist) {
+                best = f;
+                best_dist = dist;
+            }
+        }
+
+        path = g_strconcat(t->bases[best->base], "/", ti->name, "/",
+                           ti->dirs[best->dir].name, "/", name,
+                           extensions[best->ext], NULL);
+    }
+
+    if (!path && (file = g_hash_table_lookup(t->unthemed, name)))
+        path = g_strdup(file);
+
+    g_free(name);
+    return path;
+}
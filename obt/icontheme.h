@@ -0,0 +1,54 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obt/icontheme.h for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __obt_icontheme_h
+#define __obt_icontheme_h
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+struct _ObtPaths;
+
+typedef struct _ObtIconTheme ObtIconTheme;
+
+/*! Load an icon theme, along with the themes it inherits from, and index the
+  icons in all of them, so that finding an icon does not have to look in
+  the theme's directories.  The index is saved in the user's cache directory,
+  and used again for as long as none of the theme's directories change.
+  @param name The name of the icon theme, such as "hicolor"
+*/
+ObtIconTheme* obt_icon_theme_new(struct _ObtPaths *p, const gchar *name);
+
+void obt_icon_theme_ref(ObtIconTheme *t);
+void obt_icon_theme_unref(ObtIconTheme *t);
+
+/*! Find the file for an icon, as in the freedesktop.org icon theme
+  specification.  The theme and the themes it inherits from are searched in
+  order, then hicolor, and then the icons which are not in any theme.
+  @param icon The name of the icon.  If it is an absolute path, it is
+    returned as it is.
+  @param size The size that the icon will be drawn at, in pixels
+  @return A newly allocated path to the icon's file, or NULL if there is no
+    icon by that name
+*/
+gchar* obt_icon_theme_lookup(ObtIconTheme *t, const gchar *icon, gint size);
+
+G_END_DECLS
+
+#endif
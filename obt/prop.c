@@ -221,6 +221,7 @@ static gboolean get_prealloc(Window win, Atom prop, Atom type, gint size,
     gulong ret_items, bytes_left;
     glong num32 = 32 / size * num; /* num in 32-bit elements */
 
+    OBT_ROUNDTRIP("GetProperty");
     res = XGetWindowProperty(obt_display, win, prop, 0l, num32,
                              FALSE, type, &ret_type, &ret_size,
                              &ret_items, &bytes_left, &xdata);
@@ -258,6 +259,7 @@ static gboolean get_all(Window win, Atom prop, Atom type, gint size,
     gint ret_size;
     gulong ret_items, bytes_left;
 
+    OBT_ROUNDTRIP("GetProperty");
     res = XGetWindowProperty(obt_display, win, prop, 0l, G_MAXLONG,
                              FALSE, type, &ret_type, &ret_size,
                              &ret_items, &bytes_left, &xdata);
@@ -300,6 +302,7 @@ static gboolean get_all(Window win, Atom prop, Atom type, gint size,
 static gboolean get_text_property(Window win, Atom prop,
                                   XTextProperty *tprop, ObtPropTextType type)
 {
+    OBT_ROUNDTRIP("GetProperty");
     if (!(XGetTextProperty(obt_display, win, tprop, prop) && tprop->nitems))
         return FALSE;
     if (!type)
@@ -20,6 +20,8 @@
 #ifndef __obt_prop_h
 #define __obt_prop_h
 
+#include "obt/roundtrip.h"
+
 #include <X11/Xlib.h>
 #include <glib.h>
 
@@ -274,20 +276,28 @@ void obt_prop_message_to(Window to, Window about, Atom messagetype,
 
 #define OBT_PROP_ATOM(prop) obt_prop_atom(OBT_PROP_##prop)
 
+/* the round trips made by these are counted against the caller, and the
+   property which was read */
 #define OBT_PROP_GET32(win, prop, type, ret) \
-    (obt_prop_get32(win, OBT_PROP_ATOM(prop), OBT_PROP_ATOM(type), ret))
+    (OBT_ROUNDTRIP_CALLER(#prop), \
+     obt_prop_get32(win, OBT_PROP_ATOM(prop), OBT_PROP_ATOM(type), ret))
 #define OBT_PROP_GETA32(win, prop, type, ret, nret) \
-    (obt_prop_get_array32(win, OBT_PROP_ATOM(prop), OBT_PROP_ATOM(type), \
+    (OBT_ROUNDTRIP_CALLER(#prop), \
+     obt_prop_get_array32(win, OBT_PROP_ATOM(prop), OBT_PROP_ATOM(type), \
                           ret, nret))
 #define OBT_PROP_GETS(win, prop, ret) \
-    (obt_prop_get_text(win, OBT_PROP_ATOM(prop), 0, ret))
+    (OBT_ROUNDTRIP_CALLER(#prop), \
+     obt_prop_get_text(win, OBT_PROP_ATOM(prop), 0, ret))
 #define OBT_PROP_GETSS(win, prop, ret) \
-    (obt_prop_get_array_text(win, OBT_PROP_ATOM(prop), 0, ret))
+    (OBT_ROUNDTRIP_CALLER(#prop), \
+     obt_prop_get_array_text(win, OBT_PROP_ATOM(prop), 0, ret))
 
 #define OBT_PROP_GETS_TYPE(win, prop, type, ret) \
-    (obt_prop_get_text(win, OBT_PROP_ATOM(prop), OBT_PROP_TEXT_##type, ret))
+    (OBT_ROUNDTRIP_CALLER(#prop), \
+     obt_prop_get_text(win, OBT_PROP_ATOM(prop), OBT_PROP_TEXT_##type, ret))
 #define OBT_PROP_GETSS_TYPE(win, prop, type, ret) \
-    (obt_prop_get_array_text(win, OBT_PROP_ATOM(prop), \
+    (OBT_ROUNDTRIP_CALLER(#prop), \
+     obt_prop_get_array_text(win, OBT_PROP_ATOM(prop), \
                              OBT_PROP_TEXT_##type, ret))
 
 #define OBT_PROP_GETS_UTF8(win, prop, ret) \
@@ -0,0 +1,152 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obt/roundtrip.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "obt/roundtrip.h"
+#include "obt/display.h"
+#include "obt/xqueue.h"
+
+#ifdef HAVE_STRING_H
+#  include <string.h>
+#endif
+
+typedef struct _ObtRoundTrip {
+    const gchar *request;
+    const gchar *caller;
+    const gchar *what;
+    gint event;
+    guint count;
+} ObtRoundTrip;
+
+gboolean obt_roundtrip_on = FALSE;
+
+/* ObtRoundTrips, each one is also its own key */
+static GHashTable *trips = NULL;
+static guint total = 0;
+static gint event_type = 0;
+static const gchar *next_caller = NULL;
+static const gchar *next_what = NULL;
+
+/* the same string literal can be at different addresses in different
+   files, so compare what they say */
+static gboolean str_equal(const gchar *a, const gchar *b)
+{
+    return a == b || (a && b && !strcmp(a, b));
+}
+
+static guint trip_hash(gconstpointer key)
+{
+    const ObtRoundTrip *t = key;
+    return (g_str_hash(t->request) ^ g_str_hash(t->caller) * 31 ^
+            (t->what ? g_str_hash(t->what) : 0) ^ (guint)t->event);
+}
+
+static gboolean trip_equal(gconstpointer a, gconstpointer b)
+{
+    const ObtRoundTrip *ta = a, *tb = b;
+    return (ta->event == tb->event && str_equal(ta->request, tb->request) &&
+            str_equal(ta->caller, tb->caller) && str_equal(ta->what, tb->what));
+}
+
+static void trip_free(gpointer data)
+{
+    g_slice_free(ObtRoundTrip, data);
+}
+
+void obt_roundtrip_enable(gboolean on)
+{
+    obt_roundtrip_on = on;
+    if (on && !trips)
+        trips = g_hash_table_new_full(trip_hash, trip_equal, trip_free, NULL);
+}
+
+void obt_roundtrip_caller(const gchar *caller, const gchar *what)
+{
+    next_caller = caller;
+    next_what = what;
+}
+
+void obt_roundtrip_count(const gchar *request, const gchar *caller)
+{
+    ObtRoundTrip key, *t;
+
+    key.request = request;
+    key.caller = next_caller ? next_caller : caller;
+    key.what = next_caller ? next_what : NULL;
+    key.event = event_type;
+    next_caller = next_what = NULL;
+
+    if (!(t = g_hash_table_lookup(trips, &key))) {
+        t = g_slice_new(ObtRoundTrip);
+        *t = key;
+        t->count = 0;
+        g_hash_table_insert(trips, t, t);
+    }
+    ++t->count;
+    ++total;
+}
+
+void obt_roundtrip_event(gint type)
+{
+    event_type = type;
+}
+
+static gint trip_cmp(gconstpointer a, gconstpointer b)
+{
+    const ObtRoundTrip *ta = *(ObtRoundTrip*const*)a;
+    const ObtRoundTrip *tb = *(ObtRoundTrip*const*)b;
+    return ta->count < tb->count ? 1 : (ta->count > tb->count ? -1 : 0);
+}
+
+static void trip_add(gpointer key, gpointer value, gpointer data)
+{
+    g_ptr_array_add(data, value);
+}
+
+void obt_roundtrip_report(void)
+{
+    GPtrArray *a;
+    guint i;
+
+    if (!trips) return;
+
+    a = g_ptr_array_sized_new(g_hash_table_size(trips));
+    g_hash_table_foreach(trips, trip_add, a);
+    g_ptr_array_sort(a, trip_cmp);
+
+    g_print("%u round trips to the X server\n", total);
+    g_print("%8s %6s  %-24s %-20s %s\n",
+            "count", "%", "request", "event", "caller");
+    for (i = 0; i < a->len; ++i) {
+        ObtRoundTrip *t = g_ptr_array_index(a, i);
+        const gchar *name;
+        gchar *ev;
+
+        if (!t->event)
+            ev = g_strdup("-");
+        else if ((name = xqueue_event_name(t->event)))
+            ev = g_strdup(name);
+        else
+            ev = g_strdup_printf("extension event %d", t->event);
+
+        g_print("%8u %5.1f%%  %-24s %-20s %s%s%s\n",
+                t->count, 100.0 * t->count / total, t->request, ev,
+                t->caller, t->what ? " " : "", t->what ? t->what : "");
+        g_free(ev);
+    }
+    g_ptr_array_free(a, TRUE);
+}
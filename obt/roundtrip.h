@@ -0,0 +1,58 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obt/roundtrip.h for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __obt_roundtrip_h
+#define __obt_roundtrip_h
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Counts the requests that wait for a reply from the X server, by which
+   function made them and which X event was being handled at the time, to
+   find what makes the window manager slow over a remote display.  Nothing
+   is counted until it is turned on. */
+
+extern gboolean obt_roundtrip_on;
+
+/*! Start or stop counting round trips */
+void obt_roundtrip_enable(gboolean on);
+
+/*! Count a round trip for the named request, made by the function this is
+  used in, or by the caller given with OBT_ROUNDTRIP_CALLER just before */
+#define OBT_ROUNDTRIP(request) \
+    (obt_roundtrip_on ? obt_roundtrip_count(request, G_STRFUNC) : (void)0)
+
+/*! Name the function calling into obt, so the round trip which obt makes
+  for it is counted against the caller.  @what says more about the request,
+  such as the property being read. */
+#define OBT_ROUNDTRIP_CALLER(what) \
+    (obt_roundtrip_on ? obt_roundtrip_caller(G_STRFUNC, what) : (void)0)
+
+void obt_roundtrip_count(const gchar *request, const gchar *caller);
+void obt_roundtrip_caller(const gchar *caller, const gchar *what);
+
+/*! Set the type of the X event being handled, or 0 for none */
+void obt_roundtrip_event(gint type);
+
+/*! Print the round trips counted so far, the most frequent first */
+void obt_roundtrip_report(void);
+
+G_END_DECLS
+
+#endif
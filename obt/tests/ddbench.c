@@ -0,0 +1,166 @@
+#/*
+#!/bin/sh
+#*/
+#if 0
+gcc -O2 -o ./ddbench `pkg-config --cflags --libs obt-3.5` ddbench.c && \
+./ddbench
+exit
+#endif
+
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   ddbench.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Times parsing a directory of .desktop files, one at a time and with
+   obt_ddparse_dir().  Pass the number of files to make, the default is 5000,
+   which is about what a desktop with many applications installed has. */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "obt/ddparse.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#define FILES_PER_DIR 500
+
+static const gchar *entry =
+    "[Desktop Entry]\n"
+    "Type=Application\n"
+    "Name=Benchmark Application %d\n"
+    "Name[de]=Benchmark Anwendung %d\n"
+    "Name[fr]=Application de test %d\n"
+    "GenericName=Benchmark\n"
+    "Comment=An application that is only here to be parsed\n"
+    "Comment[de]=Eine Anwendung, die nur zum Lesen da ist\n"
+    "Icon=bench-%d\n"
+    "Exec=bench-%d %%U\n"
+    "TryExec=bench-%d\n"
+    "Terminal=false\n"
+    "StartupNotify=true\n"
+    "Categories=Utility;Development;\n"
+    "MimeType=text/plain;text/x-c;\n"
+    "\n"
+    "[Desktop Action New]\n"
+    "Name=New Window\n"
+    "Exec=bench-%d --new-window\n";
+
+static gint parsed;
+
+static gchar* make_tree(gint n)
+{
+    gchar *root;
+    gint i;
+
+    root = g_build_filename(g_get_tmp_dir(), "ddbench-XXXXXX", NULL);
+    if (!mkdtemp(root)) {
+        g_free(root);
+        return NULL;
+    }
+
+    for (i = 0; i < n; ++i) {
+        gchar *dir, *path, *s;
+
+        dir = g_strdup_printf("%s/%d", root, i / FILES_PER_DIR);
+        g_mkdir(dir, 0700);
+        path = g_strdup_printf("%s/bench-%d.desktop", dir, i);
+        s = g_strdup_printf(entry, i, i, i, i, i, i, i);
+        g_file_set_contents(path, s, -1, NULL);
+        g_free(s);
+        g_free(path);
+        g_free(dir);
+    }
+    return root;
+}
+
+static void remove_tree(const gchar *path)
+{
+    GDir *dir;
+    const gchar *n;
+
+    if ((dir = g_dir_open(path, 0, NULL))) {
+        while ((n = g_dir_read_name(dir))) {
+            gchar *full = g_build_filename(path, n, NULL);
+            remove_tree(full);
+            g_free(full);
+        }
+        g_dir_close(dir);
+    }
+    g_remove(path);
+}
+
+static void dir_func(const gchar *name, GHashTable *groups, gpointer data)
+{
+    ++parsed;
+    g_hash_table_destroy(groups);
+}
+
+gint main(int argc, char **argv)
+{
+    gchar *root;
+    GTimer *t;
+    gint n, i;
+    gdouble single, dir;
+
+    n = argc > 1 ? atoi(argv[1]) : 5000;
+    if (n <= 0) {
+        g_print("pass the number of files to parse\n");
+        return 1;
+    }
+
+    if (!(root = make_tree(n))) {
+        g_print("unable to make a temporary directory\n");
+        return 1;
+    }
+
+    t = g_timer_new();
+
+    /* the files are all in the page cache now, from making them, so neither
+       way has to wait for the disk */
+    parsed = 0;
+    g_timer_start(t);
+    for (i = 0; i < n; ++i) {
+        gchar *name;
+        GSList *paths;
+        GHashTable *groups;
+
+        name = g_strdup_printf("bench-%d.desktop", i);
+        paths = g_slist_prepend(NULL, g_strdup_printf("%s/%d", root,
+                                                      i / FILES_PER_DIR));
+        if ((groups = obt_ddparse_file(name, paths))) {
+            ++parsed;
+            g_hash_table_destroy(groups);
+        }
+        g_free(paths->data);
+        g_slist_free(paths);
+        g_free(name);
+    }
+    single = g_timer_elapsed(t, NULL);
+    g_print("obt_ddparse_file: %d files in %.3f seconds\n", parsed, single);
+
+    parsed = 0;
+    g_timer_start(t);
+    obt_ddparse_dir(root, dir_func, NULL);
+    dir = g_timer_elapsed(t, NULL);
+    g_print("obt_ddparse_dir:  %d files in %.3f seconds (%.1fx)\n",
+            parsed, dir, dir > 0 ? single / dir : 0.0);
+
+    g_timer_destroy(t);
+    remove_tree(root);
+    g_free(root);
+    return 0;
+}
@@ -0,0 +1,139 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obt/winmap.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "obt/winmap.h"
+
+/* the array starts with 2^MINBITS entries */
+#define MINBITS 5
+
+typedef struct _ObtWinMapEntry {
+    Window w; /* None when the entry is empty */
+    gpointer value;
+} ObtWinMapEntry;
+
+struct _ObtWinMap {
+    ObtWinMapEntry *e;
+    guint bits; /* the array has 2^bits entries */
+    guint mask; /* the size of the array, minus one */
+    guint num;
+};
+
+/* Window ids from one X client only differ in their low bits, so they are
+   mixed up (Fibonacci hashing) to spread them over the whole array */
+static inline guint slot(const ObtWinMap *m, Window w)
+{
+    return ((guint32)w * 2654435769u) >> (32 - m->bits);
+}
+
+ObtWinMap* obt_winmap_new(void)
+{
+    ObtWinMap *m = g_slice_new(ObtWinMap);
+    m->bits = MINBITS;
+    m->mask = (1u << MINBITS) - 1;
+    m->e = g_new0(ObtWinMapEntry, m->mask + 1);
+    m->num = 0;
+    return m;
+}
+
+void obt_winmap_free(ObtWinMap *m)
+{
+    if (m) {
+        g_free(m->e);
+        g_slice_free(ObtWinMap, m);
+    }
+}
+
+gpointer obt_winmap_find(const ObtWinMap *m, Window w)
+{
+    guint i;
+
+    for (i = slot(m, w); m->e[i].w != None; i = (i + 1) & m->mask)
+        if (m->e[i].w == w)
+            return m->e[i].value;
+    return NULL;
+}
+
+static void grow(ObtWinMap *m)
+{
+    ObtWinMapEntry *old = m->e;
+    guint i, j, oldsz = m->mask + 1;
+
+    ++m->bits;
+    m->mask = oldsz * 2 - 1;
+    m->e = g_new0(ObtWinMapEntry, oldsz * 2);
+    for (i = 0; i < oldsz; ++i)
+        if (old[i].w != None) {
+            for (j = slot(m, old[i].w); m->e[j].w != None;
+                 j = (j + 1) & m->mask);
+            m->e[j] = old[i];
+        }
+    g_free(old);
+}
+
+void obt_winmap_add(ObtWinMap *m, Window w, gpointer value)
+{
+    guint i;
+
+    g_assert(w != None);
+    g_assert(value != NULL);
+
+    for (i = slot(m, w); m->e[i].w != None; i = (i + 1) & m->mask)
+        if (m->e[i].w == w) {
+            m->e[i].value = value;
+            return;
+        }
+
+    m->e[i].w = w;
+    m->e[i].value = value;
+    /* keep it at most half full, so the runs of used entries stay short */
+    if (++m->num * 2 > m->mask + 1)
+        grow(m);
+}
+
+void obt_winmap_remove(ObtWinMap *m, Window w)
+{
+    guint i, j, k;
+
+    /* None marks the empty entries, so it would be found in one */
+    if (w == None)
+        return;
+
+    for (i = slot(m, w); m->e[i].w != w; i = (i + 1) & m->mask)
+        if (m->e[i].w == None)
+            return; /* not in the map */
+
+    /* move entries after it back into the hole if they can go there, so
+       that no run of used entries is broken and no markers are left
+       behind */
+    for (j = (i + 1) & m->mask; m->e[j].w != None; j = (j + 1) & m->mask) {
+        k = slot(m, m->e[j].w);
+        /* leave it if its home slot is in (i, j], cyclically */
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        m->e[i] = m->e[j];
+        i = j;
+    }
+    m->e[i].w = None;
+    m->e[i].value = NULL;
+    --m->num;
+}
+
+guint obt_winmap_size(const ObtWinMap *m)
+{
+    return m->num;
+}
@@ -0,0 +1,49 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obt/winmap.h for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __obt_winmap_h
+#define __obt_winmap_h
+
+#include <X11/Xlib.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*! A map from X windows to pointers.  The windows are kept in one array,
+  with open addressing, so finding one does not follow any pointers.  None
+  can not be used as a key, and NULL can not be used as a value. */
+typedef struct _ObtWinMap ObtWinMap;
+
+ObtWinMap* obt_winmap_new(void);
+void       obt_winmap_free(ObtWinMap *m);
+
+/*! Returns the value for the window, or NULL if it is not in the map */
+gpointer obt_winmap_find(const ObtWinMap *m, Window w);
+
+/*! Adds the window to the map, replacing its value if it is already there */
+void obt_winmap_add(ObtWinMap *m, Window w, gpointer value);
+
+/*! Removes the window from the map, if it is there */
+void obt_winmap_remove(ObtWinMap *m, Window w);
+
+/*! Returns the number of windows in the map */
+guint obt_winmap_size(const ObtWinMap *m);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,95 @@
+#include "obt/unittest_base.h"
+
+#include "obt/winmap.h"
+
+#include <glib.h>
+
+static void empty() {
+    TEST_START();
+
+    ObtWinMap *m = obt_winmap_new();
+
+    EXPECT_UINT_EQ(0, obt_winmap_size(m));
+    EXPECT_BOOL_EQ(TRUE, obt_winmap_find(m, 0x400001) == NULL);
+
+    /* Removing something which isn't there does nothing. */
+    obt_winmap_remove(m, 0x400001);
+    EXPECT_UINT_EQ(0, obt_winmap_size(m));
+
+    obt_winmap_free(m);
+
+    TEST_END();
+}
+
+static void add_find_remove() {
+    TEST_START();
+
+    ObtWinMap *m = obt_winmap_new();
+    int a, b;
+
+    obt_winmap_add(m, 0x400001, &a);
+    obt_winmap_add(m, 0x400002, &b);
+    EXPECT_UINT_EQ(2, obt_winmap_size(m));
+    EXPECT_BOOL_EQ(TRUE, obt_winmap_find(m, 0x400001) == &a);
+    EXPECT_BOOL_EQ(TRUE, obt_winmap_find(m, 0x400002) == &b);
+    EXPECT_BOOL_EQ(TRUE, obt_winmap_find(m, 0x400003) == NULL);
+
+    /* Adding a window again replaces its value. */
+    obt_winmap_add(m, 0x400001, &b);
+    EXPECT_UINT_EQ(2, obt_winmap_size(m));
+    EXPECT_BOOL_EQ(TRUE, obt_winmap_find(m, 0x400001) == &b);
+
+    obt_winmap_remove(m, 0x400001);
+    EXPECT_UINT_EQ(1, obt_winmap_size(m));
+    EXPECT_BOOL_EQ(TRUE, obt_winmap_find(m, 0x400001) == NULL);
+    EXPECT_BOOL_EQ(TRUE, obt_winmap_find(m, 0x400002) == &b);
+
+    /* Removing None does nothing, even though empty entries hold None. */
+    obt_winmap_remove(m, None);
+    EXPECT_UINT_EQ(1, obt_winmap_size(m));
+    EXPECT_BOOL_EQ(TRUE, obt_winmap_find(m, 0x400002) == &b);
+
+    obt_winmap_free(m);
+
+    TEST_END();
+}
+
+static void many() {
+    TEST_START();
+
+    ObtWinMap *m = obt_winmap_new();
+    static int values[3000];
+    guint i, wrong;
+
+    /* Windows from a few X clients, enough to grow the map a few times. */
+    for (i = 0; i < 3000; ++i)
+        obt_winmap_add(m, ((i % 3 + 1) << 21) | (i / 3 + 1), &values[i]);
+    EXPECT_UINT_EQ(3000, obt_winmap_size(m));
+
+    /* Remove every other one, which moves the entries around. */
+    for (i = 0; i < 3000; i += 2)
+        obt_winmap_remove(m, ((i % 3 + 1) << 21) | (i / 3 + 1));
+    EXPECT_UINT_EQ(1500, obt_winmap_size(m));
+
+    wrong = 0;
+    for (i = 0; i < 3000; ++i) {
+        gpointer v = obt_winmap_find(m, ((i % 3 + 1) << 21) | (i / 3 + 1));
+        if (v != (i % 2 ? &values[i] : NULL))
+            ++wrong;
+    }
+    EXPECT_UINT_EQ(0, wrong);
+
+    obt_winmap_free(m);
+
+    TEST_END();
+}
+
+void run_winmap_unittest() {
+    unittest_start_suite("winmap");
+
+    empty();
+    add_find_remove();
+    many();
+
+    unittest_end_suite();
+}
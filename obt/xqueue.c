@@ -19,8 +19,20 @@
 #include "obt/xqueue.h"
 #include "obt/display.h"
 
+#ifdef HAVE_STDIO_H
+#  include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#  include <string.h>
+#endif
+
 #define MINSZ 16
 
+/* The start of a trace file, followed by its version and sizeof(long), since
+   the events are written as they are in memory */
+#define TRACE_MAGIC "OBTTRACE"
+#define TRACE_VERSION 1
+
 static XEvent *q = NULL;
 static gulong qsz = 0;
 static gulong qstart; /* the first event in the queue */
@@ -86,6 +98,205 @@ static inline void grow(void) {
     }
 }
 
+static FILE *record_file = NULL;
+static gint64 record_start;
+
+static gint64 trace_time(void)
+{
+#if GLIB_CHECK_VERSION(2, 28, 0)
+    return g_get_monotonic_time();
+#else
+    GTimeVal now_tv;
+    g_get_current_time(&now_tv);
+    return now_tv.tv_sec * G_USEC_PER_SEC + now_tv.tv_usec;
+#endif
+}
+
+/* Only the part of the XEvent union used by the type of event is written */
+static gsize event_size(gint type)
+{
+    switch (type) {
+    case KeyPress:
+    case KeyRelease:       return sizeof(XKeyEvent);
+    case ButtonPress:
+    case ButtonRelease:    return sizeof(XButtonEvent);
+    case MotionNotify:     return sizeof(XMotionEvent);
+    case EnterNotify:
+    case LeaveNotify:      return sizeof(XCrossingEvent);
+    case FocusIn:
+    case FocusOut:         return sizeof(XFocusChangeEvent);
+    case Expose:           return sizeof(XExposeEvent);
+    case VisibilityNotify: return sizeof(XVisibilityEvent);
+    case CreateNotify:     return sizeof(XCreateWindowEvent);
+    case DestroyNotify:    return sizeof(XDestroyWindowEvent);
+    case UnmapNotify:      return sizeof(XUnmapEvent);
+    case MapNotify:        return sizeof(XMapEvent);
+    case MapRequest:       return sizeof(XMapRequestEvent);
+    case ReparentNotify:   return sizeof(XReparentEvent);
+    case ConfigureNotify:  return sizeof(XConfigureEvent);
+    case ConfigureRequest: return sizeof(XConfigureRequestEvent);
+    case GravityNotify:    return sizeof(XGravityEvent);
+    case CirculateNotify:  return sizeof(XCirculateEvent);
+    case CirculateRequest: return sizeof(XCirculateRequestEvent);
+    case PropertyNotify:   return sizeof(XPropertyEvent);
+    case SelectionClear:   return sizeof(XSelectionClearEvent);
+    case ColormapNotify:   return sizeof(XColormapEvent);
+    case ClientMessage:    return sizeof(XClientMessageEvent);
+    case MappingNotify:    return sizeof(XMappingEvent);
+    default:               return sizeof(XEvent);
+    }
+}
+
+static void record(guint16 kind, gconstpointer data, guint16 size)
+{
+    gint64 t = trace_time() - record_start;
+
+    if (fwrite(&t, sizeof(t), 1, record_file) != 1 ||
+        fwrite(&kind, sizeof(kind), 1, record_file) != 1 ||
+        fwrite(&size, sizeof(size), 1, record_file) != 1 ||
+        (size && fwrite(data, size, 1, record_file) != 1))
+    {
+        g_warning("Unable to write the X event trace, stopping it");
+        xqueue_record_stop();
+    }
+}
+
+gboolean xqueue_record_start(const gchar *path)
+{
+    const guint32 head[2] = { TRACE_VERSION, sizeof(long) };
+
+    xqueue_record_stop();
+
+    if (!(record_file = fopen(path, "wb")))
+        return FALSE;
+    if (fwrite(TRACE_MAGIC, strlen(TRACE_MAGIC), 1, record_file) != 1 ||
+        fwrite(head, sizeof(head), 1, record_file) != 1)
+    {
+        fclose(record_file);
+        record_file = NULL;
+        return FALSE;
+    }
+    record_start = trace_time();
+    return TRUE;
+}
+
+void xqueue_record_stop(void)
+{
+    if (record_file) {
+        fclose(record_file);
+        record_file = NULL;
+    }
+}
+
+gboolean xqueue_recording(void)
+{
+    return record_file != NULL;
+}
+
+void xqueue_record_event(const XEvent *e)
+{
+    if (record_file)
+        record(OBT_XQUEUE_TRACE_EVENT, e, event_size(e->type));
+}
+
+void xqueue_record_note(gconstpointer data, gsize size)
+{
+    g_return_if_fail(size <= G_MAXUINT16);
+
+    if (record_file)
+        record(OBT_XQUEUE_TRACE_NOTE, data, size);
+}
+
+struct _ObtXQueueTrace {
+    FILE *f;
+    gchar *note;
+    gsize note_size;
+};
+
+ObtXQueueTrace* xqueue_trace_open(const gchar *path)
+{
+    ObtXQueueTrace *t;
+    gchar magic[sizeof(TRACE_MAGIC) - 1];
+    guint32 head[2];
+    FILE *f;
+
+    if (!(f = fopen(path, "rb")))
+        return NULL;
+    if (fread(magic, sizeof(magic), 1, f) != 1 ||
+        memcmp(magic, TRACE_MAGIC, sizeof(magic)) ||
+        fread(head, sizeof(head), 1, f) != 1 ||
+        head[0] != TRACE_VERSION || head[1] != sizeof(long))
+    {
+        g_message("%s is not an X event trace which can be read here", path);
+        fclose(f);
+        return NULL;
+    }
+
+    t = g_slice_new(ObtXQueueTrace);
+    t->f = f;
+    t->note = NULL;
+    t->note_size = 0;
+    return t;
+}
+
+ObtXQueueTraceRecord xqueue_trace_read(ObtXQueueTrace *t, gint64 *time,
+                                       XEvent *e, gconstpointer *note,
+                                       gsize *note_size)
+{
+    guint16 kind, size;
+    gsize n;
+
+    /* the trace can only end between records */
+    if ((n = fread(time, 1, sizeof(*time), t->f)) == 0)
+        return OBT_XQUEUE_TRACE_END;
+    if (n != sizeof(*time) ||
+        fread(&kind, sizeof(kind), 1, t->f) != 1 ||
+        fread(&size, sizeof(size), 1, t->f) != 1)
+        return OBT_XQUEUE_TRACE_ERROR;
+
+    switch (kind) {
+    case OBT_XQUEUE_TRACE_EVENT:
+        if (size > sizeof(XEvent))
+            return OBT_XQUEUE_TRACE_ERROR;
+        memset(e, 0, sizeof(XEvent));
+        if (fread(e, size, 1, t->f) != 1)
+            return OBT_XQUEUE_TRACE_ERROR;
+        /* the pointer from the recording means nothing now */
+        e->xany.display = obt_display;
+        return OBT_XQUEUE_TRACE_EVENT;
+    case OBT_XQUEUE_TRACE_NOTE:
+        if (size > t->note_size) {
+            t->note = g_realloc(t->note, size);
+            t->note_size = size;
+        }
+        if (size && fread(t->note, size, 1, t->f) != 1)
+            return OBT_XQUEUE_TRACE_ERROR;
+        *note = t->note;
+        *note_size = size;
+        return OBT_XQUEUE_TRACE_NOTE;
+    default:
+        return OBT_XQUEUE_TRACE_ERROR;
+    }
+}
+
+void xqueue_trace_close(ObtXQueueTrace *t)
+{
+    if (t) {
+        fclose(t->f);
+        g_free(t->note);
+        g_slice_free(ObtXQueueTrace, t);
+    }
+}
+
+static inline void push(const XEvent *e)
+{
+    grow(); /* make sure there is room */
+
+    ++qnum;
+    qend = (qend + 1) % qsz; /* move the end */
+    q[qend] = *e; /* stick the event at the end */
+}
+
 /* Grab all pending X events */
 static gboolean read_events(gboolean block)
 {
@@ -100,11 +311,8 @@ static gboolean read_events(gboolean block)
         if (XNextEvent(obt_display, &e) != Success)
             return FALSE;
 
-        grow(); /* make sure there is room */
-
-        ++qnum;
-        qend = (qend + 1) % qsz; /* move the end */
-        q[qend] = e; /* stick the event at the end */
+        xqueue_record_event(&e);
+        push(&e);
 
         --n;
         sth = TRUE;
@@ -167,6 +375,7 @@ void xqueue_init(void)
 
 void xqueue_destroy(void)
 {
+    xqueue_record_stop();
     if (q == NULL) return;
     g_free(q);
     q = NULL;
@@ -400,16 +609,44 @@ typedef struct _ObtXQueueCB {
 static ObtXQueueCB *callbacks = NULL;
 static guint n_callbacks = 0;
 
+static const gchar *event_names[] = {
+    NULL, NULL,
+    "KeyPress", "KeyRelease", "ButtonPress", "ButtonRelease", "MotionNotify",
+    "EnterNotify", "LeaveNotify", "FocusIn", "FocusOut", "KeymapNotify",
+    "Expose", "GraphicsExpose", "NoExpose", "VisibilityNotify",
+    "CreateNotify", "DestroyNotify", "UnmapNotify", "MapNotify",
+    "MapRequest", "ReparentNotify", "ConfigureNotify", "ConfigureRequest",
+    "GravityNotify", "ResizeRequest", "CirculateNotify", "CirculateRequest",
+    "PropertyNotify", "SelectionClear", "SelectionRequest",
+    "SelectionNotify", "ColormapNotify", "ClientMessage", "MappingNotify",
+    "GenericEvent"
+};
+
+const gchar* xqueue_event_name(gint type)
+{
+    if (type >= 0 && type < (gint)G_N_ELEMENTS(event_names))
+        return event_names[type];
+    return NULL;
+}
+
+void xqueue_dispatch(const XEvent *e)
+{
+    guint i;
+
+    /* round trips made while handling the event are counted for it */
+    if (obt_roundtrip_on) obt_roundtrip_event(e->type);
+    for (i = 0; i < n_callbacks; ++i)
+        callbacks[i].func(e, callbacks[i].data);
+    if (obt_roundtrip_on) obt_roundtrip_event(0);
+}
+
 static gboolean event_read(GSource *source, GSourceFunc callback,
                            gpointer data)
 {
     XEvent ev;
 
-    while (xqueue_next_local(&ev)) {
-        guint i;
-        for (i = 0; i < n_callbacks; ++i)
-            callbacks[i].func(&ev, callbacks[i].data);
-    }
+    while (xqueue_next_local(&ev))
+        xqueue_dispatch(&ev);
 
     return TRUE; /* repeat */
 }
@@ -102,6 +102,48 @@ void xqueue_listen(void);
 void xqueue_add_callback(ObtXQueueFunc f, gpointer data);
 void xqueue_remove_callback(ObtXQueueFunc f, gpointer data);
 
+/*! Returns the name of a core X event type, or NULL for other types */
+const gchar* xqueue_event_name(gint type);
+
+/*! Pass an event to the registered callback functions */
+void xqueue_dispatch(const XEvent *e);
+
+typedef enum {
+    OBT_XQUEUE_TRACE_END,
+    OBT_XQUEUE_TRACE_EVENT,
+    OBT_XQUEUE_TRACE_NOTE,
+    OBT_XQUEUE_TRACE_ERROR
+} ObtXQueueTraceRecord;
+
+/*! Write every event read from the X server to the file at @path, with the
+  time it was read, so that it can be replayed later.  The file is only
+  readable on the same kind of machine that wrote it.  Returns FALSE if the
+  file could not be written. */
+gboolean xqueue_record_start(const gchar *path);
+void     xqueue_record_stop(void);
+gboolean xqueue_recording(void);
+
+/*! Add an event to the trace being recorded.  Events read from the X server
+  are added to it already. */
+void xqueue_record_event(const XEvent *e);
+
+/*! Add a note to the trace being recorded, between the events, for
+  whatever the program needs to know to replay them */
+void xqueue_record_note(gconstpointer data, gsize size);
+
+typedef struct _ObtXQueueTrace ObtXQueueTrace;
+
+ObtXQueueTrace* xqueue_trace_open(const gchar *path);
+void            xqueue_trace_close(ObtXQueueTrace *t);
+
+/*! Read the next thing from the trace.  Returns OBT_XQUEUE_TRACE_EVENT and
+  fills in @e, or returns OBT_XQUEUE_TRACE_NOTE and points @note at the note
+  until the next call.  @time is the microseconds since the recording
+  started. */
+ObtXQueueTraceRecord xqueue_trace_read(ObtXQueueTrace *t, gint64 *time,
+                                       XEvent *e, gconstpointer *note,
+                                       gsize *note_size);
+
 G_END_DECLS
 
 #endif
@@ -0,0 +1,189 @@
+#include "obt/unittest_base.h"
+
+#include "obt/xqueue.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static gchar* temp_file() {
+    gchar *path;
+    gint fd;
+
+    path = g_build_filename(g_get_tmp_dir(), "obt-xqueue-XXXXXX", NULL);
+    fd = g_mkstemp(path);
+    g_assert(fd >= 0);
+    close(fd);
+    return path;
+}
+
+static void write_trace(const gchar *path) {
+    XEvent e;
+
+    EXPECT_BOOL_EQ(TRUE, xqueue_record_start(path));
+    EXPECT_BOOL_EQ(TRUE, xqueue_recording());
+
+    memset(&e, 0, sizeof(e));
+    e.xclient.type = ClientMessage;
+    e.xclient.serial = 42;
+    e.xclient.window = 0x400001;
+    e.xclient.message_type = 300;
+    e.xclient.format = 32;
+    e.xclient.data.l[0] = 1;
+    e.xclient.data.l[4] = -1;
+    xqueue_record_event(&e);
+
+    xqueue_record_note("note", 5);
+
+    memset(&e, 0, sizeof(e));
+    e.xconfigure.type = ConfigureNotify;
+    e.xconfigure.window = 0x400002;
+    e.xconfigure.x = -10;
+    e.xconfigure.y = 20;
+    e.xconfigure.width = 300;
+    e.xconfigure.height = 200;
+    xqueue_record_event(&e);
+
+    /* An empty note is allowed, and doesn't stop the recording. */
+    xqueue_record_note(NULL, 0);
+    EXPECT_BOOL_EQ(TRUE, xqueue_recording());
+
+    xqueue_record_stop();
+    EXPECT_BOOL_EQ(FALSE, xqueue_recording());
+}
+
+static void round_trip() {
+    TEST_START();
+
+    gchar *path = temp_file();
+    ObtXQueueTrace *t;
+    XEvent e;
+    gconstpointer note;
+    gsize size;
+    gint64 time, last;
+
+    write_trace(path);
+
+    t = xqueue_trace_open(path);
+    EXPECT_BOOL_EQ(TRUE, t != NULL);
+    if (t) {
+        EXPECT_INT_EQ(OBT_XQUEUE_TRACE_EVENT,
+                      xqueue_trace_read(t, &time, &e, &note, &size));
+        EXPECT_INT_EQ(ClientMessage, e.type);
+        EXPECT_UINT_EQ(42, (guint)e.xclient.serial);
+        EXPECT_UINT_EQ(0x400001, (guint)e.xclient.window);
+        EXPECT_UINT_EQ(300, (guint)e.xclient.message_type);
+        EXPECT_INT_EQ(32, e.xclient.format);
+        EXPECT_INT_EQ(1, (gint)e.xclient.data.l[0]);
+        EXPECT_INT_EQ(-1, (gint)e.xclient.data.l[4]);
+        EXPECT_BOOL_EQ(TRUE, time >= 0);
+        last = time;
+
+        EXPECT_INT_EQ(OBT_XQUEUE_TRACE_NOTE,
+                      xqueue_trace_read(t, &time, &e, &note, &size));
+        EXPECT_UINT_EQ(5, (guint)size);
+        EXPECT_BOOL_EQ(TRUE, memcmp(note, "note", 5) == 0);
+        EXPECT_BOOL_EQ(TRUE, time >= last);
+        last = time;
+
+        EXPECT_INT_EQ(OBT_XQUEUE_TRACE_EVENT,
+                      xqueue_trace_read(t, &time, &e, &note, &size));
+        EXPECT_INT_EQ(ConfigureNotify, e.type);
+        EXPECT_UINT_EQ(0x400002, (guint)e.xconfigure.window);
+        EXPECT_INT_EQ(-10, e.xconfigure.x);
+        EXPECT_INT_EQ(20, e.xconfigure.y);
+        EXPECT_INT_EQ(300, e.xconfigure.width);
+        EXPECT_INT_EQ(200, e.xconfigure.height);
+        EXPECT_BOOL_EQ(TRUE, time >= last);
+
+        EXPECT_INT_EQ(OBT_XQUEUE_TRACE_NOTE,
+                      xqueue_trace_read(t, &time, &e, &note, &size));
+        EXPECT_UINT_EQ(0, (guint)size);
+
+        EXPECT_INT_EQ(OBT_XQUEUE_TRACE_END,
+                      xqueue_trace_read(t, &time, &e, &note, &size));
+
+        xqueue_trace_close(t);
+    }
+
+    g_unlink(path);
+    g_free(path);
+
+    TEST_END();
+}
+
+static void read_truncated(const gchar *path, gsize cut) {
+    gchar *contents;
+    gsize len;
+    ObtXQueueTrace *t;
+    XEvent e;
+    gconstpointer note;
+    gsize size;
+    gint64 time;
+
+    write_trace(path);
+
+    /* Cut the last record, the empty note, short. */
+    EXPECT_BOOL_EQ(TRUE, g_file_get_contents(path, &contents, &len, NULL));
+    EXPECT_BOOL_EQ(TRUE, g_file_set_contents(path, contents, len - cut, NULL));
+    g_free(contents);
+
+    t = xqueue_trace_open(path);
+    EXPECT_BOOL_EQ(TRUE, t != NULL);
+    if (t) {
+        EXPECT_INT_EQ(OBT_XQUEUE_TRACE_EVENT,
+                      xqueue_trace_read(t, &time, &e, &note, &size));
+        EXPECT_INT_EQ(OBT_XQUEUE_TRACE_NOTE,
+                      xqueue_trace_read(t, &time, &e, &note, &size));
+        EXPECT_INT_EQ(OBT_XQUEUE_TRACE_EVENT,
+                      xqueue_trace_read(t, &time, &e, &note, &size));
+        EXPECT_INT_EQ(OBT_XQUEUE_TRACE_ERROR,
+                      xqueue_trace_read(t, &time, &e, &note, &size));
+        xqueue_trace_close(t);
+    }
+}
+
+static void truncated() {
+    TEST_START();
+
+    gchar *path = temp_file();
+
+    /* The record is an 8 byte time, then 2 bytes each for its kind and
+       size.  Cut it in its size, and in its time. */
+    read_truncated(path, 2);
+    read_truncated(path, 8);
+
+    g_unlink(path);
+    g_free(path);
+
+    TEST_END();
+}
+
+static void not_a_trace() {
+    TEST_START();
+
+    gchar *path = temp_file();
+
+    /* An empty file. */
+    EXPECT_BOOL_EQ(TRUE, xqueue_trace_open(path) == NULL);
+
+    EXPECT_BOOL_EQ(TRUE, g_file_set_contents(path, "OBTTRACX\1\0\0\0\10\0\0\0",
+                                             16, NULL));
+    EXPECT_BOOL_EQ(TRUE, xqueue_trace_open(path) == NULL);
+
+    g_unlink(path);
+    g_free(path);
+
+    TEST_END();
+}
+
+void run_xqueue_unittest() {
+    unittest_start_suite("xqueue");
+
+    round_trip();
+    truncated();
+    not_a_trace();
+
+    unittest_end_suite();
+}
@@ -37,6 +37,9 @@ typedef enum {
     MATCH_TYPE_EXACT,
 } MatchType;
 
+/* the regex results saved for titles, before they are thrown out */
+#define TITLE_CACHE_MAX 1024
+
 typedef struct {
     MatchType type;
     union m {
@@ -44,35 +47,33 @@ typedef struct {
         GRegex *regex;
         gchar *exact;
     } m;
+    /* results of a regex for each title_serial it was checked against */
+    GHashTable *cache;
 } TypedMatch;
 
+/* the boolean states of a client which a query can test, packed into a
+   word so that all of them are tested at once */
+typedef enum {
+    QUERY_STATE_SHADED          = 1 << 0,
+    QUERY_STATE_MAXVERT         = 1 << 1,
+    QUERY_STATE_MAXHORZ         = 1 << 2,
+    QUERY_STATE_MAXFULL         = 1 << 3,
+    QUERY_STATE_ICONIC          = 1 << 4,
+    QUERY_STATE_FULLSCREEN      = 1 << 5,
+    QUERY_STATE_FOCUSED         = 1 << 6,
+    QUERY_STATE_FOCUSABLE       = 1 << 7,
+    QUERY_STATE_URGENT          = 1 << 8,
+    QUERY_STATE_UNDECORATED     = 1 << 9,
+    QUERY_STATE_OMNIPRESENT     = 1 << 10,
+    QUERY_STATE_DESKTOP_CURRENT = 1 << 11,
+    QUERY_STATE_DESKTOP_LAST    = 1 << 12
+} QueryState;
+
 typedef struct {
     QueryTarget target;
-    gboolean shaded_on;
-    gboolean shaded_off;
-    gboolean maxvert_on;
-    gboolean maxvert_off;
-    gboolean maxhorz_on;
-    gboolean maxhorz_off;
-    gboolean maxfull_on;
-    gboolean maxfull_off;
-    gboolean iconic_on;
-    gboolean iconic_off;
-    gboolean fullscreen_on;
-    gboolean fullscreen_off;
-    gboolean focused;
-    gboolean unfocused;
-    gboolean focusable;
-    gboolean nonfocusable;
-    gboolean urgent_on;
-    gboolean urgent_off;
-    gboolean decor_off;
-    gboolean decor_on;
-    gboolean omnipresent_on;
-    gboolean omnipresent_off;
-    gboolean desktop_current;
-    gboolean desktop_other;
-    gboolean desktop_last;
+    /* the states the query tests, and the values it wants them to have */
+    guint    state_mask;
+    guint    state_want;
     guint    desktop_number;
     guint    screendesktop_number;
     guint    client_monitor;
@@ -110,16 +111,15 @@ void action_if_startup(void)
 
 static inline void set_bool(xmlNodePtr node,
                             const char *name,
-                            gboolean *on,
-                            gboolean *off)
+                            Query *q,
+                            QueryState state)
 {
     xmlNodePtr n;
 
     if ((n = obt_xml_find_node(node, name))) {
+        q->state_mask |= state;
         if (obt_xml_node_bool(n))
-            *on = TRUE;
-        else
-            *off = TRUE;
+            q->state_want |= state;
     }
 }
 
@@ -136,6 +136,7 @@ static void setup_typed_match(TypedMatch *tm, xmlNodePtr n)
         } else if (type && !g_ascii_strcasecmp(type, "regex")) {
             tm->type = MATCH_TYPE_REGEX;
             tm->m.regex = g_regex_new(s, 0, 0, NULL);
+            tm->cache = g_hash_table_new(g_direct_hash, g_direct_equal);
         } else if (type && !g_ascii_strcasecmp(type, "exact")) {
             tm->type = MATCH_TYPE_EXACT;
             tm->m.exact = g_strdup(s);
@@ -153,6 +154,7 @@ static void free_typed_match(TypedMatch *tm)
         break;
     case MATCH_TYPE_REGEX:
         g_regex_unref(tm->m.regex);
+        g_hash_table_destroy(tm->cache);
         break;
     case MATCH_TYPE_EXACT:
         g_free(tm->m.exact);
@@ -177,34 +179,63 @@ static gboolean check_typed_match(TypedMatch *tm, const gchar *s)
     g_assert_not_reached();
 }
 
+/*! Like check_typed_match, for a client's title.  Regex results are saved
+  for the title, as running a ForEach checks every window's title, and the
+  titles rarely change between runs */
+static gboolean check_title_match(TypedMatch *tm, ObClient *c)
+{
+    gpointer r;
+    gboolean match;
+
+    if (tm->type != MATCH_TYPE_REGEX)
+        return check_typed_match(tm, c->original_title);
+
+    r = g_hash_table_lookup(tm->cache, GUINT_TO_POINTER(c->title_serial));
+    if (r)
+        return GPOINTER_TO_INT(r) - 1;
+
+    match = check_typed_match(tm, c->original_title);
+    /* stale titles are never looked up again, so just start over when
+       there are too many */
+    if (g_hash_table_size(tm->cache) >= TITLE_CACHE_MAX)
+        g_hash_table_remove_all(tm->cache);
+    g_hash_table_insert(tm->cache, GUINT_TO_POINTER(c->title_serial),
+                        GINT_TO_POINTER(match + 1));
+    return match;
+}
+
 static void setup_query(Options* o, xmlNodePtr node, QueryTarget target) {
     Query *q = g_slice_new0(Query);
     g_array_append_val(o->queries, q);
 
     q->target = target;
 
-    set_bool(node, "shaded", &q->shaded_on, &q->shaded_off);
-    set_bool(node, "maximized", &q->maxfull_on, &q->maxfull_off);
-    set_bool(node, "maximizedhorizontal", &q->maxhorz_on, &q->maxhorz_off);
-    set_bool(node, "maximizedvertical", &q->maxvert_on, &q->maxvert_off);
-    set_bool(node, "iconified", &q->iconic_on, &q->iconic_off);
-    set_bool(node, "fullscreen", &q->fullscreen_on, &q->fullscreen_off);
-    set_bool(node, "focused", &q->focused, &q->unfocused);
-    set_bool(node, "focusable", &q->focusable, &q->nonfocusable);
-    set_bool(node, "urgent", &q->urgent_on, &q->urgent_off);
-    set_bool(node, "undecorated", &q->decor_off, &q->decor_on);
-    set_bool(node, "omnipresent", &q->omnipresent_on, &q->omnipresent_off);
+    set_bool(node, "shaded", q, QUERY_STATE_SHADED);
+    set_bool(node, "maximized", q, QUERY_STATE_MAXFULL);
+    set_bool(node, "maximizedhorizontal", q, QUERY_STATE_MAXHORZ);
+    set_bool(node, "maximizedvertical", q, QUERY_STATE_MAXVERT);
+    set_bool(node, "iconified", q, QUERY_STATE_ICONIC);
+    set_bool(node, "fullscreen", q, QUERY_STATE_FULLSCREEN);
+    set_bool(node, "focused", q, QUERY_STATE_FOCUSED);
+    set_bool(node, "focusable", q, QUERY_STATE_FOCUSABLE);
+    set_bool(node, "urgent", q, QUERY_STATE_URGENT);
+    set_bool(node, "undecorated", q, QUERY_STATE_UNDECORATED);
+    set_bool(node, "omnipresent", q, QUERY_STATE_OMNIPRESENT);
 
     xmlNodePtr n;
     if ((n = obt_xml_find_node(node, "desktop"))) {
         gchar *s;
         if ((s = obt_xml_node_string(n))) {
-            if (!g_ascii_strcasecmp(s, "current"))
-                q->desktop_current = TRUE;
+            if (!g_ascii_strcasecmp(s, "current")) {
+                q->state_mask |= QUERY_STATE_DESKTOP_CURRENT;
+                q->state_want |= QUERY_STATE_DESKTOP_CURRENT;
+            }
             else if (!g_ascii_strcasecmp(s, "other"))
-                q->desktop_other = TRUE;
-            else if (!g_ascii_strcasecmp(s, "last"))
-                q->desktop_last = TRUE;
+                q->state_mask |= QUERY_STATE_DESKTOP_CURRENT;
+            else if (!g_ascii_strcasecmp(s, "last")) {
+                q->state_mask |= QUERY_STATE_DESKTOP_LAST;
+                q->state_want |= QUERY_STATE_DESKTOP_LAST;
+            }
             else
                 q->desktop_number = atoi(s);
             g_free(s);
@@ -338,10 +369,58 @@ static gboolean run_func_if(ObActionsData *data, gpointer options)
     return FALSE;
 }
 
+/*! Pack the client's states that queries test into a word */
+static guint query_state(ObClient *c)
+{
+    guint state = 0;
+
+    if (c->shaded) state |= QUERY_STATE_SHADED;
+    if (c->max_vert) state |= QUERY_STATE_MAXVERT;
+    if (c->max_horz) state |= QUERY_STATE_MAXHORZ;
+    if (c->max_vert && c->max_horz) state |= QUERY_STATE_MAXFULL;
+    if (c->iconic) state |= QUERY_STATE_ICONIC;
+    if (c->fullscreen) state |= QUERY_STATE_FULLSCREEN;
+    if (c == focus_client) state |= QUERY_STATE_FOCUSED;
+    if (c->can_focus) state |= QUERY_STATE_FOCUSABLE;
+    if (c->urgent || c->demands_attention) state |= QUERY_STATE_URGENT;
+    if (c->undecorated || !(c->decorations & OB_FRAME_DECOR_TITLEBAR))
+        state |= QUERY_STATE_UNDECORATED;
+    if (c->desktop == DESKTOP_ALL)
+        state |= QUERY_STATE_OMNIPRESENT;
+    if (c->desktop == screen_desktop || c->desktop == DESKTOP_ALL)
+        state |= QUERY_STATE_DESKTOP_CURRENT;
+    if (c->desktop == screen_last_desktop)
+        state |= QUERY_STATE_DESKTOP_LAST;
+    return state;
+}
+
+/*! Test a query against a client, doing the cheap tests first, and only
+  matching strings when they pass */
+static gboolean query_match(Query *q, ObClient *c, guint state)
+{
+    if ((state & q->state_mask) != q->state_want)
+        return FALSE;
+
+    if (q->desktop_number &&
+        c->desktop != q->desktop_number - 1 && c->desktop != DESKTOP_ALL)
+        return FALSE;
+
+    if (q->client_monitor && client_monitor(c) != q->client_monitor - 1)
+        return FALSE;
+
+    return (check_title_match(&q->title, c) &&
+            check_typed_match(&q->class, c->class) &&
+            check_typed_match(&q->name, c->name) &&
+            check_typed_match(&q->role, c->role) &&
+            check_typed_match(&q->type, client_type_to_string(c)));
+}
+
 static gboolean run_func_if_internal(ObActionsData *data, gpointer options)
 {
     Options *o = options;
     ObClient *action_target = data->client;
+    ObClient *state_client = NULL;
+    guint state = 0;
     gboolean is_true = TRUE;
 
     guint i;
@@ -367,98 +446,16 @@ static gboolean run_func_if_internal(ObActionsData *data, gpointer options)
             if (q->screendesktop_number)
                 continue;
             is_true = FALSE;
-            break;            
+            break;
         }
 
-        if (q->shaded_on)
-            is_true &= query_target->shaded;
-        if (q->shaded_off)
-            is_true &= !query_target->shaded;
-
-        if (q->iconic_on)
-            is_true &= query_target->iconic;
-        if (q->iconic_off)
-            is_true &= !query_target->iconic;
-
-        if (q->fullscreen_on)
-            is_true &= query_target->fullscreen;
-        if (q->fullscreen_off)
-            is_true &= !query_target->fullscreen;
-
-        if (q->maxhorz_on)
-            is_true &= query_target->max_horz;
-        if (q->maxhorz_off)
-            is_true &= !query_target->max_horz;
-
-        if (q->maxvert_on)
-            is_true &= query_target->max_vert;
-        if (q->maxvert_off)
-            is_true &= !query_target->max_vert;
-
-        gboolean is_max_full =
-            query_target->max_vert && query_target->max_horz;
-        if (q->maxfull_on)
-            is_true &= is_max_full;
-        if (q->maxfull_off)
-            is_true &= !is_max_full;
-
-        if (q->focused)
-            is_true &= query_target == focus_client;
-        if (q->unfocused)
-            is_true &= query_target != focus_client;
-
-        if (q->focusable)
-            is_true &= query_target->can_focus;
-        if (q->nonfocusable)
-            is_true &= !query_target->can_focus;
-
-        gboolean is_urgent =
-            query_target->urgent || query_target->demands_attention;
-        if (q->urgent_on)
-            is_true &= is_urgent;
-        if (q->urgent_off)
-            is_true &= !is_urgent;
-
-        gboolean has_visible_title_bar =
-            !query_target->undecorated &&
-            (query_target->decorations & OB_FRAME_DECOR_TITLEBAR);
-        if (q->decor_on)
-            is_true &= has_visible_title_bar;
-        if (q->decor_off)
-            is_true &= !has_visible_title_bar;
-
-        if (q->omnipresent_on)
-            is_true &= query_target->desktop == DESKTOP_ALL;
-        if (q->omnipresent_off)
-            is_true &= query_target->desktop != DESKTOP_ALL;
-
-        gboolean is_on_current_desktop =
-            query_target->desktop == screen_desktop ||
-            query_target->desktop == DESKTOP_ALL;
-        if (q->desktop_current)
-            is_true &= is_on_current_desktop;
-        if (q->desktop_other)
-            is_true &= !is_on_current_desktop;
-        if (q->desktop_last)
-            is_true &= query_target->desktop == screen_last_desktop;
-
-        if (q->desktop_number) {
-            gboolean is_on_desktop =
-                query_target->desktop == q->desktop_number - 1 ||
-                query_target->desktop == DESKTOP_ALL;
-            is_true &= is_on_desktop;
+        /* the queries usually all look at the same client */
+        if (query_target != state_client) {
+            state_client = query_target;
+            state = query_state(query_target);
         }
 
-        is_true &= check_typed_match(&q->title, query_target->original_title);
-        is_true &= check_typed_match(&q->class, query_target->class);
-        is_true &= check_typed_match(&q->name, query_target->name);
-        is_true &= check_typed_match(&q->role, query_target->role);
-        is_true &= check_typed_match(&q->type,
-                                     client_type_to_string(query_target));
-
-        if (q->client_monitor)
-            is_true &= client_monitor(query_target) == q->client_monitor - 1;
-
+        is_true &= query_match(q, query_target, state);
     }
 
     GSList *acts;
@@ -476,13 +473,13 @@ static gboolean run_func_if_internal(ObActionsData *data, gpointer options)
 
 static gboolean run_func_foreach(ObActionsData *data, gpointer options)
 {
-    GList *it;
+    guint i;
 
     foreach_stop = FALSE;
     gboolean was_true = FALSE;
 
-    for (it = client_list; it; it = g_list_next(it)) {
-        data->client = it->data;
+    for (i = 0; i < client_array.num; ++i) {
+        data->client = client_array.client[i];
         was_true |= run_func_if_internal(data, options);
         if (foreach_stop) {
             foreach_stop = FALSE;
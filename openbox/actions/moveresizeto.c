@@ -100,7 +100,7 @@ static gboolean run_func(ObActionsData *data, gpointer options)
     Options *o = options;
 
     if (data->client) {
-        Rect *area, *carea;
+        Rect area, carea;
         ObClient *c;
         guint mon, cmon;
         gint x, y, lw, lh, w, h;
@@ -122,8 +122,8 @@ static gboolean run_func(ObActionsData *data, gpointer options)
             break;
         }
 
-        area = screen_area(c->desktop, mon, NULL);
-        carea = screen_area(c->desktop, cmon, NULL);
+        screen_area(c->desktop, mon, NULL, &area);
+        screen_area(c->desktop, cmon, NULL, &carea);
 
         /* find a target size for the client/frame. */
         w = o->w;
@@ -134,7 +134,7 @@ static gboolean run_func(ObActionsData *data, gpointer options)
                 w = c->frame->area.width;
         }
         else if (o->w_denom) /* used for eg. "1/3" or "55%" */
-            w = (w * area->width) / o->w_denom;
+            w = (w * area.width) / o->w_denom;
 
         h = o->h;
         if (h == G_MININT) {
@@ -144,7 +144,7 @@ static gboolean run_func(ObActionsData *data, gpointer options)
                 h = c->frame->area.height;
         }
         else if (o->h_denom)
-            h = (h * area->height) / o->h_denom;
+            h = (h * area.height) / o->h_denom;
 
         /* get back to the client's size. */
         if (!o->w_sets_client_size)
@@ -165,23 +165,23 @@ static gboolean run_func(ObActionsData *data, gpointer options)
         /* get the position */
         x = o->x.pos;
         if (o->x.denom) /* relative positions */
-            x = (x * area->width) / o->x.denom;
-        if (o->x.center) x = (area->width - w) / 2;
+            x = (x * area.width) / o->x.denom;
+        if (o->x.center) x = (area.width - w) / 2;
         else if (x == G_MININT) /* not specified */
-            x = c->frame->area.x - carea->x;
+            x = c->frame->area.x - carea.x;
         else if (o->x.opposite) /* value relative to right edge instead of left */
-            x = area->width - w - x;
-        x += area->x;
+            x = area.width - w - x;
+        x += area.x;
 
         y = o->y.pos;
         if (o->y.denom)
-            y = (y * area->height) / o->y.denom;
-        if (o->y.center) y = (area->height - h) / 2;
+            y = (y * area.height) / o->y.denom;
+        if (o->y.center) y = (area.height - h) / 2;
         else if (y == G_MININT)
-            y = c->frame->area.y - carea->y;
+            y = c->frame->area.y - carea.y;
         else if (o->y.opposite)
-            y = area->height - h - y;
-        y += area->y;
+            y = area.height - h - y;
+        y += area.y;
 
         /* get the client's size back */
         w -= c->frame->size.left + c->frame->size.right;
@@ -195,9 +195,6 @@ static gboolean run_func(ObActionsData *data, gpointer options)
         actions_client_move(data, TRUE);
         client_configure(c, x, y, w, h, TRUE, TRUE, FALSE);
         actions_client_move(data, FALSE);
-
-        g_slice_free(Rect, area);
-        g_slice_free(Rect, carea);
     }
 
     return FALSE;
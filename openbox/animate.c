@@ -0,0 +1,224 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   animate.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "animate.h"
+#include "openbox.h"
+#include "debug.h"
+#include "obt/display.h"
+
+/* used when the refresh rate of the screen can't be found */
+#define ANIMATE_DEFAULT_RATE 60
+/* don't believe refresh rates outside of this range */
+#define ANIMATE_MIN_RATE 20
+#define ANIMATE_MAX_RATE 240
+
+typedef struct _ObAnimation
+{
+    ObAnimateStepFunc step;
+    gpointer data;
+    GDestroyNotify done;
+    /* set once the animation has finished, it is removed from the list at
+       the end of the current frame */
+    gboolean dead;
+} ObAnimation;
+
+static GSList  *animations = NULL;
+static guint    tick_timer = 0;
+/* the length of one frame, in microseconds */
+static gint64   frame_usec = G_USEC_PER_SEC / ANIMATE_DEFAULT_RATE;
+/* the time at which the next frame is due to be shown */
+static gint64   next_frame_usec = 0;
+/* true while stepping through the animations */
+static gboolean ticking = FALSE;
+
+static void schedule_tick(gint64 now_usec);
+static gboolean tick(gpointer data);
+
+void animate_startup(gboolean reconfigure)
+{
+    if (reconfigure) return;
+
+    animate_update_refresh_rate();
+}
+
+void animate_shutdown(gboolean reconfigure)
+{
+    if (reconfigure) return;
+
+    while (animations) {
+        ObAnimation *a = animations->data;
+        animate_stop(a->step, a->data);
+    }
+
+    if (tick_timer) g_source_remove(tick_timer);
+    tick_timer = 0;
+}
+
+gint64 animate_time(void)
+{
+#if GLIB_CHECK_VERSION(2, 28, 0)
+    return g_get_monotonic_time();
+#else
+    GTimeVal now_tv;
+    g_get_current_time(&now_tv);
+    return now_tv.tv_sec * G_USEC_PER_SEC + now_tv.tv_usec;
+#endif
+}
+
+gint64 animate_frame_time(void)
+{
+    return frame_usec;
+}
+
+void animate_update_refresh_rate(void)
+{
+    gint rate = 0;
+
+#ifdef XRANDR
+    if (obt_display_extension_randr) {
+        XRRScreenConfiguration *conf;
+
+        OBT_ROUNDTRIP("RRGetScreenInfo");
+        conf = XRRGetScreenInfo(obt_display, obt_root(ob_screen));
+        if (conf) {
+            rate = XRRConfigCurrentRate(conf);
+            XRRFreeScreenConfigInfo(conf);
+        }
+    }
+#endif
+
+    if (rate < ANIMATE_MIN_RATE || rate > ANIMATE_MAX_RATE)
+        rate = ANIMATE_DEFAULT_RATE;
+    frame_usec = G_USEC_PER_SEC / rate;
+
+    ob_debug("Animating at %d frames per second", rate);
+}
+
+static ObAnimation* find_animation(ObAnimateStepFunc step, gpointer data)
+{
+    GSList *it;
+
+    for (it = animations; it; it = g_slist_next(it)) {
+        ObAnimation *a = it->data;
+        if (!a->dead && a->step == step && a->data == data)
+            return a;
+    }
+    return NULL;
+}
+
+void animate_start(ObAnimateStepFunc step, gpointer data, GDestroyNotify done)
+{
+    ObAnimation *a;
+
+    g_assert(find_animation(step, data) == NULL);
+
+    a = g_slice_new0(ObAnimation);
+    a->step = step;
+    a->data = data;
+    a->done = done;
+    animations = g_slist_append(animations, a);
+
+    /* tick() will schedule the next frame itself if it is running */
+    if (!tick_timer && !ticking)
+        schedule_tick(animate_time());
+}
+
+static void animation_free(ObAnimation *a)
+{
+    animations = g_slist_remove(animations, a);
+    g_slice_free(ObAnimation, a);
+}
+
+gboolean animate_stop(ObAnimateStepFunc step, gpointer data)
+{
+    ObAnimation *a;
+
+    if (!(a = find_animation(step, data)))
+        return FALSE;
+
+    /* mark it before calling done, so that it won't be found again if the
+       done function tries to stop it too */
+    a->dead = TRUE;
+    if (a->done) a->done(a->data);
+
+    /* don't change the list while tick() is walking through it */
+    if (!ticking)
+        animation_free(a);
+    return TRUE;
+}
+
+gboolean animate_running(ObAnimateStepFunc step, gpointer data)
+{
+    return find_animation(step, data) != NULL;
+}
+
+static void schedule_tick(gint64 now_usec)
+{
+    gint64 wait;
+
+    /* line the frames up with the refresh rate.  if we fell behind, skip
+       over the frames that were missed instead of trying to catch up on
+       them, as the animations find their state from the time anyways */
+    if (next_frame_usec <= now_usec) {
+        if (next_frame_usec + frame_usec <= now_usec)
+            /* we're more than a frame late (or starting fresh), so restart
+               the frame timing from right now */
+            next_frame_usec = now_usec + frame_usec;
+        else
+            next_frame_usec += frame_usec;
+    }
+
+    wait = (next_frame_usec - now_usec + 999) / 1000; /* round up to ms */
+    tick_timer = g_timeout_add_full(G_PRIORITY_DEFAULT, (guint)wait,
+                                    tick, NULL, NULL);
+}
+
+static gboolean tick(gpointer data)
+{
+    GSList *it, *next;
+    gint64 now_usec;
+
+    tick_timer = 0;
+    now_usec = animate_time();
+
+    ticking = TRUE;
+    for (it = animations; it; it = g_slist_next(it)) {
+        ObAnimation *a = it->data;
+
+        if (!a->dead && !a->step(now_usec, a->data)) {
+            a->dead = TRUE;
+            if (a->done) a->done(a->data);
+        }
+    }
+    ticking = FALSE;
+
+    for (it = animations; it; it = next) {
+        ObAnimation *a = it->data;
+        next = g_slist_next(it);
+        if (a->dead) animation_free(a);
+    }
+
+    /* send all the frames' changes at once */
+    XFlush(obt_display);
+
+    /* find the time again, in case the flush blocked on a slow server */
+    if (animations)
+        schedule_tick(animate_time());
+
+    return FALSE; /* a new timer is set for each frame */
+}
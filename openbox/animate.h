@@ -0,0 +1,62 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   animate.h for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __animate_h
+#define __animate_h
+
+#include <glib.h>
+
+/*! Advance an animation to the given time.
+  The step function should only queue X requests, the animation engine
+  flushes once for all the animations that ran in the same frame.
+  @param now_usec The monotonic time for this frame, in microseconds, as
+                  returned by animate_time()
+  @return TRUE to keep animating, FALSE when the animation is finished
+*/
+typedef gboolean (*ObAnimateStepFunc)(gint64 now_usec, gpointer data);
+
+void animate_startup(gboolean reconfigure);
+void animate_shutdown(gboolean reconfigure);
+
+/*! Returns the current monotonic time in microseconds.  Animations should
+  measure their progress against this clock, as it does not jump when the
+  wall clock is changed. */
+gint64 animate_time(void);
+
+/*! Returns the length of one frame on the screen, in microseconds */
+gint64 animate_frame_time(void);
+
+/*! Start an animation.  The step function is called once per monitor refresh
+  until it returns FALSE or the animation is stopped, at which point the done
+  function is called with the data.  If the X server falls behind, frames are
+  dropped rather than queued, so the step function must compute its state
+  from the time it is given rather than counting its calls. */
+void animate_start(ObAnimateStepFunc step, gpointer data, GDestroyNotify done);
+
+/*! Stop an animation before it finishes.  Its done function is called.
+  @return TRUE if the animation was running */
+gboolean animate_stop(ObAnimateStepFunc step, gpointer data);
+
+/*! Returns TRUE if the animation is currently running */
+gboolean animate_running(ObAnimateStepFunc step, gpointer data);
+
+/*! Find the refresh rate of the screen again, to pace the animations.  Call
+  this when the screen's configuration changes. */
+void animate_update_refresh_rate(void);
+
+#endif
@@ -38,6 +38,7 @@
 #include "config.h"
 #include "menuframe.h"
 #include "keyboard.h"
+#include "client_list_menu.h"
 #include "mouse.h"
 #include "obrender/render.h"
 #include "gettext.h"
@@ -52,6 +53,9 @@
 #ifdef HAVE_SIGNAL_H
 #  include <signal.h> /* for kill() */
 #endif
+#ifdef HAVE_STRING_H
+#  include <string.h>
+#endif
 
 #include <glib.h>
 #include <X11/Xutil.h>
@@ -70,9 +74,17 @@ typedef struct
 } ClientCallback;
 
 GList          *client_list             = NULL;
+ObClientArray   client_array            = { NULL };
 
 static GSList  *client_destroy_notifies = NULL;
+/* the clients on each desktop, indexed by desktop.  this grows as needed, so
+   it may be longer than the number of desktops */
+static GList  **client_desktop_lists    = NULL;
+static guint    client_num_desktop_lists = 0;
+/* the clients on all desktops */
+static GList   *client_omnipresent_list = NULL;
 static RrImage *client_default_icon     = NULL;
+static guint    client_title_serial     = 0;
 
 static void client_get_all(ObClient *self, gboolean real);
 static void client_get_startup_id(ObClient *self);
@@ -132,6 +144,116 @@ void client_shutdown(gboolean reconfig)
     client_default_icon = NULL;
 
     if (reconfig) return;
+
+    g_free(client_desktop_lists);
+    client_desktop_lists = NULL;
+    client_num_desktop_lists = 0;
+
+    g_free(client_array.client);
+    g_free(client_array.area);
+    g_free(client_array.desktop);
+    g_free(client_array.flags);
+    client_array.client = NULL;
+    client_array.area = NULL;
+    client_array.desktop = NULL;
+    client_array.flags = NULL;
+    client_array.num = client_array.size = 0;
+}
+
+static GList** desktop_list_head(guint desktop)
+{
+    if (desktop == DESKTOP_ALL)
+        return &client_omnipresent_list;
+
+    if (desktop >= client_num_desktop_lists) {
+        guint i, num = MAX(desktop + 1, screen_num_desktops);
+
+        client_desktop_lists = g_renew(GList*, client_desktop_lists, num);
+        for (i = client_num_desktop_lists; i < num; ++i)
+            client_desktop_lists[i] = NULL;
+        client_num_desktop_lists = num;
+    }
+    return &client_desktop_lists[desktop];
+}
+
+GList* client_desktop_list(guint desktop)
+{
+    if (desktop != DESKTOP_ALL && desktop >= client_num_desktop_lists)
+        return NULL;
+    return *desktop_list_head(desktop);
+}
+
+static void client_desktop_list_add(ObClient *self)
+{
+    GList **head = desktop_list_head(self->desktop);
+
+    g_assert(self->desktop_link == NULL);
+
+    *head = g_list_prepend(*head, self);
+    self->desktop_link = *head;
+}
+
+static void client_desktop_list_remove(ObClient *self)
+{
+    GList **head = desktop_list_head(self->desktop);
+
+    g_assert(self->desktop_link != NULL);
+
+    *head = g_list_delete_link(*head, self->desktop_link);
+    self->desktop_link = NULL;
+}
+
+static void client_array_add(ObClient *self)
+{
+    g_assert(self->array_index < 0);
+
+    if (client_array.num == client_array.size) {
+        client_array.size = MAX(16, client_array.size * 2);
+        client_array.client = g_renew(ObClient*, client_array.client,
+                                      client_array.size);
+        client_array.area = g_renew(Rect, client_array.area,
+                                    client_array.size);
+        client_array.desktop = g_renew(guint, client_array.desktop,
+                                       client_array.size);
+        client_array.flags = g_renew(guint8, client_array.flags,
+                                     client_array.size);
+    }
+    self->array_index = client_array.num++;
+    client_array.client[self->array_index] = self;
+    client_array_update(self);
+}
+
+static void client_array_remove(ObClient *self)
+{
+    guint i = self->array_index, n;
+
+    g_assert(self->array_index >= 0);
+
+    /* keep the order the same as client_list's */
+    n = --client_array.num - i;
+    memmove(&client_array.client[i], &client_array.client[i+1],
+            n * sizeof(ObClient*));
+    memmove(&client_array.area[i], &client_array.area[i+1],
+            n * sizeof(Rect));
+    memmove(&client_array.desktop[i], &client_array.desktop[i+1],
+            n * sizeof(guint));
+    memmove(&client_array.flags[i], &client_array.flags[i+1],
+            n * sizeof(guint8));
+    for (; i < client_array.num; ++i)
+        client_array.client[i]->array_index = i;
+    self->array_index = -1;
+}
+
+void client_array_update(ObClient *self)
+{
+    gint i = self->array_index;
+
+    /* not managed yet, or it's a fake client */
+    if (i < 0) return;
+
+    client_array.area[i] = self->frame->area;
+    client_array.desktop[i] = self->desktop;
+    client_array.flags[i] = (self->iconic ? OB_CLIENT_ARRAY_ICONIC : 0);
 }
 
 static void client_call_notifies(ObClient *self, GSList *list)
@@ -184,16 +306,14 @@ void client_remove_destroy_notify_data(ObClientCallback func, gpointer data)
 
 void client_set_list(void)
 {
-    Window *windows, *win_it;
-    GList *it;
-    guint size = g_list_length(client_list);
+    Window *windows;
+    guint i, size = client_array.num;
 
     /* create an array of the window ids */
     if (size > 0) {
         windows = g_new(Window, size);
-        win_it = windows;
-        for (it = client_list; it; it = g_list_next(it), ++win_it)
-            *win_it = ((ObClient*)it->data)->window;
+        for (i = 0; i < size; ++i)
+            windows[i] = client_array.client[i]->window;
     } else
         windows = NULL;
 
@@ -243,6 +363,7 @@ void client_manage(Window window, ObPrompt *prompt)
     self->gravity = NorthWestGravity;
     self->desktop = screen_num_desktops; /* always an invalid value */
     self->monitor = -1;
+    self->array_index = -1;
 
     /* get all the stuff off the window */
     client_get_all(self, TRUE);
@@ -381,15 +502,14 @@ void client_manage(Window window, ObPrompt *prompt)
             /* oldschool fullscreen windows are allowed */
             !client_is_oldfullscreen(self, &place))
         {
-            Rect *r;
+            Rect r;
 
-            r = screen_area(self->desktop, SCREEN_AREA_ALL_MONITORS, NULL);
-            if (r->x || r->y) {
-                place.x = r->x;
-                place.y = r->y;
-                ob_debug("Moving buggy app from (0,0) to (%d,%d)", r->x, r->y);
+            screen_area(self->desktop, SCREEN_AREA_ALL_MONITORS, NULL, &r);
+            if (r.x || r.y) {
+                place.x = r.x;
+                place.y = r.y;
+                ob_debug("Moving buggy app from (0,0) to (%d,%d)", r.x, r.y);
             }
-            g_slice_free(Rect, r);
         }
 
         /* make sure the window is visible. */
@@ -443,23 +563,23 @@ void client_manage(Window window, ObPrompt *prompt)
              fit the screen but it is not USSize'd or USPosition'd) */
           !client_is_oldfullscreen(self, &place))))
     {
-        Rect *a = screen_area(self->desktop, SCREEN_AREA_ONE_MONITOR, &place);
+        Rect a;
+
+        screen_area(self->desktop, SCREEN_AREA_ONE_MONITOR, &place, &a);
 
         /* get the size of the frame */
         place.width += self->frame->size.left + self->frame->size.right;
         place.height += self->frame->size.top + self->frame->size.bottom;
 
         /* fit the window inside the area */
-        place.width = MIN(place.width, a->width);
-        place.height = MIN(place.height, a->height);
+        place.width = MIN(place.width, a.width);
+        place.height = MIN(place.height, a.height);
 
         ob_debug("setting window size to %dx%d", place.width, place.height);
 
         /* get the size of the client back */
         place.width -= self->frame->size.left + self->frame->size.right;
         place.height -= self->frame->size.top + self->frame->size.bottom;
-
-        g_slice_free(Rect, a);
     }
 
     ob_debug("placing window 0x%x at %d, %d with size %d x %d. "
@@ -525,6 +645,8 @@ void client_manage(Window window, ObPrompt *prompt)
 
     /* add to client list/map */
     client_list = g_list_append(client_list, self);
+    client_array_add(self);
+    client_desktop_list_add(self);
     window_add(&self->window, CLIENT_AS_WINDOW(self));
 
     /* this has to happen after we're in the client_list */
@@ -552,6 +674,7 @@ ObClient *client_fake_manage(Window window)
 
     self = g_slice_new0(ObClient);
     self->window = window;
+    self->array_index = -1;
 
     client_get_all(self, FALSE);
     /* per-app settings override stuff, and return the settings for other
@@ -627,6 +750,10 @@ void client_unmanage(ObClient *self)
     self->kill_prompt = NULL;
 
     client_list = g_list_remove(client_list, self);
+    client_array_remove(self);
+    client_desktop_list_remove(self);
+    if (self->session)
+        session_state_release(self->session);
     stacking_remove(CLIENT_AS_WINDOW(self));
     window_remove(self->window);
 
@@ -729,6 +856,7 @@ void client_unmanage(ObClient *self)
     g_free(self->group_class);
     g_free(self->client_machine);
     g_free(self->sm_client_id);
+    client_resize_session_end(self);
     g_slice_free(ObClient, self);
 }
 
@@ -1003,19 +1131,15 @@ static ObAppSettings *client_get_settings_state(ObClient *self)
 
 static void client_restore_session_state(ObClient *self)
 {
-    GList *it;
-
     ob_debug_type(OB_DEBUG_SM,
                   "Restore session for client %s", self->title);
 
-    if (!(it = session_state_find(self))) {
+    if (!(self->session = session_state_find(self))) {
         ob_debug_type(OB_DEBUG_SM,
                       "Session data not found for client %s", self->title);
         return;
     }
 
-    self->session = it->data;
-
     ob_debug_type(OB_DEBUG_SM, "Session data loaded for client %s",
                   self->title);
 
@@ -1048,28 +1172,15 @@ static void client_restore_session_state(ObClient *self)
 
 static gboolean client_restore_session_stacking(ObClient *self)
 {
-    GList *it, *mypos;
+    ObClient *above;
 
     if (!self->session) return FALSE;
 
-    mypos = g_list_find(session_saved_state, self->session);
-    if (!mypos) return FALSE;
-
-    /* start above me and look for the first client */
-    for (it = g_list_previous(mypos); it; it = g_list_previous(it)) {
-        GList *cit;
+    /* go below the nearest window above me in the session */
+    if (!(above = session_state_above(self->session))) return FALSE;
 
-        for (cit = client_list; cit; cit = g_list_next(cit)) {
-            ObClient *c = cit->data;
-            /* found a client that was in the session, so go below it */
-            if (c->session == it->data) {
-                stacking_below(CLIENT_AS_WINDOW(self),
-                               CLIENT_AS_WINDOW(cit->data));
-                return TRUE;
-            }
-        }
-    }
-    return FALSE;
+    stacking_below(CLIENT_AS_WINDOW(self), CLIENT_AS_WINDOW(above));
+    return TRUE;
 }
 
 void client_move_onscreen(ObClient *self, gboolean rude)
@@ -1148,7 +1259,7 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
     */
     found_mon = FALSE;
     for (i = 0; i < screen_num_monitors; ++i) {
-        Rect *a;
+        Rect a;
 
         if (!screen_physical_area_monitor_contains(i, &desired)) {
             if (i < screen_num_monitors - 1 || found_mon)
@@ -1156,10 +1267,10 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
 
             /* the window is not inside any monitor! so just use the first
                one */
-            a = screen_area(self->desktop, 0, NULL);
+            screen_area(self->desktop, 0, NULL, &a);
         } else {
             found_mon = TRUE;
-            a = screen_area(self->desktop, SCREEN_AREA_ONE_MONITOR, &desired);
+            screen_area(self->desktop, SCREEN_AREA_ONE_MONITOR, &desired, &a);
         }
 
         /* This makes sure windows aren't entirely outside of the screen so you
@@ -1170,14 +1281,14 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
            only limiting the application.
         */
         if (client_normal(self)) {
-            if (!self->strut.right && *x + fw/10 >= a->x + a->width - 1)
-                *x = a->x + a->width - fw/10;
-            if (!self->strut.bottom && *y + fh/10 >= a->y + a->height - 1)
-                *y = a->y + a->height - fh/10;
-            if (!self->strut.left && *x + fw*9/10 - 1 < a->x)
-                *x = a->x - fw*9/10;
-            if (!self->strut.top && *y + fh*9/10 - 1 < a->y)
-                *y = a->y - fh*9/10;
+            if (!self->strut.right && *x + fw/10 >= a.x + a.width - 1)
+                *x = a.x + a.width - fw/10;
+            if (!self->strut.bottom && *y + fh/10 >= a.y + a.height - 1)
+                *y = a.y + a.height - fh/10;
+            if (!self->strut.left && *x + fw*9/10 - 1 < a.x)
+                *x = a.x - fw*9/10;
+            if (!self->strut.top && *y + fh*9/10 - 1 < a.y)
+                *y = a.y - fh*9/10;
         }
 
         /* This here doesn't let windows even a pixel outside the
@@ -1186,15 +1297,13 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
            xterm -geometry resolution-width/2 will work fine. Trying to
            place it completely offscreen will be handled in the above code.
            Sorry for this confused comment, i am tired. */
-        if (rudel && !self->strut.left && *x < a->x) *x = a->x;
-        if (ruder && !self->strut.right && *x + fw > a->x + a->width)
-            *x = a->x + MAX(0, a->width - fw);
-
-        if (rudet && !self->strut.top && *y < a->y) *y = a->y;
-        if (rudeb && !self->strut.bottom && *y + fh > a->y + a->height)
-            *y = a->y + MAX(0, a->height - fh);
+        if (rudel && !self->strut.left && *x < a.x) *x = a.x;
+        if (ruder && !self->strut.right && *x + fw > a.x + a.width)
+            *x = a.x + MAX(0, a.width - fw);
 
-        g_slice_free(Rect, a);
+        if (rudet && !self->strut.top && *y < a.y) *y = a.y;
+        if (rudeb && !self->strut.bottom && *y + fh > a.y + a.height)
+            *y = a.y + MAX(0, a.height - fh);
     }
 
     /* get where the client should be */
@@ -1279,6 +1388,7 @@ static void client_get_area(ObClient *self)
     XWindowAttributes wattrib;
     Status ret;
 
+    OBT_ROUNDTRIP("GetWindowAttributes");
     ret = XGetWindowAttributes(obt_display, self->window, &wattrib);
     g_assert(ret != BadWindow);
 
@@ -1392,11 +1502,13 @@ static void client_get_shaped(ObClient *self)
 
         XShapeSelectInput(obt_display, self->window, ShapeNotifyMask);
 
+        OBT_ROUNDTRIP("ShapeQueryExtents");
         XShapeQueryExtents(obt_display, self->window, &s, &foo,
                            &foo, &ufoo, &ufoo, &foo, &foo, &foo, &ufoo,
                            &ufoo);
         self->shaped = !!s;
 #ifdef ShapeInput
+        OBT_ROUNDTRIP("ShapeGetRectangles");
         { /* when some smart people added ShapeInput they forgot to update XShapeQueryExtents or
              add a new one for input shapes, so we get to do this instead, yay! */
             int nrects, ordering;
@@ -1423,6 +1535,7 @@ void client_update_transient_for(ObClient *self)
     ObClient *target = NULL;
     gboolean trangroup = FALSE;
 
+    OBT_ROUNDTRIP("GetTransientForHint");
     if (XGetTransientForHint(obt_display, self->window, &t)) {
         if (t != self->window) { /* can't be transient to itself! */
             ObWindow *tw = window_find(t);
@@ -1627,6 +1740,7 @@ void client_get_type_and_transientness(ObClient *self)
         g_free(val);
     }
 
+    OBT_ROUNDTRIP("GetTransientForHint");
     if (XGetTransientForHint(obt_display, self->window, &t))
         self->transient = TRUE;
 
@@ -1706,6 +1820,7 @@ static void client_get_colormap(ObClient *self)
 {
     XWindowAttributes wa;
 
+    OBT_ROUNDTRIP("GetWindowAttributes");
     if (XGetWindowAttributes(obt_display, self->window, &wa))
         client_update_colormap(self, wa.colormap);
 }
@@ -1751,6 +1866,7 @@ void client_update_normal_hints(ObClient *realself)
     memcpy(self, realself, sizeof(ObClient));
 
     /* get the hints from the window */
+    OBT_ROUNDTRIP("GetWMNormalHints");
     if (XGetWMNormalHints(obt_display, self->window, &size, &ret)) {
         /* normal windows can't request placement! har har
         if (!client_normal(self))
@@ -2058,6 +2174,7 @@ void client_update_wmhints(ObClient *self)
     /* assume a window takes input if it doesn't specify */
     self->can_focus = TRUE;
 
+    OBT_ROUNDTRIP("GetWMHints");
     if ((hints = XGetWMHints(obt_display, self->window)) != NULL) {
         gboolean ur;
 
@@ -2137,6 +2254,7 @@ void client_update_wmhints(ObClient *self)
         XFree(hints);
     }
 
+    client_list_menu_invalidate();
     focus_cycle_addremove(self, TRUE);
 }
 
@@ -2168,6 +2286,7 @@ void client_update_title(ObClient *self)
         }
     }
     self->original_title = g_strdup(data);
+    self->title_serial = ++client_title_serial;
 
     if (self->client_machine) {
         visible = g_strdup_printf("%s (%s)", data, self->client_machine);
@@ -2224,6 +2343,8 @@ void client_update_title(ObClient *self)
         self->icon_title = visible;
     } else
         g_free(visible);
+
+    client_list_menu_client_changed(self);
 }
 
 void client_update_strut(ObClient *self)
@@ -2284,7 +2405,7 @@ void client_update_icons(ObClient *self)
 {
     guint num;
     guint32 *data;
-    guint w, h, i, j;
+    guint w, h, i;
     RrImage *img;
 
     img = NULL;
@@ -2295,7 +2416,12 @@ void client_update_icons(ObClient *self)
     grab_server(TRUE);
 
     if (OBT_PROP_GETA32(self->window, NET_WM_ICON, CARDINAL, &data, &num)) {
+        RrImagePicIndex *index;
+        gint n;
+
         /* figure out how many valid icons are in here */
+        index = g_new(RrImagePicIndex, num / 3);
+        n = 0;
         i = 0;
         while (i + 2 < num) { /* +2 is to make sure there is a w and h */
             w = data[i++];
@@ -2307,24 +2433,21 @@ void client_update_icons(ObClient *self)
                 continue;
             }
 
-            /* convert it to the right bit order for ObRender */
-            for (j = 0; j < w*h; ++j)
-                data[i+j] =
-                    ((guint32)((data[i+j] >> 24) & 0xff) << RrDefaultAlphaOffset) +
-                    ((guint32)((data[i+j] >> 16) & 0xff) << RrDefaultRedOffset)   +
-                    ((guint32)((data[i+j] >>  8) & 0xff) << RrDefaultGreenOffset) +
-                    ((guint32)((data[i+j] >>  0) & 0xff) << RrDefaultBlueOffset);
-
-            /* add it to the image cache as an original */
-            if (!img)
-                img = RrImageNewFromData(ob_rr_icons, &data[i], w, h);
-            else
-                RrImageAddFromData(img, &data[i], w, h);
+            index[n].width = w;
+            index[n].height = h;
+            index[n].offset = i;
+            ++n;
 
             i += w*h;
         }
 
-        g_free(data);
+        /* the icons are only converted for ObRender when they are drawn at
+           a size, so the image keeps the data */
+        if (n)
+            img = RrImageNewFromARGBIndex(ob_rr_icons, data, index, n);
+        else
+            g_free(data);
+        g_free(index);
     }
 
     /* if we didn't find an image from the NET_WM_ICON stuff, then try the
@@ -2332,6 +2455,7 @@ void client_update_icons(ObClient *self)
     if (!img) {
         XWMHints *hints;
 
+        OBT_ROUNDTRIP("GetWMHints");
         if ((hints = XGetWMHints(obt_display, self->window))) {
             if (hints->flags & IconPixmapHint) {
                 gboolean xicon;
@@ -2361,6 +2485,7 @@ void client_update_icons(ObClient *self)
     /* set the client's icons to be whatever we found */
     RrImageUnref(self->icon_set);
     self->icon_set = img;
+    client_list_menu_client_changed(self);
 
     /* if the client has no icon at all, then we set a default icon onto it.
        but, if it has parents, then one of them will have an icon already
@@ -3041,177 +3166,301 @@ void client_gravity_resize_h(ObClient *self, gint *y, gint oldh, gint newh)
     }
 }
 
-void client_try_configure(ObClient *self, gint *x, gint *y, gint *w, gint *h,
-                          gint *logicalw, gint *logicalh,
-                          gboolean user)
+/*! The size hints which a client's size is kept to, with the substitutions
+  for the hints it didn't give already made */
+typedef struct _ObClientSizeLimits {
+    gint basew, baseh;
+    gint minw, minh;
+    gint maxw, maxh;
+    gint incw, inch;
+    gfloat minratio, maxratio;
+    /* the base size for the aspect ratios, which is never substituted */
+    gint aspectw, aspecth;
+    /* don't use the size increments, when maximized or fullscreen */
+    gboolean exactw, exacth;
+} ObClientSizeLimits;
+
+typedef struct _ObClientResizeSession {
+    ObClientSizeLimits limits;
+    /* the largest size that still fits in an X window along with the frame */
+    gint capw, caph;
+
+    /* what the limits were found from, to tell when they are out of date */
+    Size min_size, max_size, size_inc, base_size;
+    gfloat min_ratio, max_ratio;
+    guint decorations;
+    gboolean undecorated;
+} ObClientResizeSession;
+
+static void client_size_limits(ObClient *self, ObClientSizeLimits *l)
 {
-    Rect desired = {*x, *y, *w, *h};
-    frame_rect_to_frame(self->frame, &desired);
+    l->incw = self->size_inc.width;
+    l->inch = self->size_inc.height;
+    l->minratio = self->fullscreen || (self->max_horz && self->max_vert) ?
+        0 : self->min_ratio;
+    l->maxratio = self->fullscreen || (self->max_horz && self->max_vert) ?
+        0 : self->max_ratio;
+
+    /* base size is substituted with min size if not specified */
+    if (self->base_size.width >= 0 || self->base_size.height >= 0) {
+        l->basew = self->base_size.width;
+        l->baseh = self->base_size.height;
+    } else {
+        l->basew = self->min_size.width;
+        l->baseh = self->min_size.height;
+    }
+    /* min size is substituted with base size if not specified */
+    if (self->min_size.width || self->min_size.height) {
+        l->minw = self->min_size.width;
+        l->minh = self->min_size.height;
+    } else {
+        l->minw = self->base_size.width;
+        l->minh = self->base_size.height;
+    }
+    l->maxw = self->max_size.width;
+    l->maxh = self->max_size.height;
 
-    /* make the frame recalculate its dimensions n shit without changing
-       anything visible for real, this way the constraints below can work with
-       the updated frame dimensions. */
-    frame_adjust_area(self->frame, FALSE, TRUE, TRUE);
+    /* for the aspect ratios, min size is not substituted for base size
+       ever */
+    if (self->base_size.width >= 0 && self->base_size.height >= 0) {
+        l->aspectw = self->base_size.width;
+        l->aspecth = self->base_size.height;
+    } else
+        l->aspectw = l->aspecth = 0;
 
-    /* cap any X windows at the size of an unsigned short */
-    *w = MIN(*w,
-             (gint)G_MAXUSHORT
-             - self->frame->size.left - self->frame->size.right);
-    *h = MIN(*h,
-             (gint)G_MAXUSHORT
-             - self->frame->size.top - self->frame->size.bottom);
+    l->exactw = self->fullscreen || self->max_horz;
+    l->exacth = self->fullscreen || self->max_vert;
+}
 
-    /* gets the frame's position */
-    frame_client_gravity(self->frame, x, y);
+/*! Work within the preferred sizes given by the window */
+static void client_constrain_size(const ObClientSizeLimits *l,
+                                  gint *w, gint *h,
+                                  gint *logicalw, gint *logicalh)
+{
+    gint maxw, maxh;
 
-    /* these positions are frame positions, not client positions */
+    /* This comment is no longer true */
+    /* if this is a user-requested resize, then check against min/max
+       sizes */
 
-    /* set the size and position if fullscreen */
-    if (self->fullscreen) {
-        const Rect *a;
-        guint i;
+    /* smaller than min size or bigger than max size? */
+    if (*w > l->maxw) *w = l->maxw;
+    if (*w < l->minw) *w = l->minw;
+    if (*h > l->maxh) *h = l->maxh;
+    if (*h < l->minh) *h = l->minh;
 
-        i = screen_find_monitor(&desired);
-        a = screen_physical_area_monitor(i);
+    *w -= l->basew;
+    *h -= l->baseh;
 
-        *x = a->x;
-        *y = a->y;
-        *w = a->width;
-        *h = a->height;
+    /* the sizes to used for maximized */
+    maxw = *w;
+    maxh = *h;
 
-        user = FALSE; /* ignore if the client can't be moved/resized when it
-                         is fullscreening */
-    } else if (self->max_horz || self->max_vert) {
-        Rect *a;
-        guint i;
+    /* keep to the increments */
+    *w /= l->incw;
+    *h /= l->inch;
 
-        /* use all possible struts when maximizing to the full screen */
-        i = screen_find_monitor(&desired);
-        a = screen_area(self->desktop, i,
-                        (self->max_horz && self->max_vert ? NULL : &desired));
+    /* you cannot resize to nothing */
+    if (l->basew + *w < 1) *w = 1 - l->basew;
+    if (l->baseh + *h < 1) *h = 1 - l->baseh;
 
-        /* set the size and position if maximized */
-        if (self->max_horz) {
-            *x = a->x;
-            *w = a->width - self->frame->size.left - self->frame->size.right;
-        }
-        if (self->max_vert) {
-            *y = a->y;
-            *h = a->height - self->frame->size.top - self->frame->size.bottom;
-        }
+    /* save the logical size */
+    *logicalw = l->incw > 1 ? *w : *w + l->basew;
+    *logicalh = l->inch > 1 ? *h : *h + l->baseh;
 
-        user = FALSE; /* ignore if the client can't be moved/resized when it
-                         is maximizing */
+    *w *= l->incw;
+    *h *= l->inch;
 
-        g_slice_free(Rect, a);
-    }
+    /* if maximized/fs then don't use the size increments */
+    if (l->exactw) *w = maxw;
+    if (l->exacth) *h = maxh;
 
-    /* gets the client's position */
-    frame_frame_gravity(self->frame, x, y);
+    *w += l->basew;
+    *h += l->baseh;
 
-    /* work within the preferred sizes given by the window, these may have
-       changed rather than it's requested width and height, so always run
-       through this code */
-    {
-        gint basew, baseh, minw, minh;
-        gint incw, inch, maxw, maxh;
-        gfloat minratio, maxratio;
-
-        incw = self->size_inc.width;
-        inch = self->size_inc.height;
-        minratio = self->fullscreen || (self->max_horz && self->max_vert) ?
-            0 : self->min_ratio;
-        maxratio = self->fullscreen || (self->max_horz && self->max_vert) ?
-            0 : self->max_ratio;
-
-        /* base size is substituted with min size if not specified */
-        if (self->base_size.width >= 0 || self->base_size.height >= 0) {
-            basew = self->base_size.width;
-            baseh = self->base_size.height;
-        } else {
-            basew = self->min_size.width;
-            baseh = self->min_size.height;
+    /* adjust the height to match the width for the aspect ratios */
+    *w -= l->aspectw;
+    *h -= l->aspecth;
+
+    if (l->minratio)
+        if (*h * l->minratio > *w) {
+            *h = (gint)(*w / l->minratio);
+
+            /* you cannot resize to nothing */
+            if (*h < 1) {
+                *h = 1;
+                *w = (gint)(*h * l->minratio);
+            }
         }
-        /* min size is substituted with base size if not specified */
-        if (self->min_size.width || self->min_size.height) {
-            minw = self->min_size.width;
-            minh = self->min_size.height;
-        } else {
-            minw = self->base_size.width;
-            minh = self->base_size.height;
+    if (l->maxratio)
+        if (*h * l->maxratio < *w) {
+            *h = (gint)(*w / l->maxratio);
+
+            /* you cannot resize to nothing */
+            if (*h < 1) {
+                *h = 1;
+                *w = (gint)(*h * l->minratio);
+            }
         }
 
-        /* This comment is no longer true */
-        /* if this is a user-requested resize, then check against min/max
-           sizes */
+    *w += l->aspectw;
+    *h += l->aspecth;
+}
 
-        /* smaller than min size or bigger than max size? */
-        if (*w > self->max_size.width) *w = self->max_size.width;
-        if (*w < minw) *w = minw;
-        if (*h > self->max_size.height) *h = self->max_size.height;
-        if (*h < minh) *h = minh;
+static void resize_session_update(ObClient *self)
+{
+    ObClientResizeSession *s = self->resize_session;
+
+    /* this uses the frame's dimensions, so it must come after they are
+       recalculated for the client's current state */
+    client_size_limits(self, &s->limits);
+    s->capw = (gint)G_MAXUSHORT
+        - self->frame->size.left - self->frame->size.right;
+    s->caph = (gint)G_MAXUSHORT
+        - self->frame->size.top - self->frame->size.bottom;
+
+    s->min_size = self->min_size;
+    s->max_size = self->max_size;
+    s->size_inc = self->size_inc;
+    s->base_size = self->base_size;
+    s->min_ratio = self->min_ratio;
+    s->max_ratio = self->max_ratio;
+    s->decorations = self->decorations;
+    s->undecorated = self->undecorated;
+}
 
-        *w -= basew;
-        *h -= baseh;
+/*! Returns TRUE if the client's resize session can be used in place of
+  recalculating the frame and size limits */
+static gboolean resize_session_current(ObClient *self)
+{
+    ObClientResizeSession *s = self->resize_session;
+
+    /* the area when maximized or fullscreen depends on the monitor that
+       the window is on, so always go the long way for those */
+    return s && !self->fullscreen && !self->max_horz && !self->max_vert &&
+        s->decorations == self->decorations &&
+        s->undecorated == self->undecorated &&
+        s->min_size.width == self->min_size.width &&
+        s->min_size.height == self->min_size.height &&
+        s->max_size.width == self->max_size.width &&
+        s->max_size.height == self->max_size.height &&
+        s->size_inc.width == self->size_inc.width &&
+        s->size_inc.height == self->size_inc.height &&
+        s->base_size.width == self->base_size.width &&
+        s->base_size.height == self->base_size.height &&
+        s->min_ratio == self->min_ratio &&
+        s->max_ratio == self->max_ratio;
+}
 
-        /* the sizes to used for maximized */
-        maxw = *w;
-        maxh = *h;
+void client_resize_session_start(ObClient *self)
+{
+    if (self->resize_session) return;
 
-        /* keep to the increments */
-        *w /= incw;
-        *h /= inch;
+    self->resize_session = g_slice_new(ObClientResizeSession);
 
-        /* you cannot resize to nothing */
-        if (basew + *w < 1) *w = 1 - basew;
-        if (baseh + *h < 1) *h = 1 - baseh;
+    /* find the frame's dimensions for the client's current state */
+    frame_adjust_area(self->frame, FALSE, TRUE, TRUE);
+    resize_session_update(self);
+}
 
-        /* save the logical size */
-        *logicalw = incw > 1 ? *w : *w + basew;
-        *logicalh = inch > 1 ? *h : *h + baseh;
+void client_resize_session_end(ObClient *self)
+{
+    if (self->resize_session) {
+        g_slice_free(ObClientResizeSession, self->resize_session);
+        self->resize_session = NULL;
+    }
+}
 
-        *w *= incw;
-        *h *= inch;
+void client_try_configure(ObClient *self, gint *x, gint *y, gint *w, gint *h,
+                          gint *logicalw, gint *logicalh,
+                          gboolean user)
+{
+    ObClientSizeLimits limits;
 
-        /* if maximized/fs then don't use the size increments */
-        if (self->fullscreen || self->max_horz) *w = maxw;
-        if (self->fullscreen || self->max_vert) *h = maxh;
+    if (resize_session_current(self)) {
+        ObClientResizeSession *s = self->resize_session;
 
-        *w += basew;
-        *h += baseh;
+        /* the frame's dimensions and the size limits were found when the
+           resize began.  the window isn't maximized or fullscreen, so its
+           position doesn't change here */
+        *w = MIN(*w, s->capw);
+        *h = MIN(*h, s->caph);
+        client_constrain_size(&s->limits, w, h, logicalw, logicalh);
+    } else {
+        Rect desired = {*x, *y, *w, *h};
+        frame_rect_to_frame(self->frame, &desired);
 
-        /* adjust the height to match the width for the aspect ratios.
-           for this, min size is not substituted for base size ever. */
-        if (self->base_size.width >= 0 && self->base_size.height >= 0) {
-            *w -= self->base_size.width;
-            *h -= self->base_size.height;
-        }
+        /* make the frame recalculate its dimensions n shit without changing
+           anything visible for real, this way the constraints below can work
+           with the updated frame dimensions. */
+        frame_adjust_area(self->frame, FALSE, TRUE, TRUE);
 
-        if (minratio)
-            if (*h * minratio > *w) {
-                *h = (gint)(*w / minratio);
+        /* cap any X windows at the size of an unsigned short */
+        *w = MIN(*w,
+                 (gint)G_MAXUSHORT
+                 - self->frame->size.left - self->frame->size.right);
+        *h = MIN(*h,
+                 (gint)G_MAXUSHORT
+                 - self->frame->size.top - self->frame->size.bottom);
 
-                /* you cannot resize to nothing */
-                if (*h < 1) {
-                    *h = 1;
-                    *w = (gint)(*h * minratio);
-                }
+        /* gets the frame's position */
+        frame_client_gravity(self->frame, x, y);
+
+        /* these positions are frame positions, not client positions */
+
+        /* set the size and position if fullscreen */
+        if (self->fullscreen) {
+            const Rect *a;
+            guint i;
+
+            i = screen_find_monitor(&desired);
+            a = screen_physical_area_monitor(i);
+
+            *x = a->x;
+            *y = a->y;
+            *w = a->width;
+            *h = a->height;
+
+            user = FALSE; /* ignore if the client can't be moved/resized when
+                             it is fullscreening */
+        } else if (self->max_horz || self->max_vert) {
+            Rect a;
+            guint i;
+
+            /* use all possible struts when maximizing to the full screen */
+            i = screen_find_monitor(&desired);
+            screen_area(self->desktop, i,
+                        (self->max_horz && self->max_vert ? NULL : &desired),
+                        &a);
+
+            /* set the size and position if maximized */
+            if (self->max_horz) {
+                *x = a.x;
+                *w = a.width - self->frame->size.left
+                    - self->frame->size.right;
             }
-        if (maxratio)
-            if (*h * maxratio < *w) {
-                *h = (gint)(*w / maxratio);
-
-                /* you cannot resize to nothing */
-                if (*h < 1) {
-                    *h = 1;
-                    *w = (gint)(*h * minratio);
-                }
+            if (self->max_vert) {
+                *y = a.y;
+                *h = a.height - self->frame->size.top
+                    - self->frame->size.bottom;
             }
 
-        if (self->base_size.width >= 0 && self->base_size.height >= 0) {
-            *w += self->base_size.width;
-            *h += self->base_size.height;
+            user = FALSE; /* ignore if the client can't be moved/resized when
+                             it is maximizing */
         }
+
+        /* gets the client's position */
+        frame_frame_gravity(self->frame, x, y);
+
+        /* work within the preferred sizes given by the window, these may
+           have changed rather than it's requested width and height, so
+           always run through this code */
+        client_size_limits(self, &limits);
+        client_constrain_size(&limits, w, h, logicalw, logicalh);
+
+        /* the client changed something the resize session depended on */
+        if (self->resize_session)
+            resize_session_update(self);
     }
 
     /* these override the above states! if you cant move you can't move! */
@@ -3476,6 +3725,7 @@ static void client_iconify_recursive(ObClient *self,
                or whatever */
             if (client_normal(self)) {
                 self->iconic = iconic;
+                client_array_update(self);
 
                 /* update the focus lists.. iconic windows go to the bottom of
                    the list. this will also call focus_cycle_addremove(). */
@@ -3485,6 +3735,7 @@ static void client_iconify_recursive(ObClient *self,
             }
         } else {
             self->iconic = iconic;
+            client_array_update(self);
 
             if (curdesk && self->desktop != screen_desktop &&
                 self->desktop != DESKTOP_ALL)
@@ -3500,6 +3751,7 @@ static void client_iconify_recursive(ObClient *self,
     }
 
     if (changed) {
+        client_list_menu_client_changed(self);
         client_change_state(self);
         if (config_animate_iconify && !hide_animation)
             frame_begin_iconify_animation(self->frame, iconic);
@@ -3814,7 +4066,14 @@ static void client_set_desktop_recursive(ObClient *self,
         g_assert(target < screen_num_desktops || target == DESKTOP_ALL);
 
         old = self->desktop;
-        self->desktop = target;
+        /* clients being managed aren't in the desktop lists yet */
+        if (self->desktop_link) {
+            client_desktop_list_remove(self);
+            self->desktop = target;
+            client_desktop_list_add(self);
+        } else
+            self->desktop = target;
+        client_array_update(self);
         OBT_PROP_SET32(self->window, NET_WM_DESKTOP, CARDINAL, target);
         /* the frame can display the current desktop state */
         frame_adjust_state(self->frame);
@@ -3832,6 +4091,7 @@ static void client_set_desktop_recursive(ObClient *self,
                resize, for example if we are maximized */
             client_reconfigure(self, FALSE);
 
+        client_list_menu_invalidate();
         focus_cycle_addremove(self, FALSE);
     }
 
@@ -3891,6 +4151,7 @@ gboolean client_validate(ObClient *self)
 {
     struct ObClientFindDestroyUnmap find;
 
+    OBT_ROUNDTRIP("XSync");
     XSync(obt_display, FALSE); /* get all events on the server */
 
     find.window = self->window;
@@ -4059,6 +4320,7 @@ void client_set_state(ObClient *self, Atom action, glong data1, glong data2)
 
     client_change_state(self); /* change the hint to reflect these changes */
 
+    client_list_menu_invalidate();
     focus_cycle_addremove(self, TRUE);
 }
 
@@ -4475,27 +4737,26 @@ void client_find_edge_directional(ObClient *self, ObDirection dir,
                                   gint my_edge_start, gint my_edge_size,
                                   gint *dest, gboolean *near_edge)
 {
-    GList *it;
-    Rect *a;
+    Rect a;
     Rect dock_area;
     gint edge;
     guint i;
 
-    a = screen_area(self->desktop, SCREEN_AREA_ALL_MONITORS,
-                    &self->frame->area);
+    screen_area(self->desktop, SCREEN_AREA_ALL_MONITORS,
+                &self->frame->area, &a);
 
     switch (dir) {
     case OB_DIRECTION_NORTH:
-        edge = RECT_TOP(*a) - 1;
+        edge = RECT_TOP(a) - 1;
         break;
     case OB_DIRECTION_SOUTH:
-        edge = RECT_BOTTOM(*a) + 1;
+        edge = RECT_BOTTOM(a) + 1;
         break;
     case OB_DIRECTION_EAST:
-        edge = RECT_RIGHT(*a) + 1;
+        edge = RECT_RIGHT(a) + 1;
         break;
     case OB_DIRECTION_WEST:
-        edge = RECT_LEFT(*a) - 1;
+        edge = RECT_LEFT(a) - 1;
         break;
     default:
         g_assert_not_reached();
@@ -4506,35 +4767,32 @@ void client_find_edge_directional(ObClient *self, ObDirection dir,
 
     /* search for edges of monitors */
     for (i = 0; i < screen_num_monitors; ++i) {
-        Rect *area = screen_area(self->desktop, i, NULL);
-        detect_edge(*area, dir, my_head, my_size, my_edge_start,
+        Rect area;
+
+        screen_area(self->desktop, i, NULL, &area);
+        detect_edge(area, dir, my_head, my_size, my_edge_start,
                     my_edge_size, dest, near_edge);
-        g_slice_free(Rect, area);
     }
 
     /* search for edges of clients */
-    for (it = client_list; it; it = g_list_next(it)) {
-        ObClient *cur = it->data;
+    for (i = 0; i < client_array.num; ++i) {
+        const guint desktop = client_array.desktop[i];
 
         /* skip windows to not bump into */
-        if (cur == self)
+        if (client_array.client[i] == self)
             continue;
-        if (cur->iconic)
+        if (client_array.flags[i] & OB_CLIENT_ARRAY_ICONIC)
             continue;
-        if (self->desktop != cur->desktop && cur->desktop != DESKTOP_ALL &&
-            cur->desktop != screen_desktop)
+        if (self->desktop != desktop && desktop != DESKTOP_ALL &&
+            desktop != screen_desktop)
             continue;
 
-        ob_debug("trying window %s", cur->title);
-
-        detect_edge(cur->frame->area, dir, my_head, my_size, my_edge_start,
-                    my_edge_size, dest, near_edge);
+        detect_edge(client_array.area[i], dir, my_head, my_size,
+                    my_edge_start, my_edge_size, dest, near_edge);
     }
     dock_get_area(&dock_area);
     detect_edge(dock_area, dir, my_head, my_size, my_edge_start,
                 my_edge_size, dest, near_edge);
-
-    g_slice_free(Rect, a);
 }
 
 void client_find_move_directional(ObClient *self, ObDirection dir,
@@ -103,6 +103,11 @@ struct _ObClient
     /*! The desktop on which the window resides (0xffffffff for all
       desktops) */
     guint desktop;
+    /*! The client's link in the list of clients on its desktop, see
+      client_desktop_list() */
+    GList *desktop_link;
+    /*! Where the client is in client_array, or -1 when it is not there */
+    gint array_index;
 
     /*! The monitor where the window resides */
     gint monitor;
@@ -117,6 +122,9 @@ struct _ObClient
     gchar *icon_title;
     /*! The title as requested by the client, without any of our own changes */
     gchar *original_title;
+    /*! Changes each time original_title does, and is never the same for two
+      titles, so results computed from the title can be cached against it */
+    guint title_serial;
     /*! Hostname of machine running the client */
     gchar *client_machine;
     /*! The command used to run the program. Pre-XSMP window identification. */
@@ -203,6 +211,10 @@ struct _ObClient
     */
     Size base_size;
 
+    /*! The size limits found when an interactive resize began, see
+      client_resize_session_start() */
+    struct _ObClientResizeSession *resize_session;
+
     /*! Window decoration and functionality hints */
     ObMwmHints mwmhints;
 
@@ -253,6 +265,9 @@ struct _ObClient
     guint32 sync_counter;
     /*! The value we're waiting for the counter to reach */
     gulong sync_counter_value;
+    /*! How long the client usually takes to answer a sync request, in
+      microseconds, or 0 if it hasn't been measured yet */
+    gint64 sync_rtt;
 #endif
 
     /*! The window uses shape extension to be non-rectangular? */
@@ -323,9 +338,36 @@ struct _ObClient
 
 extern GList      *client_list;
 
+typedef enum {
+    OB_CLIENT_ARRAY_ICONIC = 1 << 0
+} ObClientArrayFlags;
+
+/*! The managed clients, in the same order as client_list.  The things which
+  are looked at for every client, when searching through them, are copied
+  into their own arrays, so that the search does not have to visit each
+  ObClient.  client[i] has its frame's area in area[i], and so on. */
+typedef struct _ObClientArray {
+    ObClient **client;
+    Rect *area;        /*!< The frame's area */
+    guint *desktop;
+    guint8 *flags;     /*!< ObClientArrayFlags */
+    guint num;
+    guint size;
+} ObClientArray;
+
+extern ObClientArray client_array;
+
 void client_startup(gboolean reconfig);
 void client_shutdown(gboolean reconfig);
 
+/*! Copies the client's frame area, desktop, and flags into client_array,
+  after one of them changes */
+void client_array_update(ObClient *self);
+
+/*! Returns the list of clients on a desktop, in no particular order.  The
+  clients on all desktops are only in the list for DESKTOP_ALL. */
+GList* client_desktop_list(guint desktop);
+
 typedef void (*ObClientCallback)(ObClient *client, gpointer data);
 
 /* Callback functions */
@@ -442,6 +484,15 @@ void client_try_configure(ObClient *self, gint *x, gint *y, gint *w, gint *h,
                           gint *logicalw, gint *logicalh,
                           gboolean user);
 
+/*! Find the client's size limits and frame dimensions once, so that
+  client_try_configure can check each step of an interactive resize against
+  them without recalculating the frame.  They are found again if the client
+  changes its size hints or decorations during the resize. */
+void client_resize_session_start(ObClient *self);
+
+/*! Go back to finding the client's size limits for every configure */
+void client_resize_session_end(ObClient *self);
+
 /*! Move and/or resize the window.
   This also maintains things like the client's minsize, and size increments.
   @param x The x coordiante of the new position for the client.
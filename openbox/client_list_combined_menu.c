@@ -22,6 +22,7 @@
 #include "menuframe.h"
 #include "screen.h"
 #include "client.h"
+#include "client_list_menu.h"
 #include "client_list_combined_menu.h"
 #include "focus.h"
 #include "config.h"
@@ -32,31 +33,76 @@
 #define MENU_NAME "client-list-combined-menu"
 
 static ObMenu *combined_menu;
+/* maps the clients to their entries in the menu, one table per desktop, so
+   that the entries can be kept when the menu is put together again */
+static GHashTable **client_entries;
+static guint num_client_entries;
+/* the menu's entries need to be put together again before it is shown */
+static gboolean dirty;
+/* the labels and icons of the clients' entries need to be updated too */
+static gboolean relabel;
 
 #define SEPARATOR -1
 #define ADD_DESKTOP -2
 #define REMOVE_DESKTOP -3
 
-static void self_cleanup(ObMenu *menu, gpointer data)
+static void client_entries_free(GHashTable **entries, guint num)
 {
-    menu_clear_entries(menu);
+    guint i;
+
+    for (i = 0; i < num; ++i)
+        g_hash_table_destroy(entries[i]);
+    g_free(entries);
+}
+
+static gboolean is_client_entry(ObMenuEntry *e, GHashTable **entries,
+                                guint num)
+{
+    return (e->type == OB_MENU_ENTRY_TYPE_NORMAL && e->data.normal.data &&
+            e->id >= 0 && (guint)e->id < num &&
+            g_hash_table_lookup(entries[e->id], e->data.normal.data) == e);
 }
 
 static gboolean self_update(ObMenuFrame *frame, gpointer data)
 {
     ObMenu *menu = frame->menu;
     ObMenuEntry *e;
+    GHashTable **old_entries;
+    guint num_old_entries;
+    GQueue entries = G_QUEUE_INIT;
     GList *it;
     guint desktop;
 
-    menu_clear_entries(menu);
+    /* nothing has changed since it was last shown */
+    if (!dirty)
+        return TRUE;
+
+    /* hold onto the clients' entries so they can be put back into the
+       menu, and let go of everything else */
+    old_entries = client_entries;
+    num_old_entries = num_client_entries;
+    while (menu->entries) {
+        e = menu->entries->data;
+        if (!is_client_entry(e, old_entries, num_old_entries))
+            menu_entry_unref(e);
+        menu->entries = g_list_delete_link(menu->entries, menu->entries);
+    }
+
+    num_client_entries = screen_num_desktops;
+    client_entries = g_new(GHashTable*, num_client_entries);
 
     for (desktop = 0; desktop < screen_num_desktops; desktop++) {
+        GHashTable *old = desktop < num_old_entries ?
+            old_entries[desktop] : NULL;
         gboolean empty = TRUE;
         gboolean onlyiconic = TRUE;
         gboolean noicons = TRUE;
 
+        client_entries[desktop] = g_hash_table_new(g_direct_hash,
+                                                   g_direct_equal);
+
         menu_add_separator(menu, SEPARATOR, screen_desktop_names[desktop]);
+        client_list_menu_take_entry(menu, &entries);
         for (it = focus_order; it; it = g_list_next(it)) {
             ObClient *c = it->data;
             if (focus_valid_target(c, desktop,
@@ -66,55 +112,79 @@ static gboolean self_update(ObMenuFrame *frame, gpointer data)
                 empty = FALSE;
 
                 if (c->iconic) {
-                    if (config_menu_separate_iconic) {
-                        if (noicons) {
-                            menu_add_separator(menu, -1, NULL);
-                            noicons = FALSE;
-                        }
-                        e = menu_add_normal(menu, desktop, c->icon_title, NULL, FALSE);
-                    } else {
-                        gchar *title = g_strdup_printf("(%s)", c->icon_title);
-                        e = menu_add_normal(menu, desktop, title, NULL, FALSE);
-                        g_free(title);
+                    if (config_menu_separate_iconic && noicons) {
+                        menu_add_separator(menu, -1, NULL);
+                        client_list_menu_take_entry(menu, &entries);
+                        noicons = FALSE;
                     }
-                } else {
+                } else
                     onlyiconic = FALSE;
-                    e = menu_add_normal(menu, desktop, c->title, NULL, FALSE);
-                }
 
-                if (config_menu_show_icons) {
-                    e->data.normal.icon = client_icon(c);
-                    RrImageRef(e->data.normal.icon);
-                    e->data.normal.icon_alpha =
-                        c->iconic ? OB_ICONIC_ALPHA : 0xff;
-                }
+                if (old && (e = g_hash_table_lookup(old, c))) {
+                    g_hash_table_remove(old, c);
+                    g_queue_push_tail(&entries, e);
+                    if (relabel)
+                        client_list_menu_entry_update(e, c);
+                } else {
+                    gchar *label = client_list_menu_entry_label(c);
+                    menu_add_normal(menu, desktop, label, NULL, FALSE);
+                    g_free(label);
 
-                e->data.normal.data = c;
+                    e = client_list_menu_take_entry(menu, &entries);
+                    e->data.normal.data = c;
+                    client_list_menu_entry_set_icon(e, c);
+                }
+                g_hash_table_insert(client_entries[desktop], c, e);
             }
         }
 
         if (empty || onlyiconic) {
             /* no entries or only iconified windows, so add a
              * way to go to this desktop without uniconifying a window */
-            if (!empty)
+            if (!empty) {
                 menu_add_separator(menu, SEPARATOR, NULL);
+                client_list_menu_take_entry(menu, &entries);
+            }
 
-            e = menu_add_normal(menu, desktop, _("Go there..."), NULL, TRUE);
+            menu_add_normal(menu, desktop, _("Go there..."), NULL, TRUE);
+            e = client_list_menu_take_entry(menu, &entries);
             if (desktop == screen_desktop)
                 e->data.normal.enabled = FALSE;
         }
     }
 
+    /* the clients which are no longer in the menu */
+    for (desktop = 0; desktop < num_old_entries; ++desktop)
+        g_hash_table_foreach(old_entries[desktop],
+                             client_list_menu_entry_unref, NULL);
+    client_entries_free(old_entries, num_old_entries);
+
     if (config_menu_manage_desktops) {
         menu_add_separator(menu, SEPARATOR, _("Manage desktops"));
+        client_list_menu_take_entry(menu, &entries);
         menu_add_normal(menu, ADD_DESKTOP, _("_Add new desktop"), NULL, TRUE);
+        client_list_menu_take_entry(menu, &entries);
         menu_add_normal(menu, REMOVE_DESKTOP, _("_Remove last desktop"),
                         NULL, TRUE);
+        client_list_menu_take_entry(menu, &entries);
     }
 
+    menu->entries = entries.head;
+    menu->more_menu->entries = menu->entries; /* keep it in sync */
+
+    dirty = relabel = FALSE;
+
     return TRUE; /* always show the menu */
 }
 
+static void self_destroy(ObMenu *menu, gpointer data)
+{
+    client_entries_free(client_entries, num_client_entries);
+    client_entries = NULL;
+    num_client_entries = 0;
+    combined_menu = NULL;
+}
+
 static void menu_execute(ObMenuEntry *self, ObMenuFrame *f,
                          ObClient *c, guint state, gpointer data)
 {
@@ -147,13 +217,38 @@ static void client_dest(ObClient *client, gpointer data)
     /* This concise function removes all references to a closed
      * client in the client_list_menu, so we don't have to check
      * in client.c */
-    GList *eit;
-    for (eit = combined_menu->entries; eit; eit = g_list_next(eit)) {
-        ObMenuEntry *meit = eit->data;
-        if (meit->type == OB_MENU_ENTRY_TYPE_NORMAL &&
-            meit->data.normal.data == client)
-        {
+    guint i;
+    for (i = 0; i < num_client_entries; ++i) {
+        ObMenuEntry *meit;
+
+        if ((meit = g_hash_table_lookup(client_entries[i], client))) {
             meit->data.normal.data = NULL;
+            g_hash_table_remove(client_entries[i], client);
+            dirty = TRUE;
+        }
+    }
+}
+
+void client_list_combined_menu_invalidate(void)
+{
+    dirty = TRUE;
+}
+
+void client_list_combined_menu_client_changed(ObClient *client)
+{
+    gboolean visible = client_list_menu_is_visible(combined_menu);
+    guint i;
+
+    for (i = 0; i < num_client_entries; ++i) {
+        ObMenuEntry *meit;
+
+        if ((meit = g_hash_table_lookup(client_entries[i], client))) {
+            /* don't change the entries out from under a menu frame that is
+               showing them */
+            if (visible)
+                dirty = relabel = TRUE;
+            else
+                client_list_menu_entry_update(meit, client);
         }
     }
 }
@@ -165,8 +260,9 @@ void client_list_combined_menu_startup(gboolean reconfig)
 
     combined_menu = menu_new(MENU_NAME, _("Windows"), TRUE, NULL);
     menu_set_update_func(combined_menu, self_update);
-    menu_set_cleanup_func(combined_menu, self_cleanup);
+    menu_set_destroy_func(combined_menu, self_destroy);
     menu_set_execute_func(combined_menu, menu_execute);
+    dirty = TRUE;
 }
 
 void client_list_combined_menu_shutdown(gboolean reconfig)
@@ -20,7 +20,15 @@
 #ifndef ob__client_list_combined_menu_h
 #define ob__client_list_combined_menu_h
 
+struct _ObClient;
+
 void client_list_combined_menu_startup(gboolean reconfig);
 void client_list_combined_menu_shutdown(gboolean reconfig);
 
+/*! The combined client list menu is kept between showings, call this when the
+  set of windows it lists, or the order of them, may have changed */
+void client_list_combined_menu_invalidate(void);
+/*! Call this when a window's title, icon or iconic state changes */
+void client_list_combined_menu_client_changed(struct _ObClient *client);
+
 #endif
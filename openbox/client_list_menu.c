@@ -23,11 +23,13 @@
 #include "screen.h"
 #include "client.h"
 #include "client_list_menu.h"
+#include "client_list_combined_menu.h"
 #include "focus.h"
 #include "config.h"
 #include "gettext.h"
 
 #include <glib.h>
+#include <string.h>
 
 #define MENU_NAME "client-list-menu"
 
@@ -36,22 +38,104 @@ static GSList *desktop_menus;
 typedef struct
 {
     guint desktop;
+    /* maps the clients in the menu to their entries, so that the entries can
+       be kept when the menu is put together again */
+    GHashTable *client_entries;
+    /* the menu's entries need to be put together again before it is shown */
+    gboolean dirty;
+    /* the labels and icons of the clients' entries need to be updated too */
+    gboolean relabel;
 } DesktopData;
 
 #define SEPARATOR -1
 #define ADD_DESKTOP -2
 #define REMOVE_DESKTOP -3
 
+gboolean client_list_menu_is_visible(ObMenu *menu)
+{
+    GList *it;
+
+    for (it = menu_frame_visible; it; it = g_list_next(it))
+        if (((ObMenuFrame*)it->data)->menu == menu)
+            return TRUE;
+    return FALSE;
+}
+
+/* menu_add_*() append the entry to the end of the menu's list, which means
+   walking the whole list.  so the menu is emptied while it is being put
+   together, and each new entry is moved onto the end of a queue instead */
+ObMenuEntry* client_list_menu_take_entry(ObMenu *menu, GQueue *entries)
+{
+    ObMenuEntry *e = menu->entries->data;
+
+    g_assert(menu->entries->next == NULL);
+
+    g_list_free(menu->entries);
+    menu->entries = NULL;
+    g_queue_push_tail(entries, e);
+    return e;
+}
+
+gchar* client_list_menu_entry_label(ObClient *c)
+{
+    if (c->iconic && !config_menu_separate_iconic)
+        return g_strdup_printf("(%s)", c->icon_title);
+    return g_strdup(c->iconic ? c->icon_title : c->title);
+}
+
+void client_list_menu_entry_set_icon(ObMenuEntry *e, ObClient *c)
+{
+    if (config_menu_show_icons) {
+        RrImage *icon = client_icon(c);
+
+        RrImageRef(icon);
+        RrImageUnref(e->data.normal.icon);
+        e->data.normal.icon = icon;
+        e->data.normal.icon_alpha = c->iconic ? OB_ICONIC_ALPHA : 0xff;
+    }
+}
+
+void client_list_menu_entry_update(ObMenuEntry *e, ObClient *c)
+{
+    gchar *label = client_list_menu_entry_label(c);
+    menu_entry_set_label(e, label, FALSE);
+    g_free(label);
+
+    client_list_menu_entry_set_icon(e, c);
+}
+
+void client_list_menu_entry_unref(gpointer key, gpointer value, gpointer data)
+{
+    menu_entry_unref(value);
+}
+
 static gboolean desk_menu_update(ObMenuFrame *frame, gpointer data)
 {
     ObMenu *menu = frame->menu;
     DesktopData *d = data;
+    GHashTable *old_entries;
+    GQueue entries = G_QUEUE_INIT;
     GList *it;
     gboolean empty = TRUE;
     gboolean onlyiconic = TRUE;
     gboolean noicons = TRUE;
 
-    menu_clear_entries(menu);
+    /* nothing has changed since it was last shown */
+    if (!d->dirty)
+        return TRUE;
+
+    /* hold onto the clients' entries so they can be put back into the
+       menu, and let go of everything else */
+    old_entries = d->client_entries;
+    d->client_entries = g_hash_table_new(g_direct_hash, g_direct_equal);
+    while (menu->entries) {
+        ObMenuEntry *e = menu->entries->data;
+
+        if (!(e->type == OB_MENU_ENTRY_TYPE_NORMAL && e->data.normal.data &&
+              g_hash_table_lookup(old_entries, e->data.normal.data) == e))
+            menu_entry_unref(e);
+        menu->entries = g_list_delete_link(menu->entries, menu->entries);
+    }
 
     for (it = focus_order; it; it = g_list_next(it)) {
         ObClient *c = it->data;
@@ -62,45 +146,57 @@ static gboolean desk_menu_update(ObMenuFrame *frame, gpointer data)
             empty = FALSE;
 
             if (c->iconic) {
-                if (config_menu_separate_iconic) {
-                    if (noicons) {
-                        menu_add_separator(menu, -1, NULL);
-                        noicons = FALSE;
-                    }
-                    e = menu_add_normal(menu, d->desktop, c->icon_title, NULL, FALSE);
-                } else {
-                    gchar *title = g_strdup_printf("(%s)", c->icon_title);
-                    e = menu_add_normal(menu, d->desktop, title, NULL, FALSE);
-                    g_free(title);                    
+                if (config_menu_separate_iconic && noicons) {
+                    menu_add_separator(menu, -1, NULL);
+                    client_list_menu_take_entry(menu, &entries);
+                    noicons = FALSE;
                 }
-            } else {
+            } else
                 onlyiconic = FALSE;
-                e = menu_add_normal(menu, d->desktop, c->title, NULL, FALSE);
-            }
 
-            if (config_menu_show_icons) {
-                e->data.normal.icon = client_icon(c);
-                RrImageRef(e->data.normal.icon);
-                e->data.normal.icon_alpha = c->iconic ? OB_ICONIC_ALPHA : 0xff;
-            }
+            if ((e = g_hash_table_lookup(old_entries, c))) {
+                g_hash_table_remove(old_entries, c);
+                g_queue_push_tail(&entries, e);
+                if (d->relabel)
+                    client_list_menu_entry_update(e, c);
+            } else {
+                gchar *label = client_list_menu_entry_label(c);
+                menu_add_normal(menu, d->desktop, label, NULL, FALSE);
+                g_free(label);
 
-            e->data.normal.data = c;
+                e = client_list_menu_take_entry(menu, &entries);
+                e->data.normal.data = c;
+                client_list_menu_entry_set_icon(e, c);
+            }
+            g_hash_table_insert(d->client_entries, c, e);
         }
     }
 
+    /* the clients which are no longer in the menu */
+    g_hash_table_foreach(old_entries, client_list_menu_entry_unref, NULL);
+    g_hash_table_destroy(old_entries);
+
     if (empty || onlyiconic) {
         ObMenuEntry *e;
 
         /* no entries or only iconified windows, so add a
          * way to go to this desktop without uniconifying a window */
-        if (!empty)
+        if (!empty) {
             menu_add_separator(menu, SEPARATOR, NULL);
+            client_list_menu_take_entry(menu, &entries);
+        }
 
-        e = menu_add_normal(menu, d->desktop, _("Go there..."), NULL, TRUE);
+        menu_add_normal(menu, d->desktop, _("Go there..."), NULL, TRUE);
+        e = client_list_menu_take_entry(menu, &entries);
         if (d->desktop == screen_desktop)
             e->data.normal.enabled = FALSE;
     }
 
+    menu->entries = entries.head;
+    menu->more_menu->entries = menu->entries; /* keep it in sync */
+
+    d->dirty = d->relabel = FALSE;
+
     return TRUE; /* always show */
 }
 
@@ -125,19 +221,26 @@ static void desk_menu_destroy(ObMenu *menu, gpointer data)
 {
     DesktopData *d = data;
 
+    g_hash_table_destroy(d->client_entries);
     g_slice_free(DesktopData, d);
 
     desktop_menus = g_slist_remove(desktop_menus, menu);
 }
 
-static void self_cleanup(ObMenu *menu, gpointer data)
+/* returns TRUE if the desktop submenus don't match the desktops anymore */
+static gboolean desktop_menus_changed(void)
 {
-    menu_clear_entries(menu);
+    GSList *it;
+    guint i;
 
-    while (desktop_menus) {
-        menu_free(desktop_menus->data);
-        desktop_menus = g_slist_delete_link(desktop_menus, desktop_menus);
+    for (it = desktop_menus, i = 0; it && i < screen_num_desktops;
+         it = g_slist_next(it), ++i)
+    {
+        ObMenu *submenu = it->data;
+        if (strcmp(submenu->title, screen_desktop_names[i]))
+            return TRUE;
     }
+    return it || i < screen_num_desktops;
 }
 
 static gboolean self_update(ObMenuFrame *frame, gpointer data)
@@ -145,6 +248,11 @@ static gboolean self_update(ObMenuFrame *frame, gpointer data)
     ObMenu *menu = frame->menu;
     guint i;
 
+    /* the submenus are kept between showings, along with their entries, and
+       only made again when the desktops change */
+    if (!desktop_menus_changed())
+        return TRUE;
+
     menu_clear_entries(menu);
 
     while (desktop_menus) {
@@ -158,6 +266,10 @@ static gboolean self_update(ObMenuFrame *frame, gpointer data)
         DesktopData *ddata = g_slice_new(DesktopData);
 
         ddata->desktop = i;
+        ddata->client_entries = g_hash_table_new(g_direct_hash,
+                                                 g_direct_equal);
+        ddata->dirty = TRUE;
+        ddata->relabel = FALSE;
         submenu = menu_new(name, screen_desktop_names[i], FALSE, ddata);
         menu_set_update_func(submenu, desk_menu_update);
         menu_set_execute_func(submenu, desk_menu_execute);
@@ -201,18 +313,51 @@ static void client_dest(ObClient *client, gpointer data)
     GSList *it;
     for (it = desktop_menus; it; it = g_slist_next(it)) {
         ObMenu *mit = it->data;
-        GList *eit;
-        for (eit = mit->entries; eit; eit = g_list_next(eit)) {
-            ObMenuEntry *meit = eit->data;
-            if (meit->type == OB_MENU_ENTRY_TYPE_NORMAL &&
-                meit->data.normal.data == client)
-            {
-                    meit->data.normal.data = NULL;
-            }
+        DesktopData *d = mit->data;
+        ObMenuEntry *meit;
+
+        if ((meit = g_hash_table_lookup(d->client_entries, client))) {
+            meit->data.normal.data = NULL;
+            g_hash_table_remove(d->client_entries, client);
+            d->dirty = TRUE;
         }
     }
 }
 
+void client_list_menu_invalidate(void)
+{
+    GSList *it;
+
+    for (it = desktop_menus; it; it = g_slist_next(it)) {
+        DesktopData *d = ((ObMenu*)it->data)->data;
+        d->dirty = TRUE;
+    }
+
+    client_list_combined_menu_invalidate();
+}
+
+void client_list_menu_client_changed(ObClient *client)
+{
+    GSList *it;
+
+    for (it = desktop_menus; it; it = g_slist_next(it)) {
+        ObMenu *mit = it->data;
+        DesktopData *d = mit->data;
+        ObMenuEntry *meit;
+
+        if ((meit = g_hash_table_lookup(d->client_entries, client))) {
+            /* don't change the entries out from under a menu frame that is
+               showing them */
+            if (client_list_menu_is_visible(mit))
+                d->dirty = d->relabel = TRUE;
+            else
+                client_list_menu_entry_update(meit, client);
+        }
+    }
+
+    client_list_combined_menu_client_changed(client);
+}
+
 void client_list_menu_startup(gboolean reconfig)
 {
     ObMenu *menu;
@@ -222,7 +367,6 @@ void client_list_menu_startup(gboolean reconfig)
 
     menu = menu_new(MENU_NAME, _("Desktops"), TRUE, NULL);
     menu_set_update_func(menu, self_update);
-    menu_set_cleanup_func(menu, self_cleanup);
     menu_set_execute_func(menu, self_execute);
 }
 
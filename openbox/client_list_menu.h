@@ -20,7 +20,38 @@
 #ifndef ob__client_list_menu_h
 #define ob__client_list_menu_h
 
+struct _ObClient;
+struct _ObMenu;
+struct _ObMenuEntry;
+
 void client_list_menu_startup(gboolean reconfig);
 void client_list_menu_shutdown(gboolean reconfig);
 
+/*! The client list menus are kept between showings, call this when the set
+  of windows they list, or the order of them, may have changed.  They will be
+  put together again the next time they are shown. */
+void client_list_menu_invalidate(void);
+/*! Call this when a window's title, icon or iconic state changes, to update
+  its entries in the client list menus. */
+void client_list_menu_client_changed(struct _ObClient *client);
+
+/* These are shared with the combined client list menu */
+
+/*! Returns TRUE if a menu frame is showing the menu */
+gboolean client_list_menu_is_visible(struct _ObMenu *menu);
+/*! Moves the entry which was just added to the (emptied) menu onto the end of
+  the queue of entries, and returns it */
+struct _ObMenuEntry* client_list_menu_take_entry(struct _ObMenu *menu,
+                                                 GQueue *entries);
+/*! Returns the label for a client's entry, which must be g_free()'d */
+gchar* client_list_menu_entry_label(struct _ObClient *c);
+void client_list_menu_entry_set_icon(struct _ObMenuEntry *e,
+                                     struct _ObClient *c);
+/*! Updates the label and icon of a client's entry */
+void client_list_menu_entry_update(struct _ObMenuEntry *e,
+                                   struct _ObClient *c);
+/*! A GHFunc which unrefs the menu entry in the hash table's value */
+void client_list_menu_entry_unref(gpointer key, gpointer value,
+                                  gpointer data);
+
 #endif
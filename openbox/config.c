@@ -100,6 +100,7 @@ guint    config_submenu_show_delay;
 guint    config_submenu_hide_delay;
 gboolean config_menu_manage_desktops;
 gboolean config_menu_show_icons;
+gchar   *config_menu_icon_theme;
 gboolean config_menu_separate_iconic;
 
 GSList *config_menu_files;
@@ -983,6 +984,10 @@ static void parse_menu(xmlNodePtr node, gpointer d)
             g_message(_("Openbox was compiled without image loading support. Icons in menus will not be loaded."));
 #endif
     }
+    if ((n = obt_xml_find_node(node, "iconTheme"))) {
+        g_free(config_menu_icon_theme);
+        config_menu_icon_theme = obt_xml_node_string(n);
+    }
     if ((n = obt_xml_find_node(node, "separateIconic")))
         config_menu_separate_iconic = obt_xml_node_bool(n);
 
@@ -1196,6 +1201,7 @@ void config_startup(ObtXmlInst *i)
     config_menu_manage_desktops = TRUE;
     config_menu_files = NULL;
     config_menu_show_icons = TRUE;
+    config_menu_icon_theme = g_strdup("hicolor");
     config_menu_separate_iconic = FALSE;
 
     obt_xml_register(i, "menu", parse_menu, NULL);
@@ -1228,6 +1234,8 @@ void config_shutdown(void)
         g_free(it->data);
     g_slist_free(config_menu_files);
 
+    g_free(config_menu_icon_theme);
+
     for (it = config_per_app_settings; it; it = g_slist_next(it)) {
         ObAppSettings *itd = (ObAppSettings *)it->data;
         if (itd->name) g_pattern_spec_free(itd->name);
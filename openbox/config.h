@@ -215,6 +215,8 @@ extern guint    config_submenu_hide_delay;
 extern gboolean config_menu_manage_desktops;
 /*! Load & show icons in user-defined menus */
 extern gboolean config_menu_show_icons;
+/*! The icon theme to find icons in user-defined menus in */
+extern gchar   *config_menu_icon_theme;
 /*! Separate iconic windows instead of bracketing */
 extern gboolean config_menu_separate_iconic;
 /*! User-specified menu files */
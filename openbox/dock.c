@@ -52,9 +52,6 @@ static void dock_app_grab_button(ObDockApp *app, gboolean grab)
     }
 }
 
-static guint window_hash(Window *w) { return *w; }
-static gboolean window_comp(Window *w1, Window *w2) { return *w1 == *w2; }
-
 void dock_startup(gboolean reconfig)
 {
     XSetWindowAttributes attrib;
@@ -87,8 +84,7 @@ void dock_startup(gboolean reconfig)
 
     dock->hidden = TRUE;
 
-    dock->dock_map = g_hash_table_new((GHashFunc)window_hash,
-                                      (GEqualFunc)window_comp);
+    dock->dock_map = obt_winmap_new();
 
     attrib.event_mask = DOCK_EVENT_MASK;
     attrib.override_redirect = True;
@@ -125,7 +121,7 @@ void dock_shutdown(gboolean reconfig)
         return;
     }
 
-    g_hash_table_destroy(dock->dock_map);
+    obt_winmap_free(dock->dock_map);
 
     XDestroyWindow(obt_display, dock->frame);
     RrAppearanceFree(dock->a_frame);
@@ -157,6 +153,7 @@ void dock_manage(Window icon_win, Window name_win)
     if (app->name == NULL) app->name = g_strdup("");
     if (app->class == NULL) app->class = g_strdup("");
 
+    OBT_ROUNDTRIP("GetWindowAttributes");
     if (XGetWindowAttributes(obt_display, app->icon_win, &attrib)) {
         app->w = attrib.width;
         app->h = attrib.height;
@@ -165,7 +162,7 @@ void dock_manage(Window icon_win, Window name_win)
     }
 
     dock->dock_apps = g_list_append(dock->dock_apps, app);
-    g_hash_table_insert(dock->dock_map, &app->icon_win, app);
+    obt_winmap_add(dock->dock_map, app->icon_win, app);
     dock_configure();
 
     XReparentWindow(obt_display, app->icon_win, dock->frame, app->x, app->y);
@@ -187,6 +184,7 @@ void dock_manage(Window icon_win, Window name_win)
         XMapWindow(obt_display, app->name_win);
     }
 
+    OBT_ROUNDTRIP("XSync");
     XSync(obt_display, False);
 
     XSelectInput(obt_display, app->icon_win, DOCKAPP_EVENT_MASK);
@@ -211,6 +209,7 @@ void dock_unmanage(ObDockApp *app, gboolean reparent)
     XSelectInput(obt_display, app->icon_win, NoEventMask);
     /* remove the window from our save set */
     XChangeSaveSet(obt_display, app->icon_win, SetModeDelete);
+    OBT_ROUNDTRIP("XSync");
     XSync(obt_display, False);
 
     if (reparent) {
@@ -221,7 +220,7 @@ void dock_unmanage(ObDockApp *app, gboolean reparent)
     }
 
     dock->dock_apps = g_list_remove(dock->dock_apps, app);
-    g_hash_table_remove(dock->dock_map, &app->icon_win);
+    obt_winmap_remove(dock->dock_map, app->icon_win);
     dock_configure();
 
     ob_debug("Unmanaged Dock App: 0x%lx (%s)", app->icon_win, app->class);
@@ -689,5 +688,5 @@ void dock_lower_dock(void)
 
 ObDockApp* dock_find_dockapp(Window xwin)
 {
-    return g_hash_table_lookup(dock->dock_map, &xwin);
+    return obt_winmap_find(dock->dock_map, xwin);
 }
@@ -23,6 +23,7 @@
 #include "stacking.h"
 #include "geom.h"
 #include "obrender/render.h"
+#include "obt/winmap.h"
 
 #include <glib.h>
 #include <X11/Xlib.h>
@@ -44,7 +45,7 @@ struct _ObDock
     gboolean hidden;
 
     GList *dock_apps;
-    GHashTable *dock_map;
+    ObtWinMap *dock_map;
 };
 
 struct _ObDockApp {
@@ -39,6 +39,7 @@
 #include "group.h"
 #include "stacking.h"
 #include "ping.h"
+#include "animate.h"
 #include "obt/display.h"
 #include "obt/xqueue.h"
 #include "obt/prop.h"
@@ -80,6 +81,12 @@ typedef struct
     gulong end;   /* inclusive */
 } ObSerialRange;
 
+/* compare serials, allowing for them to wrap around */
+#define SERIAL_LT(a, b) ((glong)((a) - (b)) < 0)
+/* the ring of ignored ranges, as an index from its first range */
+#define IGNORE_RANGE(i) \
+    ignore_ranges[(ignore_ranges_head + (i)) & (ignore_ranges_size - 1)]
+
 static void event_process(const XEvent *e, gpointer data);
 static void event_handle_root(XEvent *e);
 static gboolean event_handle_menu_input(XEvent *e);
@@ -91,6 +98,7 @@ static void event_handle_client(ObClient *c, XEvent *e);
 static gboolean event_handle_user_input(ObClient *client, XEvent *e);
 static gboolean is_enter_focus_event_ignored(gulong serial);
 static void event_ignore_enter_range(gulong start, gulong end);
+static gboolean ignore_enters_bump_func(gpointer data);
 
 static void focus_delay_dest(gpointer data);
 static void unfocus_delay_dest(gpointer data);
@@ -110,8 +118,17 @@ static Time event_sourcetime = CurrentTime;
 static gulong event_curserial;
 static gboolean focus_left_screen = FALSE;
 static gboolean waiting_for_focusin = FALSE;
-/*! A list of ObSerialRanges which are to be ignored for mouse enter events */
-static GSList *ignore_serials = NULL;
+/*! The ObSerialRanges which are to be ignored for mouse enter events, in a
+  ring which is sorted by serial, and where no two ranges overlap or touch.
+  Events arrive in serial order, so ranges are only removed from the front */
+static ObSerialRange *ignore_ranges = NULL;
+static guint ignore_ranges_size = 0; /* always a power of two */
+static guint ignore_ranges_head = 0;
+static guint ignore_ranges_len = 0;
+/*! The end of the last ignored range, which a request has to go past before
+  waiting for more events */
+static gulong ignore_bump_serial;
+static guint ignore_bump_id = 0;
 static guint focus_delay_timeout_id = 0;
 static ObClient *focus_delay_timeout_client = NULL;
 static guint unfocus_delay_timeout_id = 0;
@@ -172,6 +189,12 @@ void event_shutdown(gboolean reconfig)
 #endif
 
     client_remove_destroy_notify(focus_delay_client_dest);
+
+    if (ignore_bump_id) g_source_remove(ignore_bump_id);
+    ignore_bump_id = 0;
+    g_free(ignore_ranges);
+    ignore_ranges = NULL;
+    ignore_ranges_size = ignore_ranges_head = ignore_ranges_len = 0;
 }
 
 static Window event_get_window(XEvent *e)
@@ -498,6 +521,7 @@ static void event_process(const XEvent *ec, gpointer data)
     event_set_curtime(e);
     event_curserial = e->xany.serial;
     event_hack_mods(e);
+    screen_pointer_event(e);
 
     /* deal with it in the kernel */
 
@@ -600,8 +624,10 @@ static void event_process(const XEvent *ec, gpointer data)
             gint i;
             guint u;
             obt_display_ignore_errors(TRUE);
+            OBT_ROUNDTRIP("GetInputFocus");
             if (XGetInputFocus(obt_display, &win, &i) &&
-                XGetGeometry(obt_display, win, &root, &i,&i,&u,&u,&u,&u) &&
+                (OBT_ROUNDTRIP("GetGeometry"),
+                 XGetGeometry(obt_display, win, &root, &i,&i,&u,&u,&u,&u)) &&
                 root != obt_root(ob_screen))
             {
                 ob_debug_type(OB_DEBUG_FOCUS,
@@ -751,6 +777,8 @@ static void event_process(const XEvent *ec, gpointer data)
        the time, so clear it here until the next event is handled */
     event_curtime = event_sourcetime = CurrentTime;
     event_curserial = 0;
+    /* and the same for where the pointer is */
+    screen_pointer_event_done();
 }
 
 static void event_handle_root(XEvent *e)
@@ -815,6 +843,7 @@ static void event_handle_root(XEvent *e)
         XRRUpdateConfiguration(e);
 #endif
         screen_resize();
+        animate_update_refresh_rate();
         break;
     default:
         ;
@@ -1320,14 +1349,14 @@ static void event_handle_client(ObClient *client, XEvent *e)
 
             /* oldschool fullscreen windows are allowed */
             if (!client_is_oldfullscreen(client, &to)) {
-                Rect *r;
+                Rect r;
 
-                r = screen_area(client->desktop, SCREEN_AREA_ALL_MONITORS,
-                                NULL);
-                if (r->x || r->y) {
+                screen_area(client->desktop, SCREEN_AREA_ALL_MONITORS,
+                            NULL, &r);
+                if (r.x || r.y) {
                     /* move the window only to the corner outside struts */
-                    x = r->x;
-                    y = r->y;
+                    x = r.x;
+                    y = r.y;
 
                     ob_debug_type(OB_DEBUG_APP_BUGS,
                                   "Application %s is trying to move via "
@@ -1335,11 +1364,9 @@ static void event_handle_client(ObClient *client, XEvent *e)
                                   "NorthWestGravity, while there is a "
                                   "strut there. "
                                   "Moving buggy app from (0,0) to (%d,%d)",
-                                  client->title, r->x, r->y);
+                                  client->title, r.x, r.y);
                 }
 
-                g_slice_free(Rect, r);
-
                 /* they still requested a move, so don't change whether a
                    notify is sent or not */
             }
@@ -1955,11 +1982,8 @@ static gboolean event_handle_menu_input(XEvent *ev)
                 /* start after the selected one */
                 start = frame->entries;
                 if (frame->selected) {
-                    for (it = start; frame->selected != it->data;
-                         it = g_list_next(it))
-                        g_assert(it != NULL); /* nothing was selected? */
                     /* next with wraparound */
-                    start = g_list_next(it);
+                    start = g_list_next(frame->selected->link);
                     if (start == NULL) start = frame->entries;
                 }
 
@@ -2174,54 +2198,110 @@ gulong event_start_ignore_all_enters(void)
     return NextRequest(obt_display);
 }
 
-static void event_ignore_enter_range(gulong start, gulong end)
+static void ignore_ranges_grow(void)
 {
     ObSerialRange *r;
+    guint i, size;
+
+    size = ignore_ranges_size ? ignore_ranges_size * 2 : 16;
+    r = g_new(ObSerialRange, size);
+    for (i = 0; i < ignore_ranges_len; ++i)
+        r[i] = IGNORE_RANGE(i);
+    g_free(ignore_ranges);
+    ignore_ranges = r;
+    ignore_ranges_size = size;
+    ignore_ranges_head = 0;
+}
+
+static void event_ignore_enter_range(gulong start, gulong end)
+{
+    guint i, first, last;
 
     g_assert(start != 0);
     g_assert(end != 0);
 
-    r = g_slice_new(ObSerialRange);
-    r->start = start;
-    r->end = end;
-    ignore_serials = g_slist_prepend(ignore_serials, r);
-
     ob_debug_type(OB_DEBUG_FOCUS, "ignoring enters from %lu until %lu",
-                  r->start, r->end);
+                  start, end);
+
+    /* skip the ranges that end before this one starts, looking from the end
+       as new ranges are almost always at the end */
+    for (first = ignore_ranges_len; first > 0; --first)
+        if (SERIAL_LT(IGNORE_RANGE(first-1).end + 1, start))
+            break;
+    /* merge in the ranges that overlap or touch this one */
+    for (last = first; last < ignore_ranges_len; ++last) {
+        ObSerialRange *r = &IGNORE_RANGE(last);
 
-    /* increment the serial so we don't ignore events we weren't meant to */
-    OBT_PROP_ERASE(screen_support_win, MOTIF_WM_HINTS);
+        if (SERIAL_LT(end + 1, r->start))
+            break;
+        if (SERIAL_LT(r->start, start)) start = r->start;
+        if (SERIAL_LT(end, r->end)) end = r->end;
+    }
+
+    if (last == first) {
+        /* make space for the new range */
+        if (ignore_ranges_len == ignore_ranges_size)
+            ignore_ranges_grow();
+        for (i = ignore_ranges_len; i > first; --i)
+            IGNORE_RANGE(i) = IGNORE_RANGE(i-1);
+        ++ignore_ranges_len;
+    }
+    else {
+        /* it replaces the ones it was merged with */
+        for (i = last; i < ignore_ranges_len; ++i)
+            IGNORE_RANGE(i - (last - first) + 1) = IGNORE_RANGE(i);
+        ignore_ranges_len -= last - first - 1;
+    }
+    IGNORE_RANGE(first).start = start;
+    IGNORE_RANGE(first).end = end;
+
+    /* the serial has to be moved past the end of the range, or enter events
+       caused by the mouse moving later on will be ignored until we send
+       something else to the server.  rather than sending a request just for
+       that now, wait until we are done with the events we have, as some
+       other request usually goes past it by then anyways */
+    if (!SERIAL_LT(end, NextRequest(obt_display) - 1)) {
+        ignore_bump_serial = end;
+        if (!ignore_bump_id)
+            ignore_bump_id = g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
+                                             ignore_enters_bump_func,
+                                             NULL, NULL);
+    }
+}
+
+static gboolean ignore_enters_bump_func(gpointer data)
+{
+    ignore_bump_id = 0;
+
+    /* only send a request if nothing has gone past the range already */
+    if (!SERIAL_LT(ignore_bump_serial, NextRequest(obt_display) - 1))
+        OBT_PROP_ERASE(screen_support_win, MOTIF_WM_HINTS);
+
+    return FALSE; /* don't repeat */
 }
 
 void event_end_ignore_all_enters(gulong start)
 {
     /* Use (NextRequest-1) so that we ignore up to the current serial only.
-       Inside event_ignore_enter_range, we increment the serial by one, but if
-       we ignore that serial too, then any enter events generated by mouse
-       movement will be ignored until we create some further network traffic.
-       Instead ignore up to NextRequest-1, then when we increment the serial,
-       we will be *past* the range of ignored serials */
+       The serial is moved on by one afterwards if nothing else does it, but
+       if we ignored that serial too, then any enter events generated by mouse
+       movement would be ignored until we create some further network
+       traffic.  Instead ignore up to NextRequest-1, and once the serial moves
+       on, we will be *past* the range of ignored serials */
     event_ignore_enter_range(start, NextRequest(obt_display)-1);
 }
 
 static gboolean is_enter_focus_event_ignored(gulong serial)
 {
-    GSList *it, *next;
-
-    for (it = ignore_serials; it; it = next) {
-        ObSerialRange *r = it->data;
-
-        next = g_slist_next(it);
-
-        if ((glong)(serial - r->end) > 0) {
-            /* past the end */
-            ignore_serials = g_slist_delete_link(ignore_serials, it);
-            g_slice_free(ObSerialRange, r);
-        }
-        else if ((glong)(serial - r->start) >= 0)
-            return TRUE;
+    /* drop the ranges that have been passed, the events come in order */
+    while (ignore_ranges_len && SERIAL_LT(IGNORE_RANGE(0).end, serial)) {
+        ignore_ranges_head =
+            (ignore_ranges_head + 1) & (ignore_ranges_size - 1);
+        --ignore_ranges_len;
     }
-    return FALSE;
+
+    return (ignore_ranges_len &&
+            !SERIAL_LT(serial, IGNORE_RANGE(0).start));
 }
 
 void event_cancel_all_key_grabs(void)
@@ -2245,6 +2325,7 @@ void event_cancel_all_key_grabs(void)
     else
         ungrab_passive_key();
 
+    OBT_ROUNDTRIP("XSync");
     XSync(obt_display, FALSE);
 }
 
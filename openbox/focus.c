@@ -28,6 +28,7 @@
 #include "screen.h"
 #include "keyboard.h"
 #include "focus.h"
+#include "client_list_menu.h"
 #include "stacking.h"
 #include "obt/prop.h"
 
@@ -67,6 +68,8 @@ static void push_to_top(ObClient *client)
 
     focus_order = g_list_remove(focus_order, client);
     focus_order = g_list_prepend(focus_order, client);
+
+    client_list_menu_invalidate();
 }
 
 void focus_set_client(ObClient *client)
@@ -215,6 +218,7 @@ void focus_order_add_new(ObClient *c)
             focus_order = g_list_insert(focus_order, c, 1);
     }
 
+    client_list_menu_invalidate();
     focus_cycle_addremove(c, TRUE);
 }
 
@@ -222,6 +226,7 @@ void focus_order_remove(ObClient *c)
 {
     focus_order = g_list_remove(focus_order, c);
 
+    client_list_menu_invalidate();
     focus_cycle_addremove(c, TRUE);
 }
 
@@ -245,6 +250,7 @@ void focus_order_to_top(ObClient *c)
         focus_order = g_list_insert_before(focus_order, it, c);
     }
 
+    client_list_menu_invalidate();
     focus_cycle_reorder();
 }
 
@@ -262,6 +268,7 @@ void focus_order_to_bottom(ObClient *c)
         focus_order = g_list_insert_before(focus_order, it, c);
     }
 
+    client_list_menu_invalidate();
     focus_cycle_reorder();
 }
 
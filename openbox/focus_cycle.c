@@ -183,9 +183,9 @@ static ObClient *focus_find_directional(ObClient *c, ObDirection dir,
     gint distance = 0;
     gint score, best_score;
     ObClient *best_client, *cur;
-    GList *it;
+    guint i;
 
-    if (!client_list)
+    if (!client_array.num)
         return NULL;
 
     /* first, find the centre coords of the currently focused window */
@@ -195,21 +195,19 @@ static ObClient *focus_find_directional(ObClient *c, ObDirection dir,
     best_score = -1;
     best_client = c;
 
-    for (it = g_list_first(client_list); it; it = g_list_next(it)) {
-        cur = it->data;
+    for (i = 0; i < client_array.num; ++i) {
+        const Rect *a = &client_array.area[i];
+
+        cur = client_array.client[i];
 
         /* the currently selected window isn't interesting */
         if (cur == c)
             continue;
-        if (!focus_cycle_valid(it->data))
-            continue;
 
         /* find the centre coords of this window, from the
          * currently focused window's point of view */
-        his_cx = (cur->frame->area.x - my_cx)
-            + cur->frame->area.width / 2;
-        his_cy = (cur->frame->area.y - my_cy)
-            + cur->frame->area.height / 2;
+        his_cx = (a->x - my_cx) + a->width / 2;
+        his_cy = (a->y - my_cy) + a->height / 2;
 
         if (dir == OB_DIRECTION_NORTHEAST || dir == OB_DIRECTION_SOUTHEAST ||
             dir == OB_DIRECTION_SOUTHWEST || dir == OB_DIRECTION_NORTHWEST)
@@ -260,7 +258,11 @@ static ObClient *focus_find_directional(ObClient *c, ObDirection dir,
         if (offset > distance)
             score += 1000000;
 
-        if (best_score == -1 || score < best_score) {
+        /* checking if it is a valid target costs more than scoring it, so
+           only check the ones which would win */
+        if ((best_score == -1 || score < best_score) &&
+            focus_cycle_valid(cur))
+        {
             best_client = cur;
             best_score = score;
         }
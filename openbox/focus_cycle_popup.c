@@ -52,6 +52,20 @@
 
 typedef struct _ObFocusCyclePopup       ObFocusCyclePopup;
 typedef struct _ObFocusCyclePopupTarget ObFocusCyclePopupTarget;
+typedef struct _ObFocusCyclePopupCell   ObFocusCyclePopupCell;
+
+/*! A picture of a target's icon or text, drawn once and kept while the popup
+  is showing, so that moving the hilite doesn't have to scale the icons and
+  lay out the text again */
+struct _ObFocusCyclePopupCell
+{
+    Pixmap pixmap;
+    /* where it was drawn on the background, and how big */
+    gint x, y, w, h;
+    gint alpha;
+    /* the background it was drawn on top of */
+    guint bg_generation;
+};
 
 struct _ObFocusCyclePopupTarget
 {
@@ -61,6 +75,10 @@ struct _ObFocusCyclePopupTarget
     Window iconwin;
     /* This is used when the popup is in list mode */
     Window textwin;
+
+    /* the icon and text, without and with the hilite */
+    ObFocusCyclePopupCell icon_cell[2];
+    ObFocusCyclePopupCell text_cell[2];
 };
 
 struct _ObFocusCyclePopup
@@ -92,6 +110,14 @@ struct _ObFocusCyclePopup
 
     gboolean mapped;
     ObFocusCyclePopupMode mode;
+
+    /* the size and mode that the background was last drawn for.  it is only
+       drawn again when one of these changes */
+    gint bg_w, bg_h;
+    ObFocusCyclePopupMode bg_mode;
+    /* counts how many times the background has been drawn, to know when the
+       cells drawn on top of it are out of date */
+    guint bg_generation;
 };
 
 /*! This popup shows all possible windows */
@@ -106,6 +132,7 @@ static gboolean popup_setup    (ObFocusCyclePopup *p,
                                 gboolean linear);
 static void     popup_render   (ObFocusCyclePopup *p,
                                 const ObClient *c);
+static void     popup_target_free(ObFocusCyclePopupTarget *t);
 
 static Window create_window(Window parent, guint bwidth, gulong mask,
                             XSetWindowAttributes *attr)
@@ -164,6 +191,11 @@ void focus_cycle_popup_startup(gboolean reconfig)
     popup.n_targets = 0;
     popup.last_target = NULL;
 
+    /* the background has not been drawn yet */
+    popup.bg_w = popup.bg_h = 0;
+    popup.bg_mode = OB_FOCUS_CYCLE_POPUP_MODE_NONE;
+    popup.bg_generation = 0;
+
     /* set up the hilite texture for the icon */
     popup.a_icon->texture[1].data.rgba.width = HILITE_SIZE;
     popup.a_icon->texture[1].data.rgba.height = HILITE_SIZE;
@@ -215,14 +247,7 @@ void focus_cycle_popup_shutdown(gboolean reconfig)
     stacking_remove(INTERNAL_AS_WINDOW(&popup));
 
     while(popup.targets) {
-        ObFocusCyclePopupTarget *t = popup.targets->data;
-
-        RrImageUnref(t->icon);
-        g_free(t->text);
-        XDestroyWindow(obt_display, t->iconwin);
-        XDestroyWindow(obt_display, t->textwin);
-        g_slice_free(ObFocusCyclePopupTarget, t);
-
+        popup_target_free(popup.targets->data);
         popup.targets = g_list_delete_link(popup.targets, popup.targets);
     }
 
@@ -241,8 +266,58 @@ void focus_cycle_popup_shutdown(gboolean reconfig)
     RrAppearanceFree(popup.a_bg);
 }
 
+static void popup_cell_free(ObFocusCyclePopupCell *cell)
+{
+    if (cell->pixmap) XFreePixmap(obt_display, cell->pixmap);
+    cell->pixmap = None;
+}
+
+/*! Show the cell's picture in the window, drawing it with the appearance
+  first if it isn't already drawn at the right place.  The appearance's
+  textures must already be set up for the cell. */
+static void popup_cell_paint(ObFocusCyclePopup *p, ObFocusCyclePopupCell *cell,
+                             RrAppearance *a, Window win,
+                             gint x, gint y, gint w, gint h, gint alpha)
+{
+    if (!cell->pixmap ||
+        cell->bg_generation != p->bg_generation ||
+        cell->x != x || cell->y != y ||
+        cell->w != w || cell->h != h ||
+        cell->alpha != alpha)
+    {
+        Pixmap oldp;
+
+        popup_cell_free(cell);
+
+        a->surface.parentx = x;
+        a->surface.parenty = y;
+        oldp = RrPaintPixmap(a, w, h);
+        if (oldp) XFreePixmap(obt_display, oldp);
+
+        /* keep the pixmap with the cell rather than the appearance, which
+           is shared by all the targets */
+        cell->pixmap = a->pixmap;
+        a->pixmap = None;
+        if (!cell->pixmap) return;
+
+        cell->x = x;
+        cell->y = y;
+        cell->w = w;
+        cell->h = h;
+        cell->alpha = alpha;
+        cell->bg_generation = p->bg_generation;
+    }
+
+    XSetWindowBackgroundPixmap(obt_display, win, cell->pixmap);
+    XClearWindow(obt_display, win);
+}
+
 static void popup_target_free(ObFocusCyclePopupTarget *t)
 {
+    popup_cell_free(&t->icon_cell[0]);
+    popup_cell_free(&t->icon_cell[1]);
+    popup_cell_free(&t->text_cell[0]);
+    popup_cell_free(&t->text_cell[1]);
     RrImageUnref(t->icon);
     g_free(t->text);
     XDestroyWindow(obt_display, t->iconwin);
@@ -317,7 +392,7 @@ static gboolean popup_setup(ObFocusCyclePopup *p, gboolean create_targets,
                     g_free(text);
                 } else {
                     ObFocusCyclePopupTarget *t =
-                        g_slice_new(ObFocusCyclePopupTarget);
+                        g_slice_new0(ObFocusCyclePopupTarget);
 
                     t->client = ft;
                     t->text = text;
@@ -417,6 +492,7 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
     gint up_arrow_x, down_arrow_x;
     gint up_arrow_y, down_arrow_y;
     gboolean showing_arrows = FALSE;
+    gboolean redraw_arrows = TRUE;
 
     g_assert(mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ||
              mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST);
@@ -583,12 +659,23 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
 
     /* * * draw everything * * */
 
-    /* draw the background */
-    if (!p->mapped)
+    /* draw the background, unless it is still there from the last time the
+       popup was shown at this size */
+    if (!p->mapped &&
+        (w != p->bg_w || h != p->bg_h || mode != p->bg_mode))
+    {
         RrPaint(p->a_bg, p->bg, w, h);
+        p->bg_w = w;
+        p->bg_h = h;
+        p->bg_mode = mode;
+        ++p->bg_generation;
+    }
+    else
+        /* the arrows are still drawn on it as well */
+        redraw_arrows = FALSE;
 
     /* draw the scroll arrows */
-    if (!p->mapped && mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST) {
+    if (redraw_arrows && mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST) {
         p->a_arrow->texture[0].data.mask.mask =
             ob_rr_theme->up_arrow_mask;
         p->a_arrow->surface.parent = p->a_bg;
@@ -610,7 +697,7 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
 
     /* draw the icons and text */
     for (i = 0, it = p->targets; it; ++i, it = g_list_next(it)) {
-        const ObFocusCyclePopupTarget *target = it->data;
+        ObFocusCyclePopupTarget *target = it->data;
 
         /* have to redraw the targetted icon and last targetted icon
          * to update the hilite */
@@ -622,6 +709,7 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
             const gint col = i % icons_per_row;
             gint iconx, icony;
             gint list_mode_textx, list_mode_texty;
+            gint alpha;
             RrAppearance *text;
 
             /* find the coordinates for the icon */
@@ -662,12 +750,12 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
             }
 
             /* get the icon from the client */
+            alpha = target->client->iconic ? OB_ICONIC_ALPHA : 0xff;
             p->a_icon->texture[0].data.image.twidth = ICON_SIZE;
             p->a_icon->texture[0].data.image.theight = ICON_SIZE;
             p->a_icon->texture[0].data.image.tx = HILITE_OFFSET;
             p->a_icon->texture[0].data.image.ty = HILITE_OFFSET;
-            p->a_icon->texture[0].data.image.alpha =
-                target->client->iconic ? OB_ICONIC_ALPHA : 0xff;
+            p->a_icon->texture[0].data.image.alpha = alpha;
             p->a_icon->texture[0].data.image.image = target->icon;
 
             /* Draw the hilite? */
@@ -675,9 +763,9 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
                 RR_TEXTURE_RGBA : RR_TEXTURE_NONE;
 
             /* draw the icon */
-            p->a_icon->surface.parentx = iconx;
-            p->a_icon->surface.parenty = icony;
-            RrPaint(p->a_icon, target->iconwin, HILITE_SIZE, HILITE_SIZE);
+            popup_cell_paint(p, &target->icon_cell[target == newtarget],
+                             p->a_icon, target->iconwin,
+                             iconx, icony, HILITE_SIZE, HILITE_SIZE, alpha);
 
             /* draw the text */
             if (mode == OB_FOCUS_CYCLE_POPUP_MODE_LIST ||
@@ -685,16 +773,15 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
             {
                 text = (target == newtarget) ? p->a_hilite_text : p->a_text;
                 text->texture[0].data.text.string = target->text;
-                text->surface.parentx =
-                    mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ?
-                    icon_mode_textx : list_mode_textx;
-                text->surface.parenty =
-                    mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ?
-                    icon_mode_texty : list_mode_texty;
-                RrPaint(text,
-                        (mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ?
-                         p->icon_mode_text : target->textwin),
-                        textw, texth);
+                popup_cell_paint(p, &target->text_cell[target == newtarget],
+                                 text,
+                                 (mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ?
+                                  p->icon_mode_text : target->textwin),
+                                 (mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ?
+                                  icon_mode_textx : list_mode_textx),
+                                 (mode == OB_FOCUS_CYCLE_POPUP_MODE_ICONS ?
+                                  icon_mode_texty : list_mode_texty),
+                                 textw, texth, 0);
             }
         }
     }
@@ -28,6 +28,7 @@
 #include "focus_cycle_indicator.h"
 #include "moveresize.h"
 #include "screen.h"
+#include "animate.h"
 #include "obrender/theme.h"
 #include "obt/display.h"
 #include "obt/xqueue.h"
@@ -41,7 +42,6 @@
                            EnterWindowMask | LeaveWindowMask)
 
 #define FRAME_ANIMATE_ICONIFY_TIME 150000 /* .15 seconds */
-#define FRAME_ANIMATE_ICONIFY_STEP_TIME (1000 / 60) /* 60 Hz */
 
 #define FRAME_HANDLE_Y(f) (f->size.top + f->client->area.height + f->cbwidth_b)
 
@@ -51,7 +51,7 @@ static gboolean flash_timeout(gpointer data);
 static void layout_title(ObFrame *self);
 static void set_theme_statics(ObFrame *self);
 static void free_theme_statics(ObFrame *self);
-static gboolean frame_animate_iconify(gpointer self);
+static gboolean frame_animate_iconify(gint64 now_usec, gpointer self);
 static void frame_adjust_cursors(ObFrame *self);
 
 static Window createWindow(Window parent, Visual *visual,
@@ -74,6 +74,7 @@ static Visual *check_32bit_client(ObClient *c)
     if (RrDepth(ob_rr_inst) == 32)
         return NULL;
 
+    OBT_ROUNDTRIP("GetWindowAttributes");
     ret = XGetWindowAttributes(obt_display, c->window, &wattrib);
     g_assert(ret != BadDrawable);
     g_assert(ret != BadWindow);
@@ -224,6 +225,8 @@ static void set_theme_statics(ObFrame *self)
 
 static void free_theme_statics(ObFrame *self)
 {
+    /* the labels were rendered with the old theme */
+    framerender_label_cache_clear(self);
 }
 
 void frame_free(ObFrame *self)
@@ -833,6 +836,7 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
         self->area.y = self->client->area.y;
         frame_client_gravity(self, &self->area.x, &self->area.y);
     }
+    client_array_update(self->client);
 
     if (!fake) {
         if (!frame_iconify_animating(self))
@@ -1073,8 +1077,7 @@ static gboolean find_reparent(XEvent *e, gpointer data)
 void frame_release_client(ObFrame *self)
 {
     /* if there was any animation going on, kill it */
-    if (self->iconify_animation_timer)
-        g_source_remove(self->iconify_animation_timer);
+    animate_stop(frame_animate_iconify, self);
 
     /* check if the app has already reparented its window away */
     if (!xqueue_exists_local(find_reparent, self)) {
@@ -1675,14 +1678,8 @@ static void flash_done(gpointer data)
 static gboolean flash_timeout(gpointer data)
 {
     ObFrame *self = data;
-    gint64 now_usec;
-#if GLIB_CHECK_VERSION(2, 28, 0)
-    now_usec = g_get_real_time();
-#else
-    GTimeVal now_tv;
-    g_get_current_time(&now_tv);
-    now_usec = now_tv.tv_sec * G_USEC_PER_SEC + now_tv.tv_usec;
-#endif
+    gint64 now_usec = animate_time();
+
     if (now_usec >= self->flash_end_usec)
         self->flashing = FALSE;
 
@@ -1710,14 +1707,7 @@ void frame_flash_start(ObFrame *self)
         self->flash_timer = g_timeout_add_full(G_PRIORITY_DEFAULT,
                                                600, flash_timeout, self,
                                                flash_done);
-#if GLIB_CHECK_VERSION(2, 28, 0)
-    self->flash_end_usec = g_get_real_time();
-#else
-    GTimeVal now_tv;
-    g_get_current_time(&now_tv);
-    self->flash_end_usec = now_tv.tv_sec * G_USEC_PER_SEC + now_tv.tv_usec;
-#endif
-    self->flash_end_usec += G_USEC_PER_SEC * 5;
+    self->flash_end_usec = animate_time() + G_USEC_PER_SEC * 5;
 
     self->flashing = TRUE;
 }
@@ -1735,7 +1725,7 @@ static gulong frame_animate_iconify_time_left(ObFrame *self,
     return MAX(diff, 0);
 }
 
-static gboolean frame_animate_iconify(gpointer p)
+static gboolean frame_animate_iconify(gint64 now_usec, gpointer p)
 {
     ObFrame *self = p;
     gint x, y, w, h;
@@ -1760,14 +1750,6 @@ static gboolean frame_animate_iconify(gpointer p)
     iconifying = self->iconify_animation_going > 0;
 
     /* how far do we have left to go ? */
-    gint64 now_usec;
-#if GLIB_CHECK_VERSION(2, 28, 0)
-    now_usec = g_get_real_time();
-#else
-    GTimeVal now_tv;
-    g_get_current_time(&now_tv);
-    now_usec = now_tv.tv_sec * G_USEC_PER_SEC + now_tv.tv_usec;
-#endif
     time = frame_animate_iconify_time_left(self, now_usec);
 
     if ((time > 0 && iconifying) || (time == 0 && !iconifying)) {
@@ -1801,8 +1783,8 @@ static gboolean frame_animate_iconify(gpointer p)
         h = self->size.top; /* just the titlebar */
     }
 
+    /* the animation engine flushes once for all the frames being animated */
     XMoveResizeWindow(obt_display, self->window, x, y, w, h);
-    XFlush(obt_display);
 
     return time > 0; /* repeat until we're out of time */
 }
@@ -1826,7 +1808,8 @@ void frame_end_iconify_animation(gpointer data)
 
     /* we're not animating any more ! */
     self->iconify_animation_going = 0;
-    self->iconify_animation_timer = 0;
+    /* stop the animation if it is being ended early */
+    animate_stop(frame_animate_iconify, self);
 
     XMoveResizeWindow(obt_display, self->window,
                       self->area.x, self->area.y,
@@ -1848,14 +1831,7 @@ void frame_begin_iconify_animation(ObFrame *self, gboolean iconifying)
         return;
 
     /* get the current time */
-    gint64 now_usec;
-#if GLIB_CHECK_VERSION(2, 28, 0)
-    now_usec = g_get_real_time();
-#else
-    GTimeVal now_tv;
-    g_get_current_time(&now_tv);
-    now_usec = now_tv.tv_sec * G_USEC_PER_SEC + now_tv.tv_usec;
-#endif
+    gint64 now_usec = animate_time();
 
     /* get how long until the end */
     time = FRAME_ANIMATE_ICONIFY_TIME;
@@ -1876,17 +1852,11 @@ void frame_begin_iconify_animation(ObFrame *self, gboolean iconifying)
     }
 
     if (new_anim) {
-        if (self->iconify_animation_timer)
-            g_source_remove(self->iconify_animation_timer);
-        self->iconify_animation_timer =
-            g_timeout_add_full(G_PRIORITY_DEFAULT,
-                               FRAME_ANIMATE_ICONIFY_STEP_TIME,
-                               frame_animate_iconify, self,
-                               frame_end_iconify_animation);
-                               
+        animate_start(frame_animate_iconify, self,
+                      frame_end_iconify_animation);
 
         /* do the first step */
-        frame_animate_iconify(self);
+        frame_animate_iconify(now_usec, self);
 
         /* show it during the animation even if it is not "visible" */
         if (!self->visible)
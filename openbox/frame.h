@@ -79,6 +79,16 @@ typedef enum {
     OB_FRAME_DECOR_CLOSE       = 1 << 9  /*!< Display a close button */
 } ObFrameDecorations;
 
+/*! A rendered window title, and what it was rendered for */
+typedef struct _ObFrameLabelCache
+{
+    Pixmap    pixmap;
+    gchar    *text;
+    gint      width;       /* width of the label */
+    gint      x;           /* x-position of the label in the titlebar */
+    gint      title_width; /* width of the titlebar it was drawn over */
+} ObFrameLabelCache;
+
 struct _ObFrame
 {
     struct _ObClient *client;
@@ -189,6 +199,10 @@ struct _ObFrame
     gboolean  focused;
     gboolean  need_render;
 
+    /*! The label rendered for the unfocused [0] and focused [1] states, so
+      it doesn't have to be drawn again when only the focus changes */
+    ObFrameLabelCache label_cache[2];
+
     gboolean  flashing;
     gboolean  flash_on;
     gint64    flash_end_usec;
@@ -199,7 +213,6 @@ struct _ObFrame
       < 0 means it is animating a restore.
     */
     gint iconify_animation_going;
-    guint iconify_animation_timer;
     gint64    iconify_animation_end_usec;
 };
 
@@ -348,12 +348,62 @@ void framerender_frame(ObFrame *self)
     XFlush(obt_display);
 }
 
+static void label_cache_free(ObFrameLabelCache *cache)
+{
+    if (cache->pixmap) XFreePixmap(obt_display, cache->pixmap);
+    g_free(cache->text);
+    cache->pixmap = None;
+    cache->text = NULL;
+}
+
+void framerender_label_cache_clear(ObFrame *self)
+{
+    label_cache_free(&self->label_cache[0]);
+    label_cache_free(&self->label_cache[1]);
+}
+
 static void framerender_label(ObFrame *self, RrAppearance *a)
 {
+    ObFrameLabelCache *cache, *other;
+    const gchar *title = self->client->title;
+
     if (!self->label_on) return;
-    /* set the texture's text! */
-    a->texture[0].data.text.string = self->client->title;
-    RrPaint(a, self->label, self->label_width, ob_rr_theme->label_height);
+
+    cache = &self->label_cache[self->focused ? 1 : 0];
+    other = &self->label_cache[self->focused ? 0 : 1];
+
+    if (!cache->pixmap ||
+        cache->width != self->label_width ||
+        cache->x != self->label_x ||
+        cache->title_width != self->width ||
+        strcmp(cache->text, title))
+    {
+        Pixmap oldp;
+
+        /* a label for an old title will never be used again */
+        if (other->text && strcmp(other->text, title))
+            label_cache_free(other);
+        label_cache_free(cache);
+
+        /* set the texture's text! */
+        a->texture[0].data.text.string = self->client->title;
+        oldp = RrPaintPixmap(a, self->label_width, ob_rr_theme->label_height);
+        if (oldp) XFreePixmap(obt_display, oldp);
+
+        /* keep the pixmap with the frame rather than the appearance, which
+           is shared by all the frames */
+        cache->pixmap = a->pixmap;
+        a->pixmap = None;
+        if (!cache->pixmap) return;
+
+        cache->text = g_strdup(title);
+        cache->width = self->label_width;
+        cache->x = self->label_x;
+        cache->title_width = self->width;
+    }
+
+    XSetWindowBackgroundPixmap(obt_display, self->label, cache->pixmap);
+    XClearWindow(obt_display, self->label);
 }
 
 static void framerender_icon(ObFrame *self, RrAppearance *a)
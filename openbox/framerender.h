@@ -23,4 +23,7 @@ struct _ObFrame;
 
 void framerender_frame(struct _ObFrame *self);
 
+/*! Forget the frame's rendered labels, so they are drawn again */
+void framerender_label_cache_clear(struct _ObFrame *self);
+
 #endif
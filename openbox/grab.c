@@ -85,6 +85,7 @@ gboolean grab_keyboard_full(gboolean grab)
 
     if (grab) {
         if (kgrabs++ == 0) {
+            OBT_ROUNDTRIP("GrabKeyboard");
             ret = XGrabKeyboard(obt_display, grab_window(),
                                 False, GrabModeAsync, GrabModeAsync,
                                 event_time()) == Success;
@@ -113,6 +114,7 @@ gboolean grab_pointer_full(gboolean grab, gboolean owner_events,
 
     if (grab) {
         if (pgrabs++ == 0) {
+            OBT_ROUNDTRIP("GrabPointer");
             ret = XGrabPointer(obt_display, grab_window(), owner_events,
                                GRAB_PTR_MASK,
                                GrabModeAsync, GrabModeAsync,
@@ -139,6 +141,7 @@ gint grab_server(gboolean grab)
     if (grab) {
         if (sgrabs++ == 0) {
             XGrabServer(obt_display);
+            OBT_ROUNDTRIP("XSync");
             XSync(obt_display, FALSE);
         }
     } else if (sgrabs > 0) {
@@ -36,6 +36,7 @@
 #include "gettext.h"
 #include "obt/xml.h"
 #include "obt/paths.h"
+#include "obt/icontheme.h"
 
 typedef struct _ObMenuParseState ObMenuParseState;
 
@@ -50,11 +51,14 @@ static ObtXmlInst *menu_parse_inst;
 static ObMenuParseState menu_parse_state;
 static gboolean menu_can_hide = FALSE;
 static guint menu_timeout_id = 0;
+static ObtIconTheme *menu_icon_theme = NULL;
 
 static void menu_destroy_hash_value(ObMenu *self);
 static void parse_menu_item(xmlNodePtr node, gpointer data);
 static void parse_menu_separator(xmlNodePtr node, gpointer data);
 static void parse_menu(xmlNodePtr node, gpointer data);
+static void menu_icon_loaded(RrImage *image, gboolean loaded,
+                             gpointer data);
 static gunichar parse_shortcut(const gchar *label, gboolean allow_shortcut,
                                gchar **strippedlabel, guint *position,
                                gboolean *always_show);
@@ -71,6 +75,18 @@ void menu_startup(gboolean reconfig)
     client_list_combined_menu_startup(reconfig);
     client_menu_startup();
 
+    /* menu icons are loaded in the background, and drawn when they are
+       ready */
+    RrImageCacheSetLoadedFunc(ob_rr_icons, menu_icon_loaded, NULL);
+
+    if (config_menu_show_icons && config_menu_icon_theme) {
+        ObtPaths *p;
+
+        p = obt_paths_new();
+        menu_icon_theme = obt_icon_theme_new(p, config_menu_icon_theme);
+        obt_paths_unref(p);
+    }
+
     menu_parse_inst = obt_xml_instance_new();
 
     menu_parse_state.parent = NULL;
@@ -131,6 +147,89 @@ void menu_shutdown(gboolean reconfig)
 
     g_hash_table_destroy(menu_hash);
     menu_hash = NULL;
+
+    obt_icon_theme_unref(menu_icon_theme);
+    menu_icon_theme = NULL;
+
+    RrImageCacheSetLoadedFunc(ob_rr_icons, NULL, NULL);
+}
+
+/*! Load the icon for a menu entry, which is the name of an icon in the icon
+  theme, or the path to an image file */
+static RrImage* menu_load_icon(const gchar *icon)
+{
+    RrImage *img;
+    gchar *path;
+
+    path = NULL;
+    if (menu_icon_theme)
+        path = obt_icon_theme_lookup(menu_icon_theme, icon,
+                                     ob_rr_theme->menu_font_height);
+    img = RrImageNewFromNameAsync(ob_rr_icons, path ? path : icon);
+    g_free(path);
+    return img;
+}
+
+static void menu_icon_forget(gpointer key, gpointer val, gpointer data)
+{
+    ObMenu *menu = val;
+    RrImage *image = data;
+    GList *it;
+
+    if (menu->more_menu)
+        menu_icon_forget(NULL, menu->more_menu, image);
+
+    for (it = menu->entries; it; it = g_list_next(it)) {
+        ObMenuEntry *e = it->data;
+
+        if (e->type == OB_MENU_ENTRY_TYPE_NORMAL &&
+            e->data.normal.icon == image)
+        {
+            RrImageUnref(image);
+            e->data.normal.icon = NULL;
+        }
+        else if (e->type == OB_MENU_ENTRY_TYPE_SUBMENU &&
+                 e->data.submenu.icon == image)
+        {
+            RrImageUnref(image);
+            e->data.submenu.icon = NULL;
+        }
+    }
+}
+
+static void menu_icon_loaded(RrImage *image, gboolean loaded, gpointer data)
+{
+    GList *it, *eit;
+    GSList *redraw = NULL;
+
+    /* find the menus that are showing the icon while it was empty */
+    for (it = menu_frame_visible; it; it = g_list_next(it)) {
+        ObMenuFrame *f = it->data;
+
+        for (eit = f->entries; eit; eit = g_list_next(eit)) {
+            ObMenuEntry *e = ((ObMenuEntryFrame*)eit->data)->entry;
+
+            if ((e->type == OB_MENU_ENTRY_TYPE_NORMAL &&
+                 e->data.normal.icon == image) ||
+                (e->type == OB_MENU_ENTRY_TYPE_SUBMENU &&
+                 e->data.submenu.icon == image))
+            {
+                redraw = g_slist_prepend(redraw, f);
+                break;
+            }
+        }
+    }
+
+    /* an icon that failed to load would leave empty space in its entries,
+       so take it out of them */
+    if (!loaded)
+        g_hash_table_foreach(menu_hash, menu_icon_forget, image);
+
+    /* and draw them again */
+    while (redraw) {
+        menu_frame_render(redraw->data);
+        redraw = g_slist_delete_link(redraw, redraw);
+    }
 }
 
 static gboolean menu_pipe_submenu(gpointer key, gpointer val, gpointer data)
@@ -304,7 +403,7 @@ static void parse_menu_item(xmlNodePtr node, gpointer data)
             if (config_menu_show_icons &&
                 obt_xml_attr_string(node, "icon", &icon))
             {
-                e->data.normal.icon = RrImageNewFromName(ob_rr_icons, icon);
+                e->data.normal.icon = menu_load_icon(icon);
 
                 if (e->data.normal.icon)
                     e->data.normal.icon_alpha = 0xff;
@@ -367,7 +466,7 @@ static void parse_menu(xmlNodePtr node, gpointer data)
         if (config_menu_show_icons &&
             obt_xml_attr_string(node, "icon", &icon))
         {
-            e->data.submenu.icon = RrImageNewFromName(ob_rr_icons, icon);
+            e->data.submenu.icon = menu_load_icon(icon);
 
             if (e->data.submenu.icon)
                 e->data.submenu.icon_alpha = 0xff;
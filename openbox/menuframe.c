@@ -44,7 +44,15 @@
 GList *menu_frame_visible;
 GHashTable *menu_frame_map;
 
+/* most entry frames that aren't being shown are kept here, along with their
+   windows, so that showing a menu doesn't have to create new windows for
+   each of its entries */
+#define ENTRY_FRAME_POOL_SIZE 64
+
 static RrAppearance *a_sep;
+static Window entry_frame_pool_window;
+static GSList *entry_frame_pool = NULL;
+static guint entry_frame_pool_len = 0;
 static guint submenu_show_timer = 0;
 static guint submenu_hide_timer = 0;
 
@@ -94,6 +102,10 @@ void menu_frame_startup(gboolean reconfig)
 
     client_add_destroy_notify(client_dest, NULL);
     menu_frame_map = g_hash_table_new(g_int_hash, g_int_equal);
+
+    /* the unused entry frames' windows are kept inside this, which is never
+       shown */
+    entry_frame_pool_window = createWindow(obt_root(ob_screen), 0, NULL);
 }
 
 void menu_frame_shutdown(gboolean reconfig)
@@ -102,6 +114,17 @@ void menu_frame_shutdown(gboolean reconfig)
 
     if (reconfig) return;
 
+    while (entry_frame_pool) {
+        ObMenuEntryFrame *self = entry_frame_pool->data;
+
+        XDestroyWindow(obt_display, self->window);
+        g_slice_free(ObMenuEntryFrame, self);
+        entry_frame_pool = g_slist_delete_link(entry_frame_pool,
+                                               entry_frame_pool);
+    }
+    entry_frame_pool_len = 0;
+    XDestroyWindow(obt_display, entry_frame_pool_window);
+
     client_remove_destroy_notify(client_dest);
     g_hash_table_destroy(menu_frame_map);
 }
@@ -172,31 +195,46 @@ static ObMenuEntryFrame* menu_entry_frame_new(ObMenuEntry *entry,
                                               ObMenuFrame *frame)
 {
     ObMenuEntryFrame *self;
-    XSetWindowAttributes attr;
 
-    self = g_slice_new0(ObMenuEntryFrame);
+    if (entry_frame_pool) {
+        self = entry_frame_pool->data;
+        entry_frame_pool = g_slist_delete_link(entry_frame_pool,
+                                               entry_frame_pool);
+        --entry_frame_pool_len;
+
+        XReparentWindow(obt_display, self->window, frame->window, 0, 0);
+    } else {
+        XSetWindowAttributes attr;
+
+        self = g_slice_new(ObMenuEntryFrame);
+
+        /* every entry frame gets all of the windows, so that it can be
+           reused for any type of entry */
+        attr.event_mask = ENTRY_EVENTMASK;
+        self->window = createWindow(frame->window, CWEventMask, &attr);
+        self->text = createWindow(self->window, 0, NULL);
+        self->icon = createWindow(self->window, 0, NULL);
+        self->bullet = createWindow(self->window, 0, NULL);
+
+        XMapWindow(obt_display, self->text);
+    }
+
     self->entry = entry;
     self->frame = frame;
+    self->link = NULL;
+    self->index = 0;
+    self->ignore_enters = 0;
+    self->border = 0;
+    RECT_SET(self->area, 0, 0, 0, 0);
 
     menu_entry_ref(entry);
 
-    attr.event_mask = ENTRY_EVENTMASK;
-    self->window = createWindow(self->frame->window, CWEventMask, &attr);
-    self->text = createWindow(self->window, 0, NULL);
     g_hash_table_insert(menu_frame_map, &self->window, self);
     g_hash_table_insert(menu_frame_map, &self->text, self);
-    if ((entry->type == OB_MENU_ENTRY_TYPE_NORMAL) ||
-        (entry->type == OB_MENU_ENTRY_TYPE_SUBMENU)) {
-        self->icon = createWindow(self->window, 0, NULL);
-        g_hash_table_insert(menu_frame_map, &self->icon, self);
-    }
-    if (entry->type == OB_MENU_ENTRY_TYPE_SUBMENU) {
-        self->bullet = createWindow(self->window, 0, NULL);
-        g_hash_table_insert(menu_frame_map, &self->bullet, self);
-    }
+    g_hash_table_insert(menu_frame_map, &self->icon, self);
+    g_hash_table_insert(menu_frame_map, &self->bullet, self);
 
     XMapWindow(obt_display, self->window);
-    XMapWindow(obt_display, self->text);
 
     window_add(&self->window, MENUFRAME_AS_WINDOW(self->frame));
 
@@ -208,22 +246,28 @@ static void menu_entry_frame_free(ObMenuEntryFrame *self)
     if (self) {
         window_remove(self->window);
 
-        XDestroyWindow(obt_display, self->text);
-        XDestroyWindow(obt_display, self->window);
         g_hash_table_remove(menu_frame_map, &self->text);
         g_hash_table_remove(menu_frame_map, &self->window);
-        if ((self->entry->type == OB_MENU_ENTRY_TYPE_NORMAL) ||
-            (self->entry->type == OB_MENU_ENTRY_TYPE_SUBMENU)) {
-            XDestroyWindow(obt_display, self->icon);
-            g_hash_table_remove(menu_frame_map, &self->icon);
-        }
-        if (self->entry->type == OB_MENU_ENTRY_TYPE_SUBMENU) {
-            XDestroyWindow(obt_display, self->bullet);
-            g_hash_table_remove(menu_frame_map, &self->bullet);
-        }
+        g_hash_table_remove(menu_frame_map, &self->icon);
+        g_hash_table_remove(menu_frame_map, &self->bullet);
 
         menu_entry_unref(self->entry);
-        g_slice_free(ObMenuEntryFrame, self);
+
+        if (entry_frame_pool_len < ENTRY_FRAME_POOL_SIZE) {
+            /* move it out of the menu frame before that is destroyed */
+            XUnmapWindow(obt_display, self->window);
+            XReparentWindow(obt_display, self->window,
+                            entry_frame_pool_window, 0, 0);
+
+            self->entry = NULL;
+            self->frame = NULL;
+            entry_frame_pool = g_slist_prepend(entry_frame_pool, self);
+            ++entry_frame_pool_len;
+        } else {
+            /* this destroys all of its children too */
+            XDestroyWindow(obt_display, self->window);
+            g_slice_free(ObMenuEntryFrame, self);
+        }
     }
 }
 
@@ -351,7 +395,7 @@ void menu_frame_move_on_screen(ObMenuFrame *self, gint x, gint y,
     a = screen_physical_area_monitor(monitor);
 
     half = self->num_entries / 2;
-    pos = g_list_index(self->entries, self->selected);
+    pos = self->selected ? (gint)self->selected->index : -1;
 
     /* if in the bottom half then check this stuff first, will keep the bottom
        edge of the menu visible */
@@ -627,15 +671,13 @@ static void menu_entry_frame_render(ObMenuEntryFrame *self)
         XMapWindow(obt_display, self->bullet);
     } else
         XUnmapWindow(obt_display, self->bullet);
-
-    XFlush(obt_display);
 }
 
 /*! this code is taken from the menu_frame_render. if that changes, this won't
   work.. */
-static gint menu_entry_frame_get_height(ObMenuEntryFrame *self,
-                                        gboolean first_entry,
-                                        gboolean last_entry)
+static gint menu_entry_get_height(ObMenuEntry *self,
+                                  gboolean first_entry,
+                                  gboolean last_entry)
 {
     ObMenuEntryType t;
     gint h = 0;
@@ -643,7 +685,7 @@ static gint menu_entry_frame_get_height(ObMenuEntryFrame *self,
     h += 2*PADDING;
 
     if (self)
-        t = self->entry->type;
+        t = self->type;
     else
         /* this is the More... entry, it's NORMAL type */
         t = OB_MENU_ENTRY_TYPE_NORMAL;
@@ -654,7 +696,7 @@ static gint menu_entry_frame_get_height(ObMenuEntryFrame *self,
         h += ob_rr_theme->menu_font_height;
         break;
     case OB_MENU_ENTRY_TYPE_SEPARATOR:
-        if (self->entry->data.separator.label != NULL) {
+        if (self->data.separator.label != NULL) {
             h += ob_rr_theme->menu_title_height +
                 (ob_rr_theme->mbwidth - PADDING) * 2;
 
@@ -853,110 +895,87 @@ void menu_frame_render(ObMenuFrame *self)
 
 static void menu_frame_update(ObMenuFrame *self)
 {
-    GList *mit, *fit;
+    GList *start, *mit;
     const Rect *a;
-    gint h;
+    gint h, more_h;
+    guint i, num, num_fit;
 
     menu_pipe_execute(self->menu);
     menu_find_submenus(self->menu);
 
     self->selected = NULL;
 
-    /* start at show_from */
-    mit = g_list_nth(self->menu->entries, self->show_from);
+    /* let go of any old entry frames, they go back to the pool */
+    while (self->entries) {
+        menu_entry_frame_free(self->entries->data);
+        self->entries = g_list_delete_link(self->entries, self->entries);
+    }
+    self->num_entries = 0;
+
+    /* * make the menu fit on the screen */
 
-    /* go through the menu's and frame's entries and connect the frame entries
-       to the menu entries */
-    for (fit = self->entries; mit && fit;
-         mit = g_list_next(mit), fit = g_list_next(fit))
-    {
-        ObMenuEntryFrame *f = fit->data;
-        f->entry = mit->data;
+    a = screen_physical_area_monitor(self->monitor);
+
+    /* figure out how many of the menu's entries, starting at show_from, will
+       fit on the screen before making frames for any of them.  only one
+       screen's worth of a long menu is shown at a time, with a More... entry
+       at the bottom to get to the rest.  num_fit is how many entries fit
+       along with the More... entry */
+    start = g_list_nth(self->menu->entries, self->show_from);
+    more_h = menu_entry_get_height(NULL, FALSE, TRUE);
+    /* the border at the top and bottom */
+    h = ob_rr_theme->mbwidth * 2;
+    num = num_fit = 0;
+    for (mit = start; mit && h <= a->height; mit = g_list_next(mit)) {
+        h += menu_entry_get_height(mit->data, mit == start,
+                                   g_list_next(mit) == NULL);
+        ++num;
+        if (h + more_h <= a->height)
+            num_fit = num;
     }
 
-    /* if there are more menu entries than in the frame, add them */
-    while (mit) {
-        ObMenuEntryFrame *e = menu_entry_frame_new(mit->data, self);
+    /* if they don't all fit then leave room for the More... entry, but show
+       at least one entry */
+    if (h > a->height)
+        num = MAX(num_fit, 1);
+
+    for (i = 0; i < num; ++i, start = g_list_next(start)) {
+        ObMenuEntryFrame *e = menu_entry_frame_new(start->data, self);
         /* OPTIMIZATION: Prepend is O(1). Append is O(N). */
         self->entries = g_list_prepend(self->entries, e);
+    }
+    self->num_entries = num;
+
+    if (start) {
+        ObMenuEntry *more_entry;
+        ObMenuEntryFrame *more_frame;
+        /* make the More... menu entry frame which will display in this
+           frame.
+           if self->menu->more_menu is NULL that means that this is already
+           More... menu, so just use ourself.
+        */
+        more_entry = menu_get_more((self->menu->more_menu ?
+                                    self->menu->more_menu :
+                                    self->menu),
+                                   /* continue where we left off */
+                                   self->show_from +
+                                   self->num_entries);
+        more_frame = menu_entry_frame_new(more_entry, self);
+        /* make it get deleted when the menu frame goes away */
+        menu_entry_unref(more_entry);
+
+        /* add our More... entry to the frame */
+        self->entries = g_list_prepend(self->entries, more_frame);
         self->num_entries++;
-        mit = g_list_next(mit);
     }
     /* OPTIMIZATION: Reverse once at the end. Total cost O(N). */
     self->entries = g_list_reverse(self->entries);
 
-    /* if there are more frame entries than menu entries then get rid of
-       them */
-    while (fit) {
-        GList *n = g_list_next(fit);
-        menu_entry_frame_free(fit->data);
-        self->num_entries--;
-        self->entries = g_list_delete_link(self->entries, fit);
-        fit = n;
-    }
-
-    /* * make the menu fit on the screen */
-
-    /* calculate the height of the menu */
-    h = 0;
-    for (fit = self->entries; fit; fit = g_list_next(fit))
-        h += menu_entry_frame_get_height(fit->data,
-                                         fit == self->entries,
-                                         g_list_next(fit) == NULL);
-    /* add the border at the top and bottom */
-    h += ob_rr_theme->mbwidth * 2;
-
-    a = screen_physical_area_monitor(self->monitor);
-
-    if (h > a->height) {
-        GList *flast, *tmp;
-        gboolean last_entry = TRUE;
-
-        /* take the height of our More... entry into account */
-        h += menu_entry_frame_get_height(NULL, FALSE, TRUE);
-
-        /* start at the end of the entries */
-        flast = g_list_last(self->entries);
-
-        /* pull out all the entries from the frame that don't
-           fit on the screen, leaving at least 1 though */
-        while (h > a->height && g_list_previous(flast) != NULL) {
-            /* update the height, without this entry */
-            h -= menu_entry_frame_get_height(flast->data, FALSE, last_entry);
-
-            /* destroy the entry we're not displaying */
-            tmp = flast;
-            flast = g_list_previous(flast);
-            menu_entry_frame_free(tmp->data);
-            self->num_entries--;
-            self->entries = g_list_delete_link(self->entries, tmp);
-
-            /* only the first one that we see is the last entry in the menu */
-            last_entry = FALSE;
-        };
-
-        {
-            ObMenuEntry *more_entry;
-            ObMenuEntryFrame *more_frame;
-            /* make the More... menu entry frame which will display in this
-               frame.
-               if self->menu->more_menu is NULL that means that this is already
-               More... menu, so just use ourself.
-            */
-            more_entry = menu_get_more((self->menu->more_menu ?
-                                        self->menu->more_menu :
-                                        self->menu),
-                                       /* continue where we left off */
-                                       self->show_from +
-                                       self->num_entries);
-            more_frame = menu_entry_frame_new(more_entry, self);
-            /* make it get deleted when the menu frame goes away */
-            menu_entry_unref(more_entry);
-
-            /* add our More... entry to the frame */
-            self->entries = g_list_append(self->entries, more_frame);
-            self->num_entries++;
-        }
+    /* index the entries, so the selection can move around in O(1) */
+    for (i = 0, mit = self->entries; mit; ++i, mit = g_list_next(mit)) {
+        ObMenuEntryFrame *e = mit->data;
+        e->link = mit;
+        e->index = i;
     }
 
     menu_frame_render(self);
@@ -1290,6 +1309,8 @@ void menu_frame_select(ObMenuFrame *self, ObMenuEntryFrame *entry,
             }
         }
     }
+
+    XFlush(obt_display);
 }
 
 void menu_entry_frame_show_submenu(ObMenuEntryFrame *self)
@@ -1342,7 +1363,7 @@ void menu_frame_select_previous(ObMenuFrame *self)
     GList *it = NULL, *start;
 
     if (self->entries) {
-        start = it = g_list_find(self->entries, self->selected);
+        start = it = self->selected ? self->selected->link : NULL;
         while (TRUE) {
             ObMenuEntryFrame *e;
 
@@ -1367,7 +1388,7 @@ void menu_frame_select_next(ObMenuFrame *self)
     GList *it = NULL, *start;
 
     if (self->entries) {
-        start = it = g_list_find(self->entries, self->selected);
+        start = it = self->selected ? self->selected->link : NULL;
         while (TRUE) {
             ObMenuEntryFrame *e;
 
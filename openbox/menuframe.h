@@ -94,6 +94,11 @@ struct _ObMenuEntryFrame
     struct _ObMenuEntry *entry;
     ObMenuFrame *frame;
 
+    /* this entry's link in the frame's list of entries, and its position
+       in the list */
+    GList *link;
+    guint index;
+
     guint ignore_enters;
 
     Rect area;
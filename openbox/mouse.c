@@ -39,6 +39,13 @@ typedef struct {
 
 /* Array of GSList*s of ObMouseBinding*s. */
 static GSList *bound_contexts[OB_FRAME_NUM_CONTEXTS];
+/* The same ObMouseBinding*s, in a hash table for each context, keyed by
+   their button and state, to find them for each pointer event */
+static GHashTable *bound_tables[OB_FRAME_NUM_CONTEXTS];
+
+/* the modifier state is 16 bits in the X protocol, and the button is 8 */
+#define BINDING_KEY(button, state) \
+    GUINT_TO_POINTER(((button) << 16) | ((state) & 0xffff))
 /* TRUE when we have a grab on the pointer and need to replay the pointer event
    to send it to other applications */
 static gboolean replay_pointer_needed;
@@ -46,19 +53,22 @@ static gboolean replay_pointer_needed;
 /* this is the static button from mouse_event, moved here so that event.c can clear it */
 guint button;
 
+static ObMouseBinding* find_binding(ObFrameContext context,
+                                    guint button, guint state)
+{
+    if (!bound_tables[context]) return NULL;
+    return g_hash_table_lookup(bound_tables[context],
+                               BINDING_KEY(button, state));
+}
+
 ObFrameContext mouse_button_frame_context(ObFrameContext context,
                                           guint button,
                                           guint state)
 {
-    GSList *it;
     ObFrameContext x = context;
 
-    for (it = bound_contexts[context]; it; it = g_slist_next(it)) {
-        ObMouseBinding *b = it->data;
-
-        if (b->button == button && b->state == state)
-            return context;
-    }
+    if (find_binding(context, button, state))
+        return context;
 
     switch (context) {
     case OB_FRAME_CONTEXT_NONE:
@@ -163,6 +173,10 @@ void mouse_unbind_all(void)
         }
         g_slist_free(bound_contexts[i]);
         bound_contexts[i] = NULL;
+        if (bound_tables[i]) {
+            g_hash_table_destroy(bound_tables[i]);
+            bound_tables[i] = NULL;
+        }
     }
 }
 
@@ -184,16 +198,10 @@ static gboolean fire_binding(ObMouseAction a, ObFrameContext context,
                              ObClient *c, guint state,
                              guint button, gint x, gint y)
 {
-    GSList *it;
     ObMouseBinding *b;
 
-    for (it = bound_contexts[context]; it; it = g_slist_next(it)) {
-        b = it->data;
-        if (b->state == state && b->button == button)
-            break;
-    }
     /* if not bound, then nothing to do! */
-    if (it == NULL) return FALSE;
+    if (!(b = find_binding(context, button, state))) return FALSE;
 
     actions_run_acts(b->actions[a], mouse_action_to_user_action(a),
                      state, x, y, button, context, c);
@@ -286,6 +294,7 @@ gboolean mouse_event(ObClient *client, XEvent *e)
             guint ujunk, b, w, h;
             /* this can cause errors to occur when the window closes */
             obt_display_ignore_errors(TRUE);
+            OBT_ROUNDTRIP("GetGeometry");
             junk1 = XGetGeometry(obt_display, e->xbutton.window,
                                  &wjunk, &junk1, &junk2, &w, &h, &b, &ujunk);
             obt_display_ignore_errors(FALSE);
@@ -377,7 +386,6 @@ gboolean mouse_bind(const gchar *buttonstr, ObFrameContext context,
 {
     guint state = 0, button = 0;
     ObMouseBinding *b;
-    GSList *it;
 
     g_assert(context != OB_FRAME_CONTEXT_NONE);
 
@@ -386,12 +394,9 @@ gboolean mouse_bind(const gchar *buttonstr, ObFrameContext context,
         return FALSE;
     }
 
-    for (it = bound_contexts[context]; it; it = g_slist_next(it)) {
-        b = it->data;
-        if (b->state == state && b->button == button) {
-            b->actions[mact] = g_slist_append(b->actions[mact], action);
-            return TRUE;
-        }
+    if ((b = find_binding(context, button, state))) {
+        b->actions[mact] = g_slist_append(b->actions[mact], action);
+        return TRUE;
     }
 
     /* add the binding */
@@ -400,6 +405,10 @@ gboolean mouse_bind(const gchar *buttonstr, ObFrameContext context,
     b->button = button;
     b->actions[mact] = g_slist_append(NULL, action);
     bound_contexts[context] = g_slist_append(bound_contexts[context], b);
+    if (!bound_tables[context])
+        bound_tables[context] = g_hash_table_new(g_direct_hash,
+                                                 g_direct_equal);
+    g_hash_table_insert(bound_tables[context], BINDING_KEY(button, state), b);
 
     return TRUE;
 }
@@ -30,6 +30,7 @@
 #include "config.h"
 #include "event.h"
 #include "debug.h"
+#include "animate.h"
 #include "obrender/render.h"
 #include "obrender/theme.h"
 #include "obt/display.h"
@@ -43,6 +44,12 @@
 /* how far windows move and resize with the keyboard arrows */
 #define KEY_DIST 8
 #define SYNC_TIMEOUTS 4
+/* wait this many times as long as a client usually takes to answer a sync
+   request before giving up on the answer */
+#define SYNC_TIMEOUT_RTTS 4
+/* bounds on how long to wait for an answer to a sync request, in ms */
+#define SYNC_TIMEOUT_MIN 100
+#define SYNC_TIMEOUT_MAX 2000
 
 gboolean moveresize_in_progress = FALSE;
 ObClient *moveresize_client = NULL;
@@ -67,15 +74,27 @@ static ObDirection key_resize_edge = -1;
 static guint waiting_for_sync;
 #ifdef SYNC
 static guint sync_timer = 0;
+/* when the last sync request was sent to the client */
+static gint64 sync_sent_usec = 0;
+/* if the time the client took for the last sync request is known yet */
+static gboolean sync_measured = FALSE;
 #endif
+/* the client isn't sent another size before this time */
+static gint64 next_resize_usec = 0;
 
 static ObPopup *popup = NULL;
+/* the text waiting to be shown in the popup on the next frame */
+static gchar *popup_text = NULL;
+static ObClient *popup_text_client = NULL;
 
 static void do_move(gboolean keyboard, gint keydist);
 static void do_resize(void);
+static gboolean resize_frame(gint64 now_usec, gpointer data);
 static void do_edge_warp(gint x, gint y);
 static void cancel_edge_warp();
 #ifdef SYNC
+static void sync_rtt_measure(gint64 rtt);
+static guint sync_timeout(void);
 static gboolean sync_timeout_func(gpointer data);
 #endif
 
@@ -85,6 +104,8 @@ static void client_dest(ObClient *client, gpointer data)
         moveresize_end(TRUE);
     if (popup && client == popup->client)
         popup->client = NULL;
+    if (client == popup_text_client)
+        popup_text_client = NULL;
 }
 
 void moveresize_startup(gboolean reconfig)
@@ -108,11 +129,8 @@ void moveresize_shutdown(gboolean reconfig)
     popup = NULL;
 }
 
-static void popup_coords(ObClient *c, const gchar *format, gint a, gint b)
+static void popup_coords_show(ObClient *c, gchar *text)
 {
-    gchar *text;
-
-    text = g_strdup_printf(format, a, b);
     if (config_resize_popup_pos == OB_RESIZE_POS_TOP)
         popup_position(popup, SouthGravity,
                        c->frame->area.x
@@ -171,7 +189,32 @@ static void popup_coords(ObClient *c, const gchar *format, gint a, gint b)
     }
     popup->client = c;
     popup_show(popup, text);
-    g_free(text);
+}
+
+static gboolean popup_coords_step(gint64 now_usec, gpointer data)
+{
+    if (popup_text_client)
+        popup_coords_show(popup_text_client, popup_text);
+    return FALSE; /* only show it once */
+}
+
+static void popup_coords_done(gpointer data)
+{
+    g_free(popup_text);
+    popup_text = NULL;
+    popup_text_client = NULL;
+}
+
+static void popup_coords(ObClient *c, const gchar *format, gint a, gint b)
+{
+    /* motion events can come in much faster than the screen refreshes, so
+       only render the newest text once per frame */
+    g_free(popup_text);
+    popup_text = g_strdup_printf(format, a, b);
+    popup_text_client = c;
+
+    if (!animate_running(popup_coords_step, NULL))
+        animate_start(popup_coords_step, NULL, popup_coords_done);
 }
 
 void moveresize_start(ObClient *c, gint x, gint y, guint b, guint32 cnr)
@@ -267,6 +310,11 @@ void moveresize_start(ObClient *c, gint x, gint y, guint b, guint32 cnr)
 
     moveresize_in_progress = TRUE;
     waiting_for_sync = 0;
+    next_resize_usec = 0;
+
+    /* find the client's size limits once, instead of for every motion */
+    if (!moving)
+        client_resize_session_start(c);
 
 #ifdef SYNC
     if (config_resize_redraw && !moving && obt_display_extension_sync &&
@@ -314,10 +362,17 @@ void moveresize_end(gboolean cancel)
     ungrab_keyboard();
     ungrab_pointer();
 
+    /* drop any text that hasn't been shown yet */
+    animate_stop(popup_coords_step, NULL);
     popup_hide(popup);
     popup->client = NULL;
 
     if (!moving) {
+        client_resize_session_end(moveresize_client);
+
+        /* the last size is sent below */
+        animate_stop(resize_frame, NULL);
+
 #ifdef SYNC
         /* turn off the alarm */
         if (moveresize_alarm != None) {
@@ -388,6 +443,23 @@ static void do_move(gboolean keyboard, gint keydist)
                      moveresize_client->frame->area.y);
 }
 
+/*! Returns how long to wait after sending the client a new size before
+  sending it another one */
+static gint64 resize_interval(void)
+{
+    /* never send sizes faster than the screen can show them */
+    gint64 t = animate_frame_time();
+
+#ifdef SYNC
+    /* a client which stopped answering sync requests still takes about as
+       long as it used to to redraw, so don't flood it with sizes */
+    if (waiting_for_sync > SYNC_TIMEOUTS)
+        t = MAX(t, MIN(moveresize_client->sync_rtt,
+                       (gint64)SYNC_TIMEOUT_MAX * 1000));
+#endif
+    return t;
+}
+
 static void do_resize(void)
 {
     gint x, y, w, h, lw, lh;
@@ -409,46 +481,61 @@ static void do_resize(void)
            that many times already, so forget about waiting more */
         (waiting_for_sync == 0 || waiting_for_sync > SYNC_TIMEOUTS))
     {
+        gint64 now = animate_time();
+
+        if (now < next_resize_usec) {
+            /* it's too soon to send another size.  cur_w and cur_h keep
+               following the pointer, so whatever they are when it's time
+               is what gets sent */
+            if (!animate_running(resize_frame, NULL))
+                animate_start(resize_frame, NULL, NULL);
+        } else {
 #ifdef SYNC
-        if (config_resize_redraw && obt_display_extension_sync &&
-            /* don't send another sync when one is pending */
-            waiting_for_sync == 0 &&
-            moveresize_client->sync_request &&
-            moveresize_client->sync_counter &&
-            !moveresize_client->not_responding)
-        {
-            XEvent ce;
-            XSyncValue val;
-
-            /* increment the value we're waiting for */
-            ++moveresize_client->sync_counter_value;
-            XSyncIntToValue(&val, moveresize_client->sync_counter_value);
-
-            /* tell the client what we're waiting for */
-            ce.xclient.type = ClientMessage;
-            ce.xclient.message_type = OBT_PROP_ATOM(WM_PROTOCOLS);
-            ce.xclient.display = obt_display;
-            ce.xclient.window = moveresize_client->window;
-            ce.xclient.format = 32;
-            ce.xclient.data.l[0] = OBT_PROP_ATOM(NET_WM_SYNC_REQUEST);
-            ce.xclient.data.l[1] = event_time();
-            ce.xclient.data.l[2] = XSyncValueLow32(val);
-            ce.xclient.data.l[3] = XSyncValueHigh32(val);
-            ce.xclient.data.l[4] = 0l;
-            XSendEvent(obt_display, moveresize_client->window, FALSE,
-                       NoEventMask, &ce);
-
-            waiting_for_sync = 1;
-
-            if (sync_timer) g_source_remove(sync_timer);
-            sync_timer = g_timeout_add(2000, sync_timeout_func, NULL);
-        }
+            if (config_resize_redraw && obt_display_extension_sync &&
+                /* don't send another sync when one is pending */
+                waiting_for_sync == 0 &&
+                moveresize_client->sync_request &&
+                moveresize_client->sync_counter &&
+                !moveresize_client->not_responding)
+            {
+                XEvent ce;
+                XSyncValue val;
+
+                /* increment the value we're waiting for */
+                ++moveresize_client->sync_counter_value;
+                XSyncIntToValue(&val, moveresize_client->sync_counter_value);
+
+                /* tell the client what we're waiting for */
+                ce.xclient.type = ClientMessage;
+                ce.xclient.message_type = OBT_PROP_ATOM(WM_PROTOCOLS);
+                ce.xclient.display = obt_display;
+                ce.xclient.window = moveresize_client->window;
+                ce.xclient.format = 32;
+                ce.xclient.data.l[0] = OBT_PROP_ATOM(NET_WM_SYNC_REQUEST);
+                ce.xclient.data.l[1] = event_time();
+                ce.xclient.data.l[2] = XSyncValueLow32(val);
+                ce.xclient.data.l[3] = XSyncValueHigh32(val);
+                ce.xclient.data.l[4] = 0l;
+                XSendEvent(obt_display, moveresize_client->window, FALSE,
+                           NoEventMask, &ce);
+
+                waiting_for_sync = 1;
+                sync_sent_usec = now;
+                sync_measured = FALSE;
+
+                if (sync_timer) g_source_remove(sync_timer);
+                sync_timer = g_timeout_add(sync_timeout(),
+                                           sync_timeout_func, NULL);
+            }
 #endif
 
-        /* force a ConfigureNotify, it is part of the spec for SYNC resizing
-           and MUST follow the sync counter notification */
-        client_configure(moveresize_client, cur_x, cur_y, cur_w, cur_h,
-                         TRUE, FALSE, TRUE);
+            /* force a ConfigureNotify, it is part of the spec for SYNC
+               resizing and MUST follow the sync counter notification */
+            client_configure(moveresize_client, cur_x, cur_y, cur_w, cur_h,
+                             TRUE, FALSE, TRUE);
+
+            next_resize_usec = now + resize_interval();
+        }
     }
 
     /* this would be better with a fixed width font ... XXX can do it better
@@ -460,10 +547,51 @@ static void do_resize(void)
         popup_coords(moveresize_client, "%d x %d", lw, lh);
 }
 
+static gboolean resize_frame(gint64 now_usec, gpointer data)
+{
+    /* keep waiting if the client still isn't due another size */
+    if (now_usec < next_resize_usec)
+        return TRUE;
+
+    do_resize();
+    return FALSE;
+}
+
 #ifdef SYNC
+/*! Remember how long the client took to answer a sync request.  Only the
+  first measure for each request counts, as the time since it was sent
+  only grows after that. */
+static void sync_rtt_measure(gint64 rtt)
+{
+    ObClient *c = moveresize_client;
+
+    if (sync_measured) return;
+    sync_measured = TRUE;
+
+    /* smooth it out so that one slow redraw doesn't throw it off */
+    c->sync_rtt = c->sync_rtt ? (c->sync_rtt * 3 + rtt) / 4 : rtt;
+}
+
+/*! Returns how long to wait for the client to answer a sync request, in
+  milliseconds */
+static guint sync_timeout(void)
+{
+    gint64 rtt = moveresize_client->sync_rtt;
+
+    /* wait the full time until we know how quick the client is */
+    if (!rtt) return SYNC_TIMEOUT_MAX;
+
+    return (guint)CLAMP(rtt * SYNC_TIMEOUT_RTTS / 1000,
+                        SYNC_TIMEOUT_MIN, SYNC_TIMEOUT_MAX);
+}
+
 static gboolean sync_timeout_func(gpointer data)
 {
     ++waiting_for_sync; /* we timed out waiting for our sync... */
+
+    /* the client is at least this slow, so wait longer next time */
+    sync_rtt_measure(animate_time() - sync_sent_usec);
+
     do_resize(); /* ...so let any pending resizes through */
 
     if (waiting_for_sync > SYNC_TIMEOUTS) {
@@ -603,6 +731,7 @@ static void edge_warp_move_ptr(void)
     }
 
     XWarpPointer(obt_display, 0, obt_root(ob_screen), 0, 0, 0, 0, x, y);
+    screen_pointer_forget();
 }
 
 static gboolean edge_warp_delay_func(gpointer data)
@@ -719,6 +848,7 @@ static void move_with_keys(KeySym sym, guint state)
 
     screen_pointer_pos(&opx, &opy);
     XWarpPointer(obt_display, None, None, 0, 0, 0, 0, dx, dy);
+    screen_pointer_forget();
     /* steal the motion events this causes */
     XFlush(obt_display);
     {
@@ -911,6 +1041,7 @@ static void resize_with_keys(KeySym sym, guint state)
 
     screen_pointer_pos(&opx, &opy);
     XWarpPointer(obt_display, None, None, 0, 0, 0, 0, pdx, pdy);
+    screen_pointer_forget();
     /* steal the motion events this causes */
     XFlush(obt_display);
     {
@@ -950,22 +1081,25 @@ gboolean moveresize_event(XEvent *e)
             used = TRUE;
         }
     } else if (e->type == MotionNotify) {
-        if (moving) {
-            XEvent ce;
-            ObtXQueueWindowType wt;
-
-            wt.window = e->xmotion.window;
-            wt.type = MotionNotify;
-            while (xqueue_remove_local(&ce, xqueue_match_window_type, &wt)) {
-                e->xmotion.x = ce.xmotion.x;
-                e->xmotion.y = ce.xmotion.y;
-                e->xmotion.x_root = ce.xmotion.x_root;
-                e->xmotion.y_root = ce.xmotion.y_root;
-            }
+        XEvent ce;
+        ObtXQueueWindowType wt;
+
+        /* only the latest pointer position matters, for moves and resizes
+           both */
+        wt.window = e->xmotion.window;
+        wt.type = MotionNotify;
+        while (xqueue_remove_local(&ce, xqueue_match_window_type, &wt)) {
+            e->xmotion.x = ce.xmotion.x;
+            e->xmotion.y = ce.xmotion.y;
+            e->xmotion.x_root = ce.xmotion.x_root;
+            e->xmotion.y_root = ce.xmotion.y_root;
+        }
 
+        if (moving) {
             cur_x = start_cx + e->xmotion.x_root - start_x;
             cur_y = start_cy + e->xmotion.y_root - start_y;
             do_move(FALSE, 0);
+            OBT_ROUNDTRIP("XSync");
             XSync(obt_display, FALSE);
             do_edge_warp(e->xmotion.x_root, e->xmotion.y_root);
         } else {
@@ -1105,7 +1239,13 @@ gboolean moveresize_event(XEvent *e)
 #ifdef SYNC
     else if (e->type == obt_display_extension_sync_basep + XSyncAlarmNotify)
     {
-        waiting_for_sync = 0; /* we got our sync... */
+        /* we got our sync, and now know how quick the client is... */
+        if (waiting_for_sync)
+            sync_rtt_measure(animate_time() - sync_sent_usec);
+        waiting_for_sync = 0;
+        if (sync_timer) g_source_remove(sync_timer);
+        sync_timer = 0;
+
         do_resize(); /* ...so try resize if there is more change pending */
         used = TRUE;
     }
@@ -42,6 +42,8 @@
 #include "config.h"
 #include "ping.h"
 #include "prompt.h"
+#include "animate.h"
+#include "replay.h"
 #include "gettext.h"
 #include "obrender/render.h"
 #include "obrender/theme.h"
@@ -106,6 +108,9 @@ static guint     remote_control = 0;
 static gboolean  being_replaced = FALSE;
 static gchar    *config_file = NULL;
 static gchar    *startup_cmd = NULL;
+static gboolean  debug_roundtrips = FALSE;
+static gchar    *record_file = NULL;
+static gchar    *replay_file = NULL;
 
 static void signal_handler(gint signal, gpointer data);
 static void remove_args(gint *argc, gchar **argv, gint index, gint num);
@@ -117,6 +122,7 @@ static void run_startup_cmd(void);
 gint main(gint argc, gchar **argv)
 {
     gchar *program_name;
+    RrImageCacheStats icon_stats;
 
     obt_signal_listen();
 
@@ -174,6 +180,8 @@ gint main(gint argc, gchar **argv)
     obt_signal_add_callback(SIGCHLD, signal_handler, NULL);
     obt_signal_add_callback(SIGTTIN, signal_handler, NULL);
     obt_signal_add_callback(SIGTTOU, signal_handler, NULL);
+    if (debug_roundtrips)
+        obt_signal_add_callback(SIGPROF, signal_handler, NULL);
 
     ob_screen = DefaultScreen(obt_display);
 
@@ -185,6 +193,10 @@ gint main(gint argc, gchar **argv)
        and the alt-tab icon
     */
     ob_rr_icons = RrImageCacheNew(3);
+    /* and don't let the resized icons grow without bound when a lot of
+       windows are open for a long time.  this is room for a few hundred
+       icons at the sizes they are drawn */
+    RrImageCacheSetMaxBytes(ob_rr_icons, 4 * 1024 * 1024);
 
     XSynchronize(obt_display, xsync);
 
@@ -311,6 +323,7 @@ gint main(gint argc, gchar **argv)
             /* focus_backup is used for stacking, so this needs to come before
                anything that calls stacking_add */
             sn_startup(reconfigure);
+            animate_startup(reconfigure);
             window_startup(reconfigure);
             focus_startup(reconfigure);
             focus_cycle_startup(reconfigure);
@@ -337,6 +350,12 @@ gint main(gint argc, gchar **argv)
                 guint32 xid;
                 ObWindow *w;
 
+                /* start before the existing windows are managed, so they are
+                   in the recording */
+                if (record_file && !replay_record(record_file))
+                    g_message(_("Unable to record the X events to \"%s\""),
+                              record_file);
+
                 /* get all the existing windows */
                 window_manage_all();
 
@@ -347,6 +366,9 @@ gint main(gint argc, gchar **argv)
                 {
                     client_focus(WINDOW_AS_CLIENT(w));
                 }
+
+                if (replay_file && !replay_start(replay_file))
+                    ob_exit_with_error(_("Unable to replay the X events."));
             } else {
                 GList *it;
 
@@ -408,6 +430,7 @@ gint main(gint argc, gchar **argv)
             focus_cycle_shutdown(reconfigure);
             focus_shutdown(reconfigure);
             window_shutdown(reconfigure);
+            animate_shutdown(reconfigure);
             sn_shutdown(reconfigure);
             event_shutdown(reconfigure);
             config_shutdown();
@@ -418,11 +441,19 @@ gint main(gint argc, gchar **argv)
     XSync(obt_display, FALSE);
 
     RrThemeFree(ob_rr_theme);
+    RrImageCacheGetStats(ob_rr_icons, &icon_stats);
+    ob_debug("Icon cache found %u of %u pictures already loaded, "
+             "saving %" G_GUINT64_FORMAT " bytes, and threw away %u "
+             "resized pictures to stay under its limit",
+             icon_stats.hits, icon_stats.lookups, icon_stats.bytes_saved,
+             icon_stats.evictions);
     RrImageCacheUnref(ob_rr_icons);
     RrInstanceFree(ob_rr_inst);
 
     session_shutdown(being_replaced);
 
+    if (debug_roundtrips)
+        obt_roundtrip_report();
     obt_display_close();
 
     if (restart) {
@@ -508,6 +539,9 @@ static void signal_handler(gint signal, gpointer data)
     case SIGTTOU:
         ob_debug("Caught signal %d. Ignoring.", signal);
         break;
+    case SIGPROF:
+        obt_roundtrip_report();
+        break;
     default:
         ob_debug("Caught signal %d. Exiting.", signal);
         /* TERM and INT return a 0 code */
@@ -550,6 +584,13 @@ static void print_help(void)
     g_print(_("  --debug-focus       Display debugging output for focus handling\n"));
     g_print(_("  --debug-session     Display debugging output for session management\n"));
     g_print(_("  --debug-xinerama    Split the display into fake xinerama screens\n"));
+    g_print(_("  --debug-roundtrips  Count the requests which wait for the X server, and\n"
+              "                      print them on exit or on SIGPROF\n"));
+    g_print(_("  --record-events FILE\n"
+              "                      Save the X events which are handled to FILE\n"));
+    g_print(_("  --replay-events FILE\n"
+              "                      Handle the X events saved in FILE, print how long\n"
+              "                      they took, and exit\n"));
     g_print(_("\nPlease report bugs at %s\n"), PACKAGE_BUGREPORT);
 }
 
@@ -656,6 +697,30 @@ static void parse_args(gint *argc, gchar **argv)
         else if (!strcmp(argv[i], "--debug-xinerama")) {
             ob_debug_xinerama = TRUE;
         }
+        else if (!strcmp(argv[i], "--debug-roundtrips")) {
+            debug_roundtrips = TRUE;
+            obt_roundtrip_enable(TRUE);
+        }
+        else if (!strcmp(argv[i], "--record-events")) {
+            if (i == *argc - 1) /* no args left */
+                g_printerr(_("%s requires an argument\n"), "--record-events");
+            else {
+                record_file = argv[i+1];
+                /* don't do it again when restarting */
+                remove_args(argc, argv, i, 2);
+                --i; /* this arg was removed so go back */
+            }
+        }
+        else if (!strcmp(argv[i], "--replay-events")) {
+            if (i == *argc - 1) /* no args left */
+                g_printerr(_("%s requires an argument\n"), "--replay-events");
+            else {
+                replay_file = argv[i+1];
+                /* don't do it again when restarting */
+                remove_args(argc, argv, i, 2);
+                --i; /* this arg was removed so go back */
+            }
+        }
         else if (!strcmp(argv[i], "--reconfigure")) {
             remote_control = 1;
         }
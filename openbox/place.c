@@ -27,9 +27,9 @@
 #include "debug.h"
 #include "place_overlap.h"
 
-static Rect *choose_pointer_monitor(ObClient *c)
+static void choose_pointer_monitor(ObClient *c, Rect *area)
 {
-    return screen_area(c->desktop, screen_monitor_pointer(), NULL);
+    screen_area(c->desktop, screen_monitor_pointer(), NULL, area);
 }
 
 /* use the following priority lists for choose_monitor()
@@ -153,11 +153,10 @@ gint cmp_background(const void *a, const void *b)
     return h1->monitor - h2->monitor;
 }
 
-/*! Pick a monitor to place a window on. */
-static Rect* choose_monitor(ObClient *c, gboolean client_to_be_foregrounded,
-                            ObAppSettings *settings)
+/*! Pick a monitor to place a window on, and fill in its area. */
+static void choose_monitor(ObClient *c, gboolean client_to_be_foregrounded,
+                           ObAppSettings *settings, Rect *area)
 {
-    Rect *area;
     ObPlaceHead *choice;
     guint i;
     ObClient *p;
@@ -246,12 +245,10 @@ static Rect* choose_monitor(ObClient *c, gboolean client_to_be_foregrounded,
             ob_debug("  - group on other desktop");
     }
 
-    area = screen_area(c->desktop, choice[0].monitor, NULL);
+    /* fill in the area for the chosen monitor */
+    screen_area(c->desktop, choice[0].monitor, NULL, area);
 
     g_free(choice);
-
-    /* return the area for the chosen monitor */
-    return area;
 }
 
 static gboolean place_under_mouse(ObClient *client, gint *x, gint *y,
@@ -259,7 +256,7 @@ static gboolean place_under_mouse(ObClient *client, gint *x, gint *y,
 {
     gint l, r, t, b;
     gint px, py;
-    Rect *area;
+    Rect area;
 
     if (config_place_policy != OB_PLACE_POLICY_MOUSE)
         return FALSE;
@@ -268,20 +265,18 @@ static gboolean place_under_mouse(ObClient *client, gint *x, gint *y,
 
     if (!screen_pointer_pos(&px, &py))
         return FALSE;
-    area = choose_pointer_monitor(client);
+    choose_pointer_monitor(client, &area);
 
-    l = area->x;
-    t = area->y;
-    r = area->x + area->width - frame_size.width;
-    b = area->y + area->height - frame_size.height;
+    l = area.x;
+    t = area.y;
+    r = area.x + area.width - frame_size.width;
+    b = area.y + area.height - frame_size.height;
 
     *x = px - frame_size.width / 2;
     *x = MIN(MAX(*x, l), r);
     *y = py - frame_size.height / 2;
     *y = MIN(MAX(*y, t), b);
 
-    g_slice_free(Rect, area);
-
     return TRUE;
 }
 
@@ -402,24 +397,23 @@ static gboolean place_least_overlap(ObClient *c, Rect *head, int *x, int *y,
     }
 
     if (!ignore_windows) {
-        GList* it;
-        for (it = client_list; it != NULL; it = g_list_next(it)) {
-            ObClient* maybe_client = (ObClient*)it->data;
+        guint i;
+        for (i = 0; i < client_array.num; ++i) {
+            ObClient* maybe_client = client_array.client[i];
+            const guint desktop = client_array.desktop[i];
             if (maybe_client == c)
                 continue;
-            if (maybe_client->iconic)
-                continue;
-            if (!client_occupies_space(maybe_client))
+            if (client_array.flags[i] & OB_CLIENT_ARRAY_ICONIC)
                 continue;
             if (c->desktop != DESKTOP_ALL) {
-                if (maybe_client->desktop != c->desktop &&
-                    maybe_client->desktop != DESKTOP_ALL)
+                if (desktop != c->desktop && desktop != DESKTOP_ALL)
                     continue;
             } else {
-                if (maybe_client->desktop != screen_desktop &&
-                    maybe_client->desktop != DESKTOP_ALL)
+                if (desktop != screen_desktop && desktop != DESKTOP_ALL)
                     continue;
             }
+            if (!client_occupies_space(maybe_client))
+                continue;
 
             potential_overlap_clients = g_slist_prepend(
                 potential_overlap_clients, maybe_client);
@@ -472,15 +466,15 @@ gboolean place_client(ObClient *client, gboolean client_to_be_foregrounded,
                       Rect* client_area, ObAppSettings *settings)
 {
     gboolean ret;
-    Rect *monitor_area;
+    Rect monitor_area;
     int *x, *y, *w, *h;
     Size frame_size;
 
-    monitor_area = choose_monitor(client, client_to_be_foregrounded, settings);
+    choose_monitor(client, client_to_be_foregrounded, settings, &monitor_area);
 
     w = &client_area->width;
     h = &client_area->height;
-    place_per_app_setting_size(client, monitor_area, w, h, settings);
+    place_per_app_setting_size(client, &monitor_area, w, h, settings);
 
     if (!should_set_client_position(client, settings))
         return FALSE;
@@ -493,15 +487,13 @@ gboolean place_client(ObClient *client, gboolean client_to_be_foregrounded,
              *h + client->frame->size.top + client->frame->size.bottom);
 
     ret =
-        place_per_app_setting_position(client, monitor_area, x, y, settings,
+        place_per_app_setting_position(client, &monitor_area, x, y, settings,
                                        frame_size) ||
-        place_transient_splash(client, monitor_area, x, y, frame_size) ||
+        place_transient_splash(client, &monitor_area, x, y, frame_size) ||
         place_under_mouse(client, x, y, frame_size) ||
-        place_least_overlap(client, monitor_area, x, y, frame_size);
+        place_least_overlap(client, &monitor_area, x, y, frame_size);
     g_assert(ret);
 
-    g_slice_free(Rect, monitor_area);
-
     /* get where the client should be */
     frame_frame_gravity(client->frame, x, y);
     return TRUE;
@@ -0,0 +1,468 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   replay.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "replay.h"
+#include "client.h"
+#include "frame.h"
+#include "event.h"
+#include "openbox.h"
+#include "debug.h"
+#include "obt/display.h"
+#include "obt/xqueue.h"
+
+#include <stdlib.h>
+
+/* The windows in a recording are not there when it is replayed, so notes in
+   the recording say which windows were clients, and which were parts of
+   their frames.  Windows are made to stand in for the clients, and events
+   on a frame are sent to a window in the stand-in's frame with the same
+   context, so they are handled the same way. */
+
+typedef enum {
+    NOTE_ROOT,
+    NOTE_CLIENT,
+    NOTE_FRAME
+} NoteKind;
+
+typedef struct _ReplayNote {
+    guint32 kind;
+    guint32 window;
+    /* NOTE_CLIENT: where the client was when it was managed */
+    gint32 x, y, w, h;
+    /* NOTE_FRAME: the client, and the window's ObFrameContext */
+    guint32 client;
+    guint32 context;
+} ReplayNote;
+
+typedef struct _ReplayStats {
+    guint count;
+    GArray *times; /* microseconds for each event, as gdouble */
+} ReplayStats;
+
+static ObtXQueueTrace *trace = NULL;
+static Window rec_root = None;
+static GHashTable *stand_ins = NULL; /* recorded window -> stand-in */
+static GHashTable *frames = NULL;    /* recorded window -> ReplayNote */
+static ReplayStats stats[LASTEvent];
+static guint skipped = 0;
+static gboolean time_known = FALSE;
+static Time time_offset = 0;
+static GTimer *timer = NULL;
+static gdouble replay_seconds = 0;
+/* the events read from the server during the replay, which are not timed
+   along with the replayed ones */
+static guint server_count = 0;
+static gdouble server_seconds = 0;
+
+static void note(const ReplayNote *n)
+{
+    xqueue_record_note(n, sizeof(*n));
+}
+
+gboolean replay_record(const gchar *path)
+{
+    ReplayNote n = { 0 };
+
+    if (!xqueue_record_start(path))
+        return FALSE;
+
+    n.kind = NOTE_ROOT;
+    n.window = obt_root(ob_screen);
+    note(&n);
+    return TRUE;
+}
+
+void replay_note_window(Window *xwin, ObWindow *win)
+{
+    ObClient *c;
+    ReplayNote n = { 0 };
+
+    if (!WINDOW_IS_CLIENT(win)) return;
+    c = WINDOW_AS_CLIENT(win);
+
+    n.window = *xwin;
+    if (xwin == &c->window) {
+        n.kind = NOTE_CLIENT;
+        n.x = c->area.x;
+        n.y = c->area.y;
+        n.w = c->area.width;
+        n.h = c->area.height;
+    }
+    else if (c->frame) {
+        n.kind = NOTE_FRAME;
+        n.client = c->window;
+        n.context = frame_context(c, *xwin, 0, 0);
+        if (n.context == OB_FRAME_CONTEXT_NONE ||
+            n.context == OB_FRAME_CONTEXT_MOVE_RESIZE)
+            return;
+    }
+    else
+        return;
+    note(&n);
+}
+
+/*! Returns a window in the frame which has the given context */
+static Window context_window(ObFrame *f, ObFrameContext context)
+{
+    switch (context) {
+    case OB_FRAME_CONTEXT_FRAME:       return f->window;
+    case OB_FRAME_CONTEXT_TITLEBAR:    return f->title;
+    case OB_FRAME_CONTEXT_TOP:         return f->titletop;
+    case OB_FRAME_CONTEXT_BOTTOM:      return f->handle;
+    case OB_FRAME_CONTEXT_LEFT:        return f->left;
+    case OB_FRAME_CONTEXT_RIGHT:       return f->right;
+    case OB_FRAME_CONTEXT_TLCORNER:    return f->titleleft;
+    case OB_FRAME_CONTEXT_TRCORNER:    return f->titleright;
+    case OB_FRAME_CONTEXT_BLCORNER:    return f->lgrip;
+    case OB_FRAME_CONTEXT_BRCORNER:    return f->rgrip;
+    case OB_FRAME_CONTEXT_MAXIMIZE:    return f->max;
+    case OB_FRAME_CONTEXT_ALLDESKTOPS: return f->desk;
+    case OB_FRAME_CONTEXT_SHADE:       return f->shade;
+    case OB_FRAME_CONTEXT_ICONIFY:     return f->iconify;
+    case OB_FRAME_CONTEXT_ICON:        return f->icon;
+    case OB_FRAME_CONTEXT_CLOSE:       return f->close;
+    default:                           return None;
+    }
+}
+
+static Window stand_in(Window rec, gint x, gint y, gint w, gint h)
+{
+    Window win;
+
+    /* the window manager maps it when it sees the MapRequest */
+    win = XCreateWindow(obt_display, obt_root(ob_screen),
+                        x, y, MAX(w, 1), MAX(h, 1), 0,
+                        CopyFromParent, InputOutput, CopyFromParent, 0, NULL);
+    g_hash_table_insert(stand_ins, GUINT_TO_POINTER(rec),
+                        GUINT_TO_POINTER(win));
+    return win;
+}
+
+/*! Find the window to use for one in the recording.  If @make is TRUE, then
+  a stand-in is made for a window not seen before. */
+static Window map_window(Window rec, gboolean make)
+{
+    gpointer p;
+    ReplayNote *n;
+
+    if (rec == None || rec == PointerRoot)
+        return rec;
+    if (rec == rec_root)
+        return obt_root(ob_screen);
+    if ((p = g_hash_table_lookup(stand_ins, GUINT_TO_POINTER(rec))))
+        return GPOINTER_TO_UINT(p);
+
+    if ((n = g_hash_table_lookup(frames, GUINT_TO_POINTER(rec)))) {
+        ObWindow *win;
+        Window w;
+
+        if ((p = g_hash_table_lookup(stand_ins, GUINT_TO_POINTER(n->client)))
+            && (win = window_find(GPOINTER_TO_UINT(p))) &&
+            WINDOW_IS_CLIENT(win) && WINDOW_AS_CLIENT(win)->frame &&
+            (w = context_window(WINDOW_AS_CLIENT(win)->frame, n->context)))
+        {
+            return w;
+        }
+        return rec;
+    }
+
+    if (make)
+        return stand_in(rec, 0, 0, 100, 100);
+    return rec;
+}
+
+static void map_time(Time *t)
+{
+    if (*t == CurrentTime) return;
+
+    /* move the recording's times to now, so they are not in the past */
+    if (!time_known) {
+        time_offset = event_time() - *t;
+        event_reset_time();
+        time_known = TRUE;
+    }
+    *t += time_offset;
+}
+
+/*! Change an event from the recording to refer to the windows here */
+static void map_event(XEvent *e)
+{
+    /* serials are used to ignore events caused by our own requests, and the
+       ones in the recording can not be compared to ours */
+    e->xany.serial = LastKnownRequestProcessed(obt_display);
+
+    switch (e->type) {
+    case KeyPress:
+    case KeyRelease:
+        e->xkey.window = map_window(e->xkey.window, FALSE);
+        e->xkey.root = map_window(e->xkey.root, FALSE);
+        e->xkey.subwindow = map_window(e->xkey.subwindow, FALSE);
+        map_time(&e->xkey.time);
+        break;
+    case ButtonPress:
+    case ButtonRelease:
+        e->xbutton.window = map_window(e->xbutton.window, FALSE);
+        e->xbutton.root = map_window(e->xbutton.root, FALSE);
+        e->xbutton.subwindow = map_window(e->xbutton.subwindow, FALSE);
+        map_time(&e->xbutton.time);
+        break;
+    case MotionNotify:
+        e->xmotion.window = map_window(e->xmotion.window, FALSE);
+        e->xmotion.root = map_window(e->xmotion.root, FALSE);
+        e->xmotion.subwindow = map_window(e->xmotion.subwindow, FALSE);
+        map_time(&e->xmotion.time);
+        break;
+    case EnterNotify:
+    case LeaveNotify:
+        e->xcrossing.window = map_window(e->xcrossing.window, FALSE);
+        e->xcrossing.root = map_window(e->xcrossing.root, FALSE);
+        e->xcrossing.subwindow = map_window(e->xcrossing.subwindow, FALSE);
+        map_time(&e->xcrossing.time);
+        break;
+    case CreateNotify:
+        if (e->xcreatewindow.parent == rec_root &&
+            !g_hash_table_lookup(stand_ins,
+                                 GUINT_TO_POINTER(e->xcreatewindow.window)))
+        {
+            stand_in(e->xcreatewindow.window,
+                     e->xcreatewindow.x, e->xcreatewindow.y,
+                     e->xcreatewindow.width, e->xcreatewindow.height);
+        }
+        e->xcreatewindow.parent = map_window(e->xcreatewindow.parent, FALSE);
+        e->xcreatewindow.window = map_window(e->xcreatewindow.window, FALSE);
+        break;
+    case MapRequest:
+        e->xmaprequest.parent = map_window(e->xmaprequest.parent, FALSE);
+        e->xmaprequest.window = map_window(e->xmaprequest.window, TRUE);
+        break;
+    case ConfigureRequest:
+        e->xconfigurerequest.parent =
+            map_window(e->xconfigurerequest.parent, FALSE);
+        e->xconfigurerequest.window =
+            map_window(e->xconfigurerequest.window, TRUE);
+        e->xconfigurerequest.above =
+            map_window(e->xconfigurerequest.above, FALSE);
+        break;
+    case ConfigureNotify:
+        e->xconfigure.event = map_window(e->xconfigure.event, FALSE);
+        e->xconfigure.window = map_window(e->xconfigure.window, FALSE);
+        e->xconfigure.above = map_window(e->xconfigure.above, FALSE);
+        break;
+    case ReparentNotify:
+        e->xreparent.event = map_window(e->xreparent.event, FALSE);
+        e->xreparent.window = map_window(e->xreparent.window, FALSE);
+        e->xreparent.parent = map_window(e->xreparent.parent, FALSE);
+        break;
+    case DestroyNotify:
+        e->xdestroywindow.event = map_window(e->xdestroywindow.event, FALSE);
+        e->xdestroywindow.window = map_window(e->xdestroywindow.window, FALSE);
+        break;
+    case UnmapNotify:
+        e->xunmap.event = map_window(e->xunmap.event, FALSE);
+        e->xunmap.window = map_window(e->xunmap.window, FALSE);
+        break;
+    case MapNotify:
+        e->xmap.event = map_window(e->xmap.event, FALSE);
+        e->xmap.window = map_window(e->xmap.window, FALSE);
+        break;
+    case PropertyNotify:
+        e->xproperty.window = map_window(e->xproperty.window, FALSE);
+        map_time(&e->xproperty.time);
+        break;
+    case ClientMessage:
+        /* the data can hold windows too, but which ones depends on the
+           message */
+        e->xclient.window = map_window(e->xclient.window, FALSE);
+        break;
+    default:
+        e->xany.window = map_window(e->xany.window, FALSE);
+        break;
+    }
+}
+
+static void free_note(gpointer n)
+{
+    g_slice_free(ReplayNote, n);
+}
+
+static void replay_note(const ReplayNote *n)
+{
+    switch (n->kind) {
+    case NOTE_ROOT:
+        rec_root = n->window;
+        break;
+    case NOTE_CLIENT:
+        /* a window which was already there when the recording began has
+           no MapRequest, so manage its stand-in here */
+        if (!g_hash_table_lookup(stand_ins, GUINT_TO_POINTER(n->window)))
+            window_manage(stand_in(n->window, n->x, n->y, n->w, n->h));
+        break;
+    case NOTE_FRAME:
+        g_hash_table_insert(frames, GUINT_TO_POINTER(n->window),
+                            g_slice_dup(ReplayNote, n));
+        break;
+    }
+}
+
+static gint cmp_double(gconstpointer a, gconstpointer b)
+{
+    const gdouble da = *(const gdouble*)a, db = *(const gdouble*)b;
+    return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+static void report(void)
+{
+    guint total = 0;
+    gint i;
+
+    for (i = 0; i < LASTEvent; ++i) {
+        ReplayStats *s = &stats[i];
+        gdouble *t, sum = 0;
+        guint j;
+
+        if (!s->count) continue;
+
+        t = (gdouble*)s->times->data;
+        qsort(t, s->count, sizeof(gdouble), cmp_double);
+        for (j = 0; j < s->count; ++j)
+            sum += t[j];
+        g_print("{\"event\": \"%s\", \"count\": %u, \"total_ms\": %.3f, "
+                "\"mean_us\": %.2f, \"p50_us\": %.2f, \"p95_us\": %.2f, "
+                "\"max_us\": %.2f}\n",
+                xqueue_event_name(i), s->count, sum / 1000.0,
+                sum / s->count, t[s->count / 2], t[s->count * 95 / 100],
+                t[s->count - 1]);
+        total += s->count;
+        g_array_free(s->times, TRUE);
+        s->times = NULL;
+        s->count = 0;
+    }
+    g_print("{\"event\": \"server\", \"count\": %u, "
+            "\"seconds\": %.3f}\n", server_count, server_seconds);
+    g_print("{\"event\": \"all\", \"count\": %u, \"skipped\": %u, "
+            "\"seconds\": %.3f}\n", total, skipped, replay_seconds);
+}
+
+/*! Handle an event, and return how many microseconds it took */
+static gdouble dispatch_timed(const XEvent *e)
+{
+    g_timer_start(timer);
+    xqueue_dispatch(e);
+    return g_timer_elapsed(timer, NULL) * 1000000.0;
+}
+
+/*! Handle the events in the local queue, which were read from the server.
+  Managing the stand-ins makes the server send events which are also in the
+  recording, so these are kept out of the replayed events' times. */
+static void dispatch_server(void)
+{
+    XEvent ev;
+
+    while (xqueue_next_local(&ev)) {
+        server_seconds += dispatch_timed(&ev) / 1000000.0;
+        ++server_count;
+    }
+}
+
+/*! Handle an event from the trace, and time it */
+static void dispatch_replayed(const XEvent *e)
+{
+    ReplayStats *s = &stats[e->type];
+    gdouble us;
+
+    /* so nothing read before is timed along with it */
+    dispatch_server();
+
+    us = dispatch_timed(e);
+    replay_seconds += us / 1000000.0;
+    if (!s->times)
+        s->times = g_array_new(FALSE, FALSE, sizeof(gdouble));
+    g_array_append_val(s->times, us);
+    ++s->count;
+
+    /* and the ones read while handling it */
+    dispatch_server();
+}
+
+static void replay_end(void)
+{
+    GHashTableIter it;
+    gpointer rec, win;
+
+    report();
+
+    xqueue_trace_close(trace);
+    trace = NULL;
+    g_timer_destroy(timer);
+    timer = NULL;
+
+    g_hash_table_iter_init(&it, stand_ins);
+    while (g_hash_table_iter_next(&it, &rec, &win))
+        XDestroyWindow(obt_display, GPOINTER_TO_UINT(win));
+    g_hash_table_destroy(stand_ins);
+    g_hash_table_destroy(frames);
+    stand_ins = frames = NULL;
+
+    ob_exit(0);
+}
+
+/* One thing from the trace is replayed each time, at a low priority, so the
+   events caused by replaying it are read from the server in between */
+static gboolean replay_next(gpointer data)
+{
+    gint64 time;
+    XEvent e;
+    gconstpointer n;
+    gsize size;
+
+    switch (xqueue_trace_read(trace, &time, &e, &n, &size)) {
+    case OBT_XQUEUE_TRACE_EVENT:
+        if (e.type >= LASTEvent) {
+            /* the extensions' events can't be matched to windows here */
+            ++skipped;
+            break;
+        }
+        map_event(&e);
+        dispatch_replayed(&e);
+        break;
+    case OBT_XQUEUE_TRACE_NOTE:
+        if (size == sizeof(ReplayNote))
+            replay_note(n);
+        break;
+    case OBT_XQUEUE_TRACE_ERROR:
+        g_message("The X event trace is damaged, stopping the replay");
+        /* fall through */
+    case OBT_XQUEUE_TRACE_END:
+        replay_end();
+        return FALSE; /* remove it */
+    }
+    return TRUE; /* repeat */
+}
+
+gboolean replay_start(const gchar *path)
+{
+    if (!(trace = xqueue_trace_open(path)))
+        return FALSE;
+
+    stand_ins = g_hash_table_new(g_direct_hash, g_direct_equal);
+    frames = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                   NULL, free_note);
+    timer = g_timer_new();
+    g_idle_add_full(G_PRIORITY_LOW, replay_next, NULL, NULL);
+    return TRUE;
+}
@@ -0,0 +1,41 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   replay.h for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __replay_h
+#define __replay_h
+
+#include "window.h"
+
+#include <X11/Xlib.h>
+#include <glib.h>
+
+/*! Start recording the X events to a file, with what is needed to replay
+  them.  This is done before any windows are managed. */
+gboolean replay_record(const gchar *path);
+
+/*! Note a window being added to the window map, while recording, so that
+  events on it can be sent to the same window when they are replayed */
+void replay_note_window(Window *xwin, ObWindow *win);
+
+/*! Replay the X events recorded in the file, through event_process, as fast
+  as they can be handled, with windows standing in for the clients in the
+  recording.  Prints the time taken to handle each type of event, and exits
+  when it is done. */
+gboolean replay_start(const gchar *path);
+
+#endif
@@ -135,7 +135,7 @@ void resist_move_windows(ObClient *c, gint resist, gint *x, gint *y)
 
 void resist_move_monitors(ObClient *c, gint resist, gint *x, gint *y)
 {
-    Rect *area;
+    Rect area;
     const Rect *parea;
     guint i;
     gint l, t, r, b; /* requested edges */
@@ -168,12 +168,12 @@ void resist_move_monitors(ObClient *c, gint resist, gint *x, gint *y)
             continue;
 
         /* use the cached area */
-        area = screen_area(c->desktop, i, NULL);
+        screen_area(c->desktop, i, NULL, &area);
 
-        al = RECT_LEFT(*area);
-        at = RECT_TOP(*area);
-        ar = RECT_RIGHT(*area);
-        ab = RECT_BOTTOM(*area);
+        al = RECT_LEFT(area);
+        at = RECT_TOP(area);
+        ar = RECT_RIGHT(area);
+        ab = RECT_BOTTOM(area);
         pl = RECT_LEFT(*parea);
         pt = RECT_TOP(*parea);
         pr = RECT_RIGHT(*parea);
@@ -196,8 +196,6 @@ void resist_move_monitors(ObClient *c, gint resist, gint *x, gint *y)
             *y = pt;
         else if (cb <= pb && b > pb && b < pb + resist)
             *y = pb - h + 1;
-
-        g_slice_free(Rect, area);
     }
 
     frame_frame_gravity(c->frame, x, y);
@@ -320,7 +318,7 @@ void resist_size_monitors(ObClient *c, gint resist, gint *w, gint *h,
 {
     gint l, t, r, b; /* my left, top, right and bottom sides */
     gint dlt, drb; /* my destination left/top and right/bottom sides */
-    Rect *area;
+    Rect area;
     const Rect *parea;
     gint al, at, ar, ab; /* screen boundaries */
     gint pl, pt, pr, pb; /* physical screen boundaries */
@@ -340,13 +338,13 @@ void resist_size_monitors(ObClient *c, gint resist, gint *w, gint *h,
             continue;
 
         /* use the cached area */
-        area = screen_area(c->desktop, i, NULL);
+        screen_area(c->desktop, i, NULL, &area);
 
         /* get the screen boundaries */
-        al = RECT_LEFT(*area);
-        at = RECT_TOP(*area);
-        ar = RECT_RIGHT(*area);
-        ab = RECT_BOTTOM(*area);
+        al = RECT_LEFT(area);
+        at = RECT_TOP(area);
+        ar = RECT_RIGHT(area);
+        ab = RECT_BOTTOM(area);
         pl = RECT_LEFT(*parea);
         pt = RECT_TOP(*parea);
         pr = RECT_RIGHT(*parea);
@@ -403,7 +401,5 @@ void resist_size_monitors(ObClient *c, gint resist, gint *w, gint *h,
                 *h = b - pt + 1;
             break;
         }
-
-        g_slice_free(Rect, area);
     }
 }
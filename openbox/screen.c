@@ -31,6 +31,7 @@
 #include "event.h"
 #include "focus.h"
 #include "focus_cycle.h"
+#include "client_list_menu.h"
 #include "popup.h"
 #include "version.h"
 #include "obrender/render.h"
@@ -55,6 +56,7 @@
 static gboolean screen_validate_layout(ObDesktopLayout *l);
 static gboolean replace_wm(void);
 static void     screen_fallback_focus(void);
+static void     strut_index_free(void);
 
 guint                  screen_num_desktops;
 guint                  screen_num_monitors;
@@ -77,12 +79,20 @@ static GSList *struts_top = NULL;
 static GSList *struts_left = NULL;
 static GSList *struts_right = NULL;
 static GSList *struts_bottom = NULL;
-static Rect **monitor_area_cache = NULL; /* [desktop][head] */
 
 static ObPagerPopup **desktop_popup;
 static guint         desktop_popup_timer = 0;
 static gboolean      desktop_popup_perm;
 
+/*! The pointer's position, from the event being handled or from the last
+  time it was asked for, while pointer_known is TRUE */
+static gint     pointer_x, pointer_y;
+static gboolean pointer_known = FALSE;
+/*! How many times the pointer's position was asked for, and how many of
+  those needed a round trip to the server */
+static guint    pointer_lookups = 0;
+static guint    pointer_queries = 0;
+
 /*! The number of microseconds that you need to be on a desktop before it will
   replace the remembered "last desktop" */
 #define REMEMBER_LAST_DESKTOP_TIME 750
@@ -111,6 +121,7 @@ static gboolean replace_wm(void)
 
         /* We want to find out when the current selection owner dies */
         XSelectInput(obt_display, current_wm_sn_owner, StructureNotifyMask);
+        OBT_ROUNDTRIP("XSync");
         XSync(obt_display, FALSE);
 
         obt_display_ignore_errors(FALSE);
@@ -466,13 +477,7 @@ void screen_shutdown(gboolean reconfig)
 {
     desktop_popup_free(screen_num_monitors);
 
-    if (monitor_area_cache) {
-        guint i;
-        for (i = 0; i < screen_num_desktops + 1; ++i)
-            g_free(monitor_area_cache[i]);
-        g_free(monitor_area_cache);
-        monitor_area_cache = NULL;
-    }
+    strut_index_free();
 
     if (reconfig)
         return;
@@ -490,6 +495,9 @@ void screen_shutdown(gboolean reconfig)
 
     g_strfreev(screen_desktop_names);
     screen_desktop_names = NULL;
+
+    ob_debug("Found the pointer's position %u times, asking the server %u "
+             "times", pointer_lookups, pointer_queries);
 }
 
 void screen_resize(void)
@@ -713,38 +721,37 @@ void screen_set_desktop(guint num, gboolean dofocus)
     if (moveresize_client)
         client_set_desktop(moveresize_client, num, TRUE, FALSE);
 
-    /* show windows before hiding the rest to lessen the enter/leave events */
+    /* only the windows on the old and new desktops change their visibility,
+       the ones on all desktops stay as they are */
 
-    /* show windows from top to bottom */
-    for (it = stacking_list; it; it = g_list_next(it)) {
-        if (WINDOW_IS_CLIENT(it->data)) {
-            ObClient *c = it->data;
-            client_show(c);
-        }
-    }
+    /* show windows before hiding the rest to lessen the enter/leave events.
+       each window is shown with the server grabbed, so grab it around all of
+       them at once to avoid a round trip for every window */
+    grab_server(TRUE);
+    for (it = client_desktop_list(num); it; it = g_list_next(it))
+        client_show(it->data);
+    grab_server(FALSE);
 
     if (dofocus) screen_fallback_focus();
 
-    /* hide windows from bottom to top */
-    for (it = g_list_last(stacking_list); it; it = g_list_previous(it)) {
-        if (WINDOW_IS_CLIENT(it->data)) {
-            ObClient *c = it->data;
-            if (client_hide(c)) {
-                if (c == focus_client) {
-                    /* c was focused and we didn't do fallback clearly so make
-                       sure openbox doesnt still consider the window focused.
-                       this happens when using NextWindow with allDesktops,
-                       since it doesnt want to move focus on desktop change,
-                       but the focus is not going to stay with the current
-                       window, which has now disappeared.
-                       only do this if the client was actually hidden,
-                       otherwise it can keep focus. */
-                    focus_set_client(NULL);
-                }
+    for (it = client_desktop_list(previous); it; it = g_list_next(it)) {
+        ObClient *c = it->data;
+        if (client_hide(c)) {
+            if (c == focus_client) {
+                /* c was focused and we didn't do fallback clearly so make
+                   sure openbox doesnt still consider the window focused.
+                   this happens when using NextWindow with allDesktops,
+                   since it doesnt want to move focus on desktop change,
+                   but the focus is not going to stay with the current
+                   window, which has now disappeared.
+                   only do this if the client was actually hidden,
+                   otherwise it can keep focus. */
+                focus_set_client(NULL);
             }
         }
     }
 
+    client_list_menu_invalidate();
     focus_cycle_addremove(NULL, TRUE);
 
     event_end_ignore_all_enters(ignore_start);
@@ -1236,6 +1243,8 @@ void screen_update_desktop_names(void)
                        (const gchar*const*)screen_desktop_names);
     }
 
+    client_list_menu_invalidate();
+
     /* resize the pager for these names */
     for (i = 0; i < screen_num_monitors; i++) {
         pager_popup_text_width_to_strings(desktop_popup[i],
@@ -1383,6 +1392,215 @@ typedef struct {
     } \
 }
 
+/*! How far a strut reaches in from an edge of the screen, over the range
+  from start to end (inclusive) along that edge */
+typedef struct {
+    gint start, end;
+    gint size;
+} ObScreenStrutSpan;
+
+/*! The struts on one edge of the screen, for one desktop */
+typedef struct {
+    /* every strut on the edge, sorted by where they start */
+    ObScreenStrutSpan *spans;
+    guint nspans;
+    /* how far the struts reach in at each point along the edge, as
+       non-overlapping pieces sorted by where they start */
+    ObScreenStrutSpan *envelope;
+    guint nenvelope;
+} ObScreenStrutEdge;
+
+typedef enum {
+    STRUT_EDGE_LEFT,
+    STRUT_EDGE_TOP,
+    STRUT_EDGE_RIGHT,
+    STRUT_EDGE_BOTTOM,
+    STRUT_NUM_EDGES
+} ObScreenStrutEdgeSide;
+
+/* the struts for each [desktop][edge], with the struts from every desktop
+   together after the last desktop, for DESKTOP_ALL */
+static ObScreenStrutEdge (*strut_index)[STRUT_NUM_EDGES] = NULL;
+/* the areas without a search rect, for each
+   [desktop * (strut_index_monitors + 1) + head] */
+static Rect *monitor_area_cache = NULL;
+/* the number of desktops and monitors which the index was built for */
+static guint strut_index_desktops = 0;
+static guint strut_index_monitors = 0;
+
+static gint strut_span_cmp(gconstpointer a, gconstpointer b)
+{
+    const ObScreenStrutSpan *sa = a, *sb = b;
+    return (sa->start > sb->start) - (sa->start < sb->start);
+}
+
+static gint strut_point_cmp(gconstpointer a, gconstpointer b)
+{
+    const gint *pa = a, *pb = b;
+    return (*pa > *pb) - (*pa < *pb);
+}
+
+static void strut_edge_build(ObScreenStrutEdge *e, GSList *list,
+                             ObScreenStrutEdgeSide side, guint desktop)
+{
+    GSList *it;
+    gint *points;
+    guint i, j, npoints;
+
+    e->spans = g_new(ObScreenStrutSpan, g_slist_length(list));
+    e->nspans = 0;
+    for (it = list; it; it = g_slist_next(it)) {
+        ObScreenStrut *s = it->data;
+        ObScreenStrutSpan *sp = &e->spans[e->nspans];
+
+        if (s->desktop != DESKTOP_ALL &&
+            (desktop < strut_index_desktops ?
+             s->desktop != desktop : s->desktop >= strut_index_desktops))
+            continue;
+
+        switch (side) {
+        case STRUT_EDGE_LEFT:
+            sp->start = s->strut->left_start;
+            sp->end = s->strut->left_end;
+            sp->size = s->strut->left;
+            break;
+        case STRUT_EDGE_TOP:
+            sp->start = s->strut->top_start;
+            sp->end = s->strut->top_end;
+            sp->size = s->strut->top;
+            break;
+        case STRUT_EDGE_RIGHT:
+            sp->start = s->strut->right_start;
+            sp->end = s->strut->right_end;
+            sp->size = s->strut->right;
+            break;
+        default:
+            sp->start = s->strut->bottom_start;
+            sp->end = s->strut->bottom_end;
+            sp->size = s->strut->bottom;
+            break;
+        }
+        if (sp->end >= sp->start)
+            ++e->nspans;
+    }
+    qsort(e->spans, e->nspans, sizeof(ObScreenStrutSpan), strut_span_cmp);
+
+    /* the reach can only change where a strut starts or ends, so find the
+       furthest reach between each of those points */
+    npoints = e->nspans * 2;
+    points = g_new(gint, npoints);
+    for (i = 0; i < e->nspans; ++i) {
+        points[i*2+0] = e->spans[i].start;
+        points[i*2+1] = e->spans[i].end + 1;
+    }
+    qsort(points, npoints, sizeof(gint), strut_point_cmp);
+
+    e->envelope = g_new(ObScreenStrutSpan, npoints);
+    e->nenvelope = 0;
+    for (i = 0; i + 1 < npoints; ++i) {
+        ObScreenStrutSpan *last;
+        gint size = 0;
+
+        if (points[i] == points[i+1]) continue;
+
+        for (j = 0; j < e->nspans && e->spans[j].start <= points[i]; ++j)
+            if (e->spans[j].end >= points[i])
+                size = MAX(size, e->spans[j].size);
+        if (!size) continue;
+
+        last = e->nenvelope ? &e->envelope[e->nenvelope-1] : NULL;
+        if (last && last->size == size && last->end == points[i] - 1)
+            last->end = points[i+1] - 1;
+        else {
+            e->envelope[e->nenvelope].start = points[i];
+            e->envelope[e->nenvelope].end = points[i+1] - 1;
+            e->envelope[e->nenvelope].size = size;
+            ++e->nenvelope;
+        }
+    }
+    g_free(points);
+}
+
+/*! Returns how far in from the edge the struts reach, over the range from
+  start to end (inclusive) along the edge.  Struts which reach further in
+  than max_size are left out.  Returns 0 if no struts are in the range. */
+static gint strut_edge_reach(const ObScreenStrutEdge *e, gint start, gint end,
+                             gint max_size)
+{
+    guint lo, hi, i;
+    gint size = 0;
+
+    if (max_size == G_MAXINT) {
+        /* find the first piece of the envelope that ends inside the range,
+           the pieces after it overlap the range until one starts past it */
+        lo = 0;
+        hi = e->nenvelope;
+        while (lo < hi) {
+            guint mid = (lo + hi) / 2;
+            if (e->envelope[mid].end < start) lo = mid + 1;
+            else hi = mid;
+        }
+        for (i = lo; i < e->nenvelope && e->envelope[i].start <= end; ++i)
+            size = MAX(size, e->envelope[i].size);
+    } else {
+        /* the envelope may hide smaller struts under ones that are too big,
+           so look at the struts themselves.  only the struts which start
+           before the range ends can be in it */
+        lo = 0;
+        hi = e->nspans;
+        while (lo < hi) {
+            guint mid = (lo + hi) / 2;
+            if (e->spans[mid].start <= end) lo = mid + 1;
+            else hi = mid;
+        }
+        for (i = 0; i < lo; ++i)
+            if (e->spans[i].end >= start && e->spans[i].size <= max_size)
+                size = MAX(size, e->spans[i].size);
+    }
+    return size;
+}
+
+static void strut_index_free(void)
+{
+    guint i, j;
+
+    if (strut_index) {
+        for (i = 0; i < strut_index_desktops + 1; ++i)
+            for (j = 0; j < STRUT_NUM_EDGES; ++j) {
+                g_free(strut_index[i][j].spans);
+                g_free(strut_index[i][j].envelope);
+            }
+        g_free(strut_index);
+        strut_index = NULL;
+    }
+    g_free(monitor_area_cache);
+    monitor_area_cache = NULL;
+    strut_index_desktops = strut_index_monitors = 0;
+}
+
+static void strut_index_build(void)
+{
+    guint i;
+
+    strut_index_free();
+
+    strut_index_desktops = screen_num_desktops;
+    strut_index_monitors = screen_num_monitors;
+    strut_index = g_malloc_n(strut_index_desktops + 1, sizeof(*strut_index));
+    for (i = 0; i < strut_index_desktops + 1; ++i) {
+        strut_edge_build(&strut_index[i][STRUT_EDGE_LEFT], struts_left,
+                         STRUT_EDGE_LEFT, i);
+        strut_edge_build(&strut_index[i][STRUT_EDGE_TOP], struts_top,
+                         STRUT_EDGE_TOP, i);
+        strut_edge_build(&strut_index[i][STRUT_EDGE_RIGHT], struts_right,
+                         STRUT_EDGE_RIGHT, i);
+        strut_edge_build(&strut_index[i][STRUT_EDGE_BOTTOM], struts_bottom,
+                         STRUT_EDGE_BOTTOM, i);
+    }
+    monitor_area_cache = g_new0(Rect, (strut_index_desktops + 1) *
+                                      (strut_index_monitors + 1));
+}
+
 static void get_xinerama_screens(Rect **xin_areas, guint *nxin)
 {
     guint i;
@@ -1402,7 +1620,8 @@ static void get_xinerama_screens(Rect **xin_areas, guint *nxin)
     }
 #ifdef XINERAMA
     else if (obt_display_extension_xinerama &&
-             (info = XineramaQueryScreens(obt_display, &n))) {
+             (OBT_ROUNDTRIP("XineramaQueryScreens"),
+              info = XineramaQueryScreens(obt_display, &n))) {
         *nxin = n;
         *xin_areas = g_new(Rect, *nxin + 1);
         for (i = 0; i < *nxin; ++i)
@@ -1449,9 +1668,9 @@ void screen_update_areas(void)
 
     /* collect the clients that are on screen */
     onscreen = NULL;
-    for (it = client_list; it; it = g_list_next(it)) {
-        if (client_monitor(it->data) != screen_num_monitors)
-            onscreen = g_list_prepend(onscreen, it->data);
+    for (i = 0; i < client_array.num; ++i) {
+        if (client_monitor(client_array.client[i]) != screen_num_monitors)
+            onscreen = g_list_prepend(onscreen, client_array.client[i]);
     }
 
     g_free(monitor_area);
@@ -1478,16 +1697,17 @@ void screen_update_areas(void)
     RESET_STRUT_LIST(struts_bottom);
 
     /* collect the struts */
-    for (it = client_list; it; it = g_list_next(it)) {
-        ObClient *c = it->data;
+    for (i = 0; i < client_array.num; ++i) {
+        ObClient *c = client_array.client[i];
+        const guint desktop = client_array.desktop[i];
         if (c->strut.left)
-            ADD_STRUT_TO_LIST(struts_left, c->desktop, &c->strut);
+            ADD_STRUT_TO_LIST(struts_left, desktop, &c->strut);
         if (c->strut.top)
-            ADD_STRUT_TO_LIST(struts_top, c->desktop, &c->strut);
+            ADD_STRUT_TO_LIST(struts_top, desktop, &c->strut);
         if (c->strut.right)
-            ADD_STRUT_TO_LIST(struts_right, c->desktop, &c->strut);
+            ADD_STRUT_TO_LIST(struts_right, desktop, &c->strut);
         if (c->strut.bottom)
-            ADD_STRUT_TO_LIST(struts_bottom, c->desktop, &c->strut);
+            ADD_STRUT_TO_LIST(struts_bottom, desktop, &c->strut);
     }
     if (dock_strut.left)
         ADD_STRUT_TO_LIST(struts_left, DESKTOP_ALL, &dock_strut);
@@ -1516,24 +1736,17 @@ void screen_update_areas(void)
     VALIDATE_STRUTS(struts_bottom, bottom,
                     monitor_area[screen_num_monitors].height / 2);
 
-    /* empty the cache */
-    if (monitor_area_cache) {
-        for (i = 0; i < screen_num_desktops + 1; ++i)
-            g_free(monitor_area_cache[i]);
-        g_free(monitor_area_cache);
-    }
-    monitor_area_cache = g_new0(Rect*, screen_num_desktops + 1);
-    for (i = 0; i < screen_num_desktops + 1; ++i)
-        monitor_area_cache[i] = g_new0(Rect, screen_num_monitors + 1);
+    /* index the struts and empty the cache */
+    strut_index_build();
 
     dims = g_new(gulong, 4 * screen_num_desktops);
     for (i = 0; i < screen_num_desktops; ++i) {
-        Rect *area = screen_area(i, SCREEN_AREA_ALL_MONITORS, NULL);
-        dims[i*4+0] = area->x;
-        dims[i*4+1] = area->y;
-        dims[i*4+2] = area->width;
-        dims[i*4+3] = area->height;
-        g_slice_free(Rect, area);
+        Rect area;
+        screen_area(i, SCREEN_AREA_ALL_MONITORS, NULL, &area);
+        dims[i*4+0] = area.x;
+        dims[i*4+1] = area.y;
+        dims[i*4+2] = area.width;
+        dims[i*4+3] = area.height;
     }
 
     /* set the legacy workarea hint to the union of all the monitors */
@@ -1574,38 +1787,13 @@ Rect* screen_area_all_monitors(guint desktop)
 }
 #endif
 
-#define STRUT_LEFT_IN_SEARCH(s, search) \
-    (RANGES_INTERSECT(search->y, search->height, \
-                      s->left_start, s->left_end - s->left_start + 1))
-#define STRUT_RIGHT_IN_SEARCH(s, search) \
-    (RANGES_INTERSECT(search->y, search->height, \
-                      s->right_start, s->right_end - s->right_start + 1))
-#define STRUT_TOP_IN_SEARCH(s, search) \
-    (RANGES_INTERSECT(search->x, search->width, \
-                      s->top_start, s->top_end - s->top_start + 1))
-#define STRUT_BOTTOM_IN_SEARCH(s, search) \
-    (RANGES_INTERSECT(search->x, search->width, \
-                      s->bottom_start, s->bottom_end - s->bottom_start + 1))
-
-#define STRUT_LEFT_IGNORE(s, us, search) \
-    (head == SCREEN_AREA_ALL_MONITORS && us && \
-     RECT_LEFT(monitor_area[i]) + s->left > RECT_LEFT(*search))
-#define STRUT_RIGHT_IGNORE(s, us, search) \
-    (head == SCREEN_AREA_ALL_MONITORS && us && \
-     RECT_RIGHT(monitor_area[i]) - s->right < RECT_RIGHT(*search))
-#define STRUT_TOP_IGNORE(s, us, search) \
-    (head == SCREEN_AREA_ALL_MONITORS && us && \
-     RECT_TOP(monitor_area[i]) + s->top > RECT_TOP(*search))
-#define STRUT_BOTTOM_IGNORE(s, us, search) \
-    (head == SCREEN_AREA_ALL_MONITORS && us && \
-     RECT_BOTTOM(monitor_area[i]) - s->bottom < RECT_BOTTOM(*search))
-
-Rect* screen_area(guint desktop, guint head, Rect *search)
+void screen_area(guint desktop, guint head, const Rect *search, Rect *area)
 {
-    Rect *a;
-    GSList *it;
-    gint l, r, t, b;
-    guint i, d;
+    const ObScreenStrutEdge *edges;
+    const Rect *all;
+    Rect *cached = NULL;
+    gint l, r, t, b, reach;
+    guint i;
     gboolean us = search != NULL; /* user provided search */
 
     g_assert(desktop < screen_num_desktops || desktop == DESKTOP_ALL);
@@ -1613,14 +1801,27 @@ Rect* screen_area(guint desktop, guint head, Rect *search)
              head == SCREEN_AREA_ALL_MONITORS);
     g_assert(!(head == SCREEN_AREA_ONE_MONITOR && search == NULL));
 
+    /* the number of desktops can change before the areas are updated for
+       it, so index the struts we have for the new number */
+    if (strut_index_desktops != screen_num_desktops ||
+        strut_index_monitors != screen_num_monitors)
+        strut_index_build();
+
+    all = &monitor_area[screen_num_monitors];
+    edges = strut_index[desktop == DESKTOP_ALL ? screen_num_desktops :
+                        desktop];
+
     /* use the cache if we can */
     if (!us) {
         guint d_idx = (desktop == DESKTOP_ALL ? screen_num_desktops : desktop);
-        guint h_idx = (head == SCREEN_AREA_ONE_MONITOR ? screen_num_monitors : head); /* this case is impossible though */
-        if (head == SCREEN_AREA_ALL_MONITORS) h_idx = screen_num_monitors;
-
-        if (monitor_area_cache[d_idx][h_idx].width > 0) {
-            return g_memdup2(&monitor_area_cache[d_idx][h_idx], sizeof(Rect));
+        guint h_idx = (head == SCREEN_AREA_ALL_MONITORS ?
+                       screen_num_monitors : head);
+
+        cached = &monitor_area_cache[d_idx * (screen_num_monitors + 1) +
+                                     h_idx];
+        if (cached->width > 0) {
+            *area = *cached;
+            return;
         }
     }
 
@@ -1631,20 +1832,16 @@ Rect* screen_area(guint desktop, guint head, Rect *search)
     /* search everything if search is null */
     if (!search) {
         if (head < screen_num_monitors) search = &monitor_area[head];
-        else search = &monitor_area[screen_num_monitors];
+        else search = all;
     }
     if (head == SCREEN_AREA_ONE_MONITOR) head = screen_find_monitor(search);
 
-    /* al is "all left" meaning the furthest left you can get, l is our
-       "working left" meaning our current strut edge which we're calculating
-    */
-
     /* only include monitors which the search area lines up with */
-    if (RECT_INTERSECTS_RECT(monitor_area[screen_num_monitors], *search)) {
-        l = RECT_RIGHT(monitor_area[screen_num_monitors]);
-        t = RECT_BOTTOM(monitor_area[screen_num_monitors]);
-        r = RECT_LEFT(monitor_area[screen_num_monitors]);
-        b = RECT_TOP(monitor_area[screen_num_monitors]);
+    if (RECT_INTERSECTS_RECT(*all, *search)) {
+        l = RECT_RIGHT(*all);
+        t = RECT_BOTTOM(*all);
+        r = RECT_LEFT(*all);
+        b = RECT_TOP(*all);
         for (i = 0; i < screen_num_monitors; ++i) {
             /* add the monitor if applicable */
             if (RANGES_INTERSECT(search->x, search->width,
@@ -1661,77 +1858,69 @@ Rect* screen_area(guint desktop, guint head, Rect *search)
             }
         }
     } else {
-        l = RECT_LEFT(monitor_area[screen_num_monitors]);
-        t = RECT_TOP(monitor_area[screen_num_monitors]);
-        r = RECT_RIGHT(monitor_area[screen_num_monitors]);
-        b = RECT_BOTTOM(monitor_area[screen_num_monitors]);
-    }
-
-    for (d = 0; d < screen_num_desktops; ++d) {
-        if (d != desktop && desktop != DESKTOP_ALL) continue;
-
-        for (i = 0; i < screen_num_monitors; ++i) {
-            if (head != SCREEN_AREA_ALL_MONITORS && head != i) continue;
-
-            for (it = struts_left; it; it = g_slist_next(it)) {
-                ObScreenStrut *s = it->data;
-                if ((s->desktop == d || s->desktop == DESKTOP_ALL) &&
-                    STRUT_LEFT_IN_SEARCH(s->strut, search) &&
-                    !STRUT_LEFT_IGNORE(s->strut, us, search))
-                    l = MAX(l, RECT_LEFT(monitor_area[screen_num_monitors])
-                               + s->strut->left);
-            }
-            for (it = struts_top; it; it = g_slist_next(it)) {
-                ObScreenStrut *s = it->data;
-                if ((s->desktop == d || s->desktop == DESKTOP_ALL) &&
-                    STRUT_TOP_IN_SEARCH(s->strut, search) &&
-                    !STRUT_TOP_IGNORE(s->strut, us, search))
-                    t = MAX(t, RECT_TOP(monitor_area[screen_num_monitors])
-                               + s->strut->top);
-            }
-            for (it = struts_right; it; it = g_slist_next(it)) {
-                ObScreenStrut *s = it->data;
-                if ((s->desktop == d || s->desktop == DESKTOP_ALL) &&
-                    STRUT_RIGHT_IN_SEARCH(s->strut, search) &&
-                    !STRUT_RIGHT_IGNORE(s->strut, us, search))
-                    r = MIN(r, RECT_RIGHT(monitor_area[screen_num_monitors])
-                               - s->strut->right);
-            }
-            for (it = struts_bottom; it; it = g_slist_next(it)) {
-                ObScreenStrut *s = it->data;
-                if ((s->desktop == d || s->desktop == DESKTOP_ALL) &&
-                    STRUT_BOTTOM_IN_SEARCH(s->strut, search) &&
-                    !STRUT_BOTTOM_IGNORE(s->strut, us, search))
-                    b = MIN(b, RECT_BOTTOM(monitor_area[screen_num_monitors])
-                               - s->strut->bottom);
+        l = RECT_LEFT(*all);
+        t = RECT_TOP(*all);
+        r = RECT_RIGHT(*all);
+        b = RECT_BOTTOM(*all);
+    }
+
+    /* the struts only apply when there is a monitor to apply them on */
+    if (head == SCREEN_AREA_ALL_MONITORS || head < screen_num_monitors) {
+        gint max_l, max_t, max_r, max_b;
+
+        max_l = max_t = max_r = max_b = G_MAXINT;
+        if (head == SCREEN_AREA_ALL_MONITORS && us) {
+            /* leave out struts which would cut into the search area on
+               every monitor */
+            gint ml, mt, mr, mb;
+
+            ml = RECT_LEFT(monitor_area[0]);
+            mt = RECT_TOP(monitor_area[0]);
+            mr = RECT_RIGHT(monitor_area[0]);
+            mb = RECT_BOTTOM(monitor_area[0]);
+            for (i = 1; i < screen_num_monitors; ++i) {
+                ml = MIN(ml, RECT_LEFT(monitor_area[i]));
+                mt = MIN(mt, RECT_TOP(monitor_area[i]));
+                mr = MAX(mr, RECT_RIGHT(monitor_area[i]));
+                mb = MAX(mb, RECT_BOTTOM(monitor_area[i]));
             }
+            max_l = RECT_LEFT(*search) - ml;
+            max_t = RECT_TOP(*search) - mt;
+            max_r = mr - RECT_RIGHT(*search);
+            max_b = mb - RECT_BOTTOM(*search);
+        }
 
-            /* limit to this monitor */
-            if (head == i) {
-                l = MAX(l, RECT_LEFT(monitor_area[i]));
-                t = MAX(t, RECT_TOP(monitor_area[i]));
-                r = MIN(r, RECT_RIGHT(monitor_area[i]));
-                b = MIN(b, RECT_BOTTOM(monitor_area[i]));
-            }
+        if (search->height) {
+            reach = strut_edge_reach(&edges[STRUT_EDGE_LEFT], search->y,
+                                     RECT_BOTTOM(*search), max_l);
+            if (reach) l = MAX(l, RECT_LEFT(*all) + reach);
+            reach = strut_edge_reach(&edges[STRUT_EDGE_RIGHT], search->y,
+                                     RECT_BOTTOM(*search), max_r);
+            if (reach) r = MIN(r, RECT_RIGHT(*all) - reach);
+        }
+        if (search->width) {
+            reach = strut_edge_reach(&edges[STRUT_EDGE_TOP], search->x,
+                                     RECT_RIGHT(*search), max_t);
+            if (reach) t = MAX(t, RECT_TOP(*all) + reach);
+            reach = strut_edge_reach(&edges[STRUT_EDGE_BOTTOM], search->x,
+                                     RECT_RIGHT(*search), max_b);
+            if (reach) b = MIN(b, RECT_BOTTOM(*all) - reach);
+        }
+
+        /* limit to this monitor */
+        if (head != SCREEN_AREA_ALL_MONITORS) {
+            l = MAX(l, RECT_LEFT(monitor_area[head]));
+            t = MAX(t, RECT_TOP(monitor_area[head]));
+            r = MIN(r, RECT_RIGHT(monitor_area[head]));
+            b = MIN(b, RECT_BOTTOM(monitor_area[head]));
         }
     }
 
-    a = g_slice_new(Rect);
-    a->x = l;
-    a->y = t;
-    a->width = r - l + 1;
-    a->height = b - t + 1;
+    RECT_SET(*area, l, t, r - l + 1, b - t + 1);
 
     /* cache the result */
-    if (!us) {
-        guint d_idx = (desktop == DESKTOP_ALL ? screen_num_desktops : desktop);
-        guint h_idx = (head == SCREEN_AREA_ONE_MONITOR ? screen_num_monitors : head); /* this case is impossible though */
-        if (head == SCREEN_AREA_ALL_MONITORS) h_idx = screen_num_monitors;
-
-        monitor_area_cache[d_idx][h_idx] = *a;
-    }
-
-    return a;
+    if (cached)
+        *cached = *area;
 }
 
 guint screen_find_monitor(const Rect *search)
@@ -1881,6 +2070,47 @@ guint screen_monitor_pointer()
     return screen_find_monitor_point(x, y);
 }
 
+void screen_pointer_event(const XEvent *e)
+{
+    switch (e->type) {
+    case ButtonPress:
+    case ButtonRelease:
+        if ((pointer_known = e->xbutton.same_screen)) {
+            pointer_x = e->xbutton.x_root;
+            pointer_y = e->xbutton.y_root;
+        }
+        break;
+    case MotionNotify:
+        if ((pointer_known = e->xmotion.same_screen)) {
+            pointer_x = e->xmotion.x_root;
+            pointer_y = e->xmotion.y_root;
+        }
+        break;
+    case EnterNotify:
+    case LeaveNotify:
+        if ((pointer_known = e->xcrossing.same_screen)) {
+            pointer_x = e->xcrossing.x_root;
+            pointer_y = e->xcrossing.y_root;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void screen_pointer_event_done(void)
+{
+    /* while the pointer is grabbed, all of its motion comes to us as events,
+       otherwise it could move anywhere before the next one */
+    if (!grab_on_pointer())
+        pointer_known = FALSE;
+}
+
+void screen_pointer_forget(void)
+{
+    pointer_known = FALSE;
+}
+
 gboolean screen_pointer_pos(gint *x, gint *y)
 {
     gint i;
@@ -1891,14 +2121,31 @@ gboolean screen_pointer_pos(gint *x, gint *y)
     guint u;
     gint j;
 
+    ++pointer_lookups;
+    if (pointer_known) {
+        *x = pointer_x;
+        *y = pointer_y;
+        return TRUE;
+    }
+
+    ++pointer_queries;
+    OBT_ROUNDTRIP("QueryPointer");
     ret = !!XQueryPointer(obt_display, obt_root(ob_screen),
                           &w, &w, x, y, &j, &j, &u);
     if (!ret) {
         for (i = 0; i < ScreenCount(obt_display); ++i)
-            if (i != ob_screen)
+            if (i != ob_screen) {
+                OBT_ROUNDTRIP("QueryPointer");
                 if ((ret=XQueryPointer(obt_display, obt_root(i),
                                   &w, &w, x, y, &j, &j, &u)))
                     break;
+            }
+    }
+    else if (grab_on_pointer()) {
+        /* keep it, as the pointer can't move now without us hearing */
+        pointer_x = *x;
+        pointer_y = *y;
+        pointer_known = TRUE;
     }
     return ret;
 }
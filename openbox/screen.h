@@ -148,9 +148,9 @@ const Rect* screen_physical_area_primary(gboolean fixed);
 /*! @param head is the number of the head or one of SCREEN_AREA_ALL_MONITORS,
            SCREEN_AREA_ONE_MONITOR
     @param search NULL or the whole monitor(s)
-    @return A Rect allocated with g_slice_new()
+    @param area Filled in with the area which is not covered by struts
  */
-Rect* screen_area(guint desktop, guint head, Rect *search);
+void screen_area(guint desktop, guint head, const Rect *search, Rect *area);
 
 gboolean screen_physical_area_monitor_contains(guint head, Rect *search);
 
@@ -168,9 +168,18 @@ guint screen_find_monitor_point(guint x, guint y);
 void screen_set_root_cursor(void);
 
 /*! Gives back the pointer's position in x and y. Returns TRUE if the pointer
-  is on this screen and FALSE if it is on another screen. */
+  is on this screen and FALSE if it is on another screen.  The position is
+  taken from the event being handled when it has one, or while the pointer
+  is grabbed, and only asked from the server otherwise. */
 gboolean screen_pointer_pos(gint *x, gint *y);
 
+/*! Remember the pointer's position from an event as it is handled */
+void screen_pointer_event(const XEvent *e);
+/*! Call when done handling an event */
+void screen_pointer_event_done(void);
+/*! Forget the pointer's position, after moving it */
+void screen_pointer_forget(void);
+
 /*! Returns the monitor which contains the pointer device */
 guint screen_monitor_pointer(void);
 
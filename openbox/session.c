@@ -32,7 +32,9 @@ GSList *session_desktop_names = NULL;
 #ifndef USE_SM
 void session_startup(gint argc, gchar **argv) {}
 void session_shutdown(gboolean permanent) {}
-GList* session_state_find(struct _ObClient *c) { return NULL; }
+ObSessionState* session_state_find(struct _ObClient *c) { return NULL; }
+struct _ObClient* session_state_above(ObSessionState *s) { return NULL; }
+void session_state_release(ObSessionState *s) {}
 void session_request_logout(gboolean silent) {}
 gboolean session_connected(void) { return FALSE; }
 #else
@@ -62,6 +64,13 @@ static SmcConn  sm_conn;
 static gint     sm_argc;
 static gchar  **sm_argv;
 
+/* the saved states, indexed by their session id and by their command.  the
+   values are GSLists of the states, in the saved stacking order */
+static GHashTable *state_by_id;
+static GHashTable *state_by_command;
+/* the saved states which clients were restored from, sorted by rank */
+static GSequence *state_restored;
+
 /* Data saved from the first level save yourself */
 typedef struct {
     ObClient *focus_client;
@@ -157,6 +166,13 @@ void session_shutdown(gboolean permanent)
             session_saved_state = g_list_delete_link(session_saved_state,
                                                      session_saved_state);
         }
+        if (state_by_id) {
+            g_hash_table_destroy(state_by_id);
+            g_hash_table_destroy(state_by_command);
+            g_sequence_free(state_restored);
+            state_by_id = state_by_command = NULL;
+            state_restored = NULL;
+        }
     }
 }
 
@@ -466,157 +482,158 @@ static void sm_shutdown_cancelled(SmcConn conn, SmPointer data)
 
 static gboolean session_save_to_file(const ObSMSaveData *savedata)
 {
-    FILE *f;
+    GString *f;
     GList *it;
+    GError *e = NULL;
     gboolean success = TRUE;
 
-    f = fopen(ob_sm_save_file, "w");
-    if (!f) {
-        success = FALSE;
-        g_message(_("Unable to save the session to \"%s\": %s"),
-                  ob_sm_save_file, g_strerror(errno));
-    } else {
-        fprintf(f, "<?xml version=\"1.0\"?>\n\n");
-        fprintf(f, "<openbox_session>\n\n");
-
-        fprintf(f, "<desktop>%d</desktop>\n", savedata->desktop);
-
-        fprintf(f, "<numdesktops>%d</numdesktops>\n", screen_num_desktops);
-
-        fprintf(f, "<desktoplayout>\n");
-        fprintf(f, "  <orientation>%d</orientation>\n",
-                screen_desktop_layout.orientation);
-        fprintf(f, "  <startcorner>%d</startcorner>\n",
-                screen_desktop_layout.start_corner);
-        fprintf(f, "  <columns>%d</columns>\n",
-                screen_desktop_layout.columns);
-        fprintf(f, "  <rows>%d</rows>\n",
-                screen_desktop_layout.rows);
-        fprintf(f, "</desktoplayout>\n");
-
-        if (screen_desktop_names) {
-            gint i;
-            gchar *t;
-
-            fprintf(f, "<desktopnames>\n");
-            for (i = 0; screen_desktop_names[i]; ++i){
-                t = g_markup_escape_text(screen_desktop_names[i], -1);
-                fprintf(f, "  <name>%s</name>\n", t);
-                g_free(t);
-            }
-            fprintf(f, "</desktopnames>\n");
+    /* the whole file is built in memory and then written in one go, to a
+       temporary file which replaces the old one, so a session file is never
+       left half written */
+    f = g_string_sized_new(4096);
+
+    g_string_append(f, "<?xml version=\"1.0\"?>\n\n");
+    g_string_append(f, "<openbox_session>\n\n");
+
+    g_string_append_printf(f, "<desktop>%d</desktop>\n", savedata->desktop);
+
+    g_string_append_printf(f, "<numdesktops>%d</numdesktops>\n",
+                           screen_num_desktops);
+
+    g_string_append(f, "<desktoplayout>\n");
+    g_string_append_printf(f, "  <orientation>%d</orientation>\n",
+                           screen_desktop_layout.orientation);
+    g_string_append_printf(f, "  <startcorner>%d</startcorner>\n",
+                           screen_desktop_layout.start_corner);
+    g_string_append_printf(f, "  <columns>%d</columns>\n",
+                           screen_desktop_layout.columns);
+    g_string_append_printf(f, "  <rows>%d</rows>\n",
+                           screen_desktop_layout.rows);
+    g_string_append(f, "</desktoplayout>\n");
+
+    if (screen_desktop_names) {
+        gint i;
+        gchar *t;
+
+        g_string_append(f, "<desktopnames>\n");
+        for (i = 0; screen_desktop_names[i]; ++i){
+            t = g_markup_escape_text(screen_desktop_names[i], -1);
+            g_string_append_printf(f, "  <name>%s</name>\n", t);
+            g_free(t);
         }
+        g_string_append(f, "</desktopnames>\n");
+    }
 
-        /* they are ordered top to bottom in stacking order */
-        for (it = stacking_list; it; it = g_list_next(it)) {
-            gint prex, prey, prew, preh;
-            ObClient *c;
-            gchar *t;
+    /* they are ordered top to bottom in stacking order */
+    for (it = stacking_list; it; it = g_list_next(it)) {
+        gint prex, prey, prew, preh;
+        ObClient *c;
+        gchar *t;
 
-            if (WINDOW_IS_CLIENT(it->data))
-                c = WINDOW_AS_CLIENT(it->data);
-            else
-                continue;
+        if (WINDOW_IS_CLIENT(it->data))
+            c = WINDOW_AS_CLIENT(it->data);
+        else
+            continue;
 
-            if (!client_normal(c))
-                continue;
+        if (!client_normal(c))
+            continue;
 
-            if (!c->sm_client_id) {
-                ob_debug_type(OB_DEBUG_SM, "Client %s does not have a "
-                              "session id set",
-                              c->title);
-                if (!c->wm_command) {
-                    ob_debug_type(OB_DEBUG_SM, "Client %s does not have an "
-                                  "oldskool wm_command set either. We won't "
-                                  "be saving its data",
-                                  c->title);
-                    continue;
-                }
-            }
-
-            ob_debug_type(OB_DEBUG_SM, "Saving state for client %s",
+        if (!c->sm_client_id) {
+            ob_debug_type(OB_DEBUG_SM, "Client %s does not have a "
+                          "session id set",
                           c->title);
-
-            prex = c->area.x;
-            prey = c->area.y;
-            prew = c->area.width;
-            preh = c->area.height;
-            if (c->fullscreen) {
-                prex = c->pre_fullscreen_area.x;
-                prey = c->pre_fullscreen_area.x;
-                prew = c->pre_fullscreen_area.width;
-                preh = c->pre_fullscreen_area.height;
-            }
-            if (c->max_horz) {
-                prex = c->pre_max_area.x;
-                prew = c->pre_max_area.width;
-            }
-            if (c->max_vert) {
-                prey = c->pre_max_area.y;
-                preh = c->pre_max_area.height;
-            }
-
-            if (c->sm_client_id)
-                fprintf(f, "<window id=\"%s\">\n", c->sm_client_id);
-            else {
-                t = g_markup_escape_text(c->wm_command, -1);
-                fprintf(f, "<window command=\"%s\">\n", t);
-                g_free(t);
+            if (!c->wm_command) {
+                ob_debug_type(OB_DEBUG_SM, "Client %s does not have an "
+                              "oldskool wm_command set either. We won't "
+                              "be saving its data",
+                              c->title);
+                continue;
             }
+        }
 
-            t = g_markup_escape_text(c->name, -1);
-            fprintf(f, "\t<name>%s</name>\n", t);
-            g_free(t);
-
-            t = g_markup_escape_text(c->class, -1);
-            fprintf(f, "\t<class>%s</class>\n", t);
-            g_free(t);
+        ob_debug_type(OB_DEBUG_SM, "Saving state for client %s",
+                      c->title);
+
+        prex = c->area.x;
+        prey = c->area.y;
+        prew = c->area.width;
+        preh = c->area.height;
+        if (c->fullscreen) {
+            prex = c->pre_fullscreen_area.x;
+            prey = c->pre_fullscreen_area.x;
+            prew = c->pre_fullscreen_area.width;
+            preh = c->pre_fullscreen_area.height;
+        }
+        if (c->max_horz) {
+            prex = c->pre_max_area.x;
+            prew = c->pre_max_area.width;
+        }
+        if (c->max_vert) {
+            prey = c->pre_max_area.y;
+            preh = c->pre_max_area.height;
+        }
 
-            t = g_markup_escape_text(c->role, -1);
-            fprintf(f, "\t<role>%s</role>\n", t);
+        if (c->sm_client_id)
+            g_string_append_printf(f, "<window id=\"%s\">\n", c->sm_client_id);
+        else {
+            t = g_markup_escape_text(c->wm_command, -1);
+            g_string_append_printf(f, "<window command=\"%s\">\n", t);
             g_free(t);
-
-            fprintf(f, "\t<windowtype>%d</windowtype>\n", c->type);
-
-            fprintf(f, "\t<desktop>%d</desktop>\n", c->desktop);
-            fprintf(f, "\t<x>%d</x>\n", prex);
-            fprintf(f, "\t<y>%d</y>\n", prey);
-            fprintf(f, "\t<width>%d</width>\n", prew);
-            fprintf(f, "\t<height>%d</height>\n", preh);
-            if (c->shaded)
-                fprintf(f, "\t<shaded />\n");
-            if (c->iconic)
-                fprintf(f, "\t<iconic />\n");
-            if (c->skip_pager)
-                fprintf(f, "\t<skip_pager />\n");
-            if (c->skip_taskbar)
-                fprintf(f, "\t<skip_taskbar />\n");
-            if (c->fullscreen)
-                fprintf(f, "\t<fullscreen />\n");
-            if (c->above)
-                fprintf(f, "\t<above />\n");
-            if (c->below)
-                fprintf(f, "\t<below />\n");
-            if (c->max_horz)
-                fprintf(f, "\t<max_horz />\n");
-            if (c->max_vert)
-                fprintf(f, "\t<max_vert />\n");
-            if (c->undecorated)
-                fprintf(f, "\t<undecorated />\n");
-            if (savedata->focus_client == c)
-                fprintf(f, "\t<focused />\n");
-            fprintf(f, "</window>\n\n");
         }
 
-        fprintf(f, "</openbox_session>\n");
+        t = g_markup_escape_text(c->name, -1);
+        g_string_append_printf(f, "\t<name>%s</name>\n", t);
+        g_free(t);
+
+        t = g_markup_escape_text(c->class, -1);
+        g_string_append_printf(f, "\t<class>%s</class>\n", t);
+        g_free(t);
+
+        t = g_markup_escape_text(c->role, -1);
+        g_string_append_printf(f, "\t<role>%s</role>\n", t);
+        g_free(t);
+
+        g_string_append_printf(f, "\t<windowtype>%d</windowtype>\n", c->type);
+
+        g_string_append_printf(f, "\t<desktop>%d</desktop>\n", c->desktop);
+        g_string_append_printf(f, "\t<x>%d</x>\n", prex);
+        g_string_append_printf(f, "\t<y>%d</y>\n", prey);
+        g_string_append_printf(f, "\t<width>%d</width>\n", prew);
+        g_string_append_printf(f, "\t<height>%d</height>\n", preh);
+        if (c->shaded)
+            g_string_append(f, "\t<shaded />\n");
+        if (c->iconic)
+            g_string_append(f, "\t<iconic />\n");
+        if (c->skip_pager)
+            g_string_append(f, "\t<skip_pager />\n");
+        if (c->skip_taskbar)
+            g_string_append(f, "\t<skip_taskbar />\n");
+        if (c->fullscreen)
+            g_string_append(f, "\t<fullscreen />\n");
+        if (c->above)
+            g_string_append(f, "\t<above />\n");
+        if (c->below)
+            g_string_append(f, "\t<below />\n");
+        if (c->max_horz)
+            g_string_append(f, "\t<max_horz />\n");
+        if (c->max_vert)
+            g_string_append(f, "\t<max_vert />\n");
+        if (c->undecorated)
+            g_string_append(f, "\t<undecorated />\n");
+        if (savedata->focus_client == c)
+            g_string_append(f, "\t<focused />\n");
+        g_string_append(f, "</window>\n\n");
+    }
 
-        if (fflush(f)) {
-            success = FALSE;
-            g_message(_("Error while saving the session to \"%s\": %s"),
-                      ob_sm_save_file, g_strerror(errno));
-        }
-        fclose(f);
+    g_string_append(f, "</openbox_session>\n");
+
+    if (!g_file_set_contents(ob_sm_save_file, f->str, f->len, &e)) {
+        success = FALSE;
+        g_message(_("Unable to save the session to \"%s\": %s"),
+                  ob_sm_save_file, e->message);
+        g_error_free(e);
     }
+    g_string_free(f, TRUE);
 
     return success;
 }
@@ -634,59 +651,158 @@ static void session_state_free(ObSessionState *state)
     }
 }
 
+/*! Compare a client against a saved state with the same session id or
+  command */
 static gboolean session_state_cmp(ObSessionState *s, ObClient *c)
 {
-    ob_debug_type(OB_DEBUG_SM, "Comparing client against saved state: ");
-    ob_debug_type(OB_DEBUG_SM, "  client id: %s ", c->sm_client_id);
-    ob_debug_type(OB_DEBUG_SM, "  client name: %s ", c->name);
-    ob_debug_type(OB_DEBUG_SM, "  client class: %s ", c->class);
-    ob_debug_type(OB_DEBUG_SM, "  client role: %s ", c->role);
-    ob_debug_type(OB_DEBUG_SM, "  client type: %d ", c->type);
-    ob_debug_type(OB_DEBUG_SM, "  client command: %s ",
-                  c->wm_command ? c->wm_command : "(null)");
-    ob_debug_type(OB_DEBUG_SM, "  state id: %s ", s->id);
-    ob_debug_type(OB_DEBUG_SM, "  state name: %s ", s->name);
-    ob_debug_type(OB_DEBUG_SM, "  state class: %s ", s->class);
-    ob_debug_type(OB_DEBUG_SM, "  state role: %s ", s->role);
-    ob_debug_type(OB_DEBUG_SM, "  state type: %d ", s->type);
-    ob_debug_type(OB_DEBUG_SM, "  state command: %s ",
-                  s->command ? s->command : "(null)");
-
-    if ((c->sm_client_id && s->id && !strcmp(c->sm_client_id, s->id)) ||
-        (c->wm_command && s->command && !strcmp(c->wm_command, s->command)))
-    {
-        return (!strcmp(s->name, c->name) &&
-                !strcmp(s->class, c->class) &&
-                !strcmp(s->role, c->role) &&
-                /* the check for type is to catch broken clients, like
-                   firefox, which open a different window on startup
-                   with the same info as the one we saved. only do this
-                   check for old windows that dont use xsmp, others should
-                   know better ! */
-                (!s->command || c->type == s->type));
+    return (!strcmp(s->name, c->name) &&
+            !strcmp(s->class, c->class) &&
+            !strcmp(s->role, c->role) &&
+            /* the check for type is to catch broken clients, like
+               firefox, which open a different window on startup
+               with the same info as the one we saved. only do this
+               check for old windows that dont use xsmp, others should
+               know better ! */
+            (!s->command || c->type == s->type));
+}
+
+static ObSessionState* session_state_find_in(GHashTable *table,
+                                             const gchar *key, ObClient *c)
+{
+    GSList *it;
+
+    if (!key) return NULL;
+
+    for (it = g_hash_table_lookup(table, key); it; it = g_slist_next(it)) {
+        ObSessionState *s = it->data;
+        if (!s->matched && session_state_cmp(s, c))
+            return s;
     }
-    return FALSE;
+    return NULL;
 }
 
-GList* session_state_find(ObClient *c)
+static gint session_state_rank_cmp(gconstpointer a, gconstpointer b,
+                                   gpointer data)
 {
-    GList *it;
+    const ObSessionState *sa = a, *sb = b;
+    return (gint)sa->rank - (gint)sb->rank;
+}
+
+ObSessionState* session_state_find(ObClient *c)
+{
+    ObSessionState *s, *sc;
+
+    if (!state_by_id) return NULL; /* no session was loaded */
+
+    s = session_state_find_in(state_by_id, c->sm_client_id, c);
+    sc = session_state_find_in(state_by_command, c->wm_command, c);
+    /* use the one that was saved first, if both match */
+    if (!s || (sc && sc->rank < s->rank))
+        s = sc;
+
+    if (s) {
+        ob_debug_type(OB_DEBUG_SM, "Client %s matches saved state %u "
+                      "(id: %s command: %s)", c->title, s->rank,
+                      s->id ? s->id : "(null)",
+                      s->command ? s->command : "(null)");
+        s->matched = TRUE;
+        s->client = c;
+        s->restored = g_sequence_insert_sorted(state_restored, s,
+                                               session_state_rank_cmp, NULL);
+    }
+    return s;
+}
 
+ObClient* session_state_above(ObSessionState *s)
+{
+    ObSessionState *above;
+
+    if (!s->restored || g_sequence_iter_is_begin(s->restored))
+        return NULL;
+    above = g_sequence_get(g_sequence_iter_prev(s->restored));
+    return above->client;
+}
+
+void session_state_release(ObSessionState *s)
+{
+    /* the state stays matched, it is not used again for another window */
+    if (s->restored) {
+        g_sequence_remove(s->restored);
+        s->restored = NULL;
+    }
+    s->client = NULL;
+}
+
+/*! Make a key which is the same for two saved states only when they can't
+  be told apart */
+static gchar* session_state_dup_key(ObSessionState *s)
+{
+    return g_strdup_printf("%c%s\n%s\n%s\n%s",
+                           s->id ? 'i' : 'c', s->id ? s->id : s->command,
+                           s->name, s->class, s->role);
+}
+
+static void session_state_index(void)
+{
+    GHashTable *dups;
+    GList *it, *next;
+    guint rank;
+
+    /* Remove any duplicates.  This means that if two windows (or more) are
+       saved with the same session state, we won't restore a session for any
+       of them because we don't know what window to put what on. AHEM FIREFOX.
+    */
+    dups = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
     for (it = session_saved_state; it; it = g_list_next(it)) {
+        gchar *k = session_state_dup_key(it->data);
+        guint n = GPOINTER_TO_UINT(g_hash_table_lookup(dups, k));
+        g_hash_table_replace(dups, k, GUINT_TO_POINTER(n + 1));
+    }
+    for (it = session_saved_state; it; it = next) {
+        ObSessionState *s = it->data;
+        gchar *k = session_state_dup_key(s);
+
+        next = g_list_next(it);
+        if (GPOINTER_TO_UINT(g_hash_table_lookup(dups, k)) > 1) {
+            ob_debug_type(OB_DEBUG_SM, "removing duplicate %s", s->name);
+            session_state_free(s);
+            session_saved_state = g_list_delete_link(session_saved_state, it);
+        }
+        g_free(k);
+    }
+    g_hash_table_destroy(dups);
+
+    state_by_id = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                        g_free, (GDestroyNotify)g_slist_free);
+    state_by_command = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                             (GDestroyNotify)g_slist_free);
+    state_restored = g_sequence_new(NULL);
+
+    rank = 0;
+    for (it = session_saved_state; it; it = g_list_next(it))
+        ((ObSessionState*)it->data)->rank = rank++;
+
+    /* go from the bottom up, so the lists end up in the saved order */
+    for (it = g_list_last(session_saved_state); it; it = g_list_previous(it)) {
         ObSessionState *s = it->data;
-        if (!s->matched && session_state_cmp(s, c)) {
-            s->matched = TRUE;
-            break;
+        GHashTable *t = s->id ? state_by_id : state_by_command;
+        const gchar *key = s->id ? s->id : s->command;
+        gpointer k, list;
+
+        if (g_hash_table_lookup_extended(t, key, &k, &list))
+            g_hash_table_steal(t, key);
+        else {
+            k = g_strdup(key);
+            list = NULL;
         }
+        g_hash_table_insert(t, k, g_slist_prepend(list, s));
     }
-    return it;
 }
 
 static void session_load_file(const gchar *path)
 {
     ObtXmlInst *i;
     xmlNodePtr node, n, m;
-    GList *it, *inext;
 
     i = obt_xml_instance_new();
 
@@ -787,9 +903,9 @@ static void session_load_file(const gchar *path)
         state->focused =
             obt_xml_find_node(node->children, "focused") != NULL;
 
-        /* save this. they are in the file in stacking order, so preserve
-           that order here */
-        session_saved_state = g_list_append(session_saved_state, state);
+        /* save this. they are in the file in stacking order, which is kept
+           once the list is reversed below */
+        session_saved_state = g_list_prepend(session_saved_state, state);
         ob_debug_type(OB_DEBUG_SM, "loaded %s", state->name);
         continue;
 
@@ -798,51 +914,10 @@ static void session_load_file(const gchar *path)
         session_state_free(state);
     }
 
-    /* Remove any duplicates.  This means that if two windows (or more) are
-       saved with the same session state, we won't restore a session for any
-       of them because we don't know what window to put what on. AHEM FIREFOX.
-
-       This is going to be an O(2^n) kind of operation unfortunately.
-    */
-    for (it = session_saved_state; it; it = inext) {
-        GList *jt, *jnext;
-        gboolean founddup = FALSE;
-        ObSessionState *s1 = it->data;
-
-        inext = g_list_next(it);
-
-        for (jt = g_list_next(it); jt; jt = jnext) {
-            ObSessionState *s2 = jt->data;
-            gboolean match;
-
-            jnext = g_list_next(jt);
-
-            if (s1->id && s2->id)
-                match = strcmp(s1->id, s2->id) == 0;
-            else if (s1->command && s2->command)
-                match = strcmp(s1->command, s2->command) == 0;
-            else
-                match = FALSE;
-
-            if (match &&
-                !strcmp(s1->name, s2->name) &&
-                !strcmp(s1->class, s2->class) &&
-                !strcmp(s1->role, s2->role))
-            {
-                ob_debug_type(OB_DEBUG_SM, "removing duplicate %s", s2->name);
-                session_state_free(s2);
-                session_saved_state =
-                    g_list_delete_link(session_saved_state, jt);
-                founddup = TRUE;
-            }
-        }
+    /* they were added backwards */
+    session_saved_state = g_list_reverse(session_saved_state);
 
-        if (founddup) {
-            ob_debug_type(OB_DEBUG_SM, "removing duplicate %s", s1->name);
-            session_state_free(s1);
-            session_saved_state = g_list_delete_link(session_saved_state, it);
-        }
-    }
+    session_state_index();
 
     obt_xml_instance_unref(i);
 }
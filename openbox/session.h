@@ -35,7 +35,12 @@ struct _ObSessionState {
     gboolean above, below, max_horz, max_vert, undecorated;
     gboolean focused;
 
+    /*! The state's place in the saved stacking order, 0 is the top */
+    guint rank;
     gboolean matched;
+    /*! The client that was restored from this state, while it is managed */
+    struct _ObClient *client;
+    GSequenceIter *restored;
 };
 
 /*! The desktop being viewed when the session was saved. A valud of -1 means
@@ -51,7 +56,14 @@ extern GList *session_saved_state;
 void session_startup(gint argc, gchar **argv);
 void session_shutdown(gboolean permanent);
 
-GList* session_state_find(struct _ObClient *c);
+/*! Find the saved state for a client which is being managed, and mark it
+  as restored by the client */
+ObSessionState* session_state_find(struct _ObClient *c);
+/*! Returns the client restored from the nearest saved state above @s in the
+  saved stacking order, or NULL if there is none */
+struct _ObClient* session_state_above(ObSessionState *s);
+/*! Call when the client restored from @s is unmanaged */
+void session_state_release(ObSessionState *s);
 
 void session_request_logout(gboolean silent);
 
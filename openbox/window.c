@@ -26,27 +26,25 @@
 #include "prompt.h"
 #include "debug.h"
 #include "grab.h"
+#include "replay.h"
 #include "obt/prop.h"
+#include "obt/winmap.h"
 #include "obt/xqueue.h"
 
-static GHashTable *window_map;
-
-static guint window_hash(Window *w) { return *w; }
-static gboolean window_comp(Window *w1, Window *w2) { return *w1 == *w2; }
+static ObtWinMap *window_map;
 
 void window_startup(gboolean reconfig)
 {
     if (reconfig) return;
 
-    window_map = g_hash_table_new((GHashFunc)window_hash,
-                                  (GEqualFunc)window_comp);
+    window_map = obt_winmap_new();
 }
 
 void window_shutdown(gboolean reconfig)
 {
     if (reconfig) return;
 
-    g_hash_table_destroy(window_map);
+    obt_winmap_free(window_map);
 }
 
 Window window_top(ObWindow *self)
@@ -88,20 +86,22 @@ ObStackingLayer window_layer(ObWindow *self)
 
 ObWindow* window_find(Window xwin)
 {
-    return g_hash_table_lookup(window_map, &xwin);
+    return obt_winmap_find(window_map, xwin);
 }
 
 void window_add(Window *xwin, ObWindow *win)
 {
     g_assert(xwin != NULL);
     g_assert(win != NULL);
-    g_hash_table_insert(window_map, xwin, win);
+    obt_winmap_add(window_map, *xwin, win);
+    if (xqueue_recording())
+        replay_note_window(xwin, win);
 }
 
 void window_remove(Window xwin)
 {
     g_assert(xwin != None);
-    g_hash_table_remove(window_map, &xwin);
+    obt_winmap_remove(window_map, xwin);
 }
 
 void window_manage_all(void)
@@ -111,6 +111,7 @@ void window_manage_all(void)
     XWMHints *wmhints;
     XWindowAttributes attrib;
 
+    OBT_ROUNDTRIP("QueryTree");
     if (!XQueryTree(obt_display, RootWindow(obt_display, ob_screen),
                     &w, &w, &children, &nchild)) {
         ob_debug("XQueryTree failed in window_manage_all");
@@ -120,6 +121,7 @@ void window_manage_all(void)
     /* remove all icon windows from the list */
     for (i = 0; i < nchild; i++) {
         if (children[i] == None) continue;
+        OBT_ROUNDTRIP("GetWMHints");
         wmhints = XGetWMHints(obt_display, children[i]);
         if (wmhints) {
             if ((wmhints->flags & IconWindowHint) &&
@@ -137,6 +139,7 @@ void window_manage_all(void)
     for (i = 0; i < nchild; ++i) {
         if (children[i] == None) continue;
         if (window_find(children[i])) continue; /* skip our own windows */
+        OBT_ROUNDTRIP("GetWindowAttributes");
         if (XGetWindowAttributes(obt_display, children[i], &attrib)) {
             if (attrib.map_state == IsUnmapped)
                 ;
@@ -170,13 +173,15 @@ void window_manage(Window win)
         ob_debug("Trying to manage unmapped window. Aborting that.");
         no_manage = TRUE;
     }
-    else if (!XGetWindowAttributes(obt_display, win, &attrib))
+    else if ((OBT_ROUNDTRIP("GetWindowAttributes"),
+              !XGetWindowAttributes(obt_display, win, &attrib)))
         no_manage = TRUE;
     else {
         XWMHints *wmhints;
 
         /* is the window a docking app */
         is_dockapp = FALSE;
+        OBT_ROUNDTRIP("GetWMHints");
         if ((wmhints = XGetWMHints(obt_display, win))) {
             if ((wmhints->flags & StateHint) &&
                 wmhints->initial_state == WithdrawnState)
@@ -0,0 +1,89 @@
+#!/bin/sh
+#
+# Runs a benchmark client against openbox on a new Xvfb display, and prints
+# the client's JSON results with the CPU time openbox used added to them.
+#
+#   benchmark.sh OPENBOX OBBENCH CLIENT [ARGS...]
+#   benchmark.sh --no-wm CLIENT [ARGS...]
+#
+# OBBENCH is the obbench program, which is used to wait for openbox to start.
+# With --no-wm, the client runs on the display by itself.
+# Set OB_BENCH_RESULTS to a file to append the results to it as well.
+# Set XVFB to the Xvfb program to run, if it is not Xvfb in the PATH.
+
+openbox=
+if [ "$1" = "--no-wm" ] && [ $# -ge 2 ]; then
+    shift
+elif [ $# -ge 3 ]; then
+    openbox=$1
+    obbench=$2
+    shift 2
+else
+    echo "usage: $0 OPENBOX OBBENCH CLIENT [ARGS...]" >&2
+    echo "       $0 --no-wm CLIENT [ARGS...]" >&2
+    exit 1
+fi
+
+dir=$(mktemp -d "${TMPDIR:-/tmp}/obbench.XXXXXX") || exit 1
+xvfb=
+ob=
+cleanup() {
+    [ -n "$ob" ] && kill "$ob" 2>/dev/null
+    [ -n "$xvfb" ] && kill "$xvfb" 2>/dev/null
+    wait 2>/dev/null
+    rm -rf "$dir"
+}
+trap cleanup EXIT
+trap 'exit 1' INT TERM
+
+# let Xvfb pick a free display, and tell us which one
+${XVFB:-Xvfb} -displayfd 3 -screen 0 1280x1024x24 -nolisten tcp \
+    3>"$dir/display" >"$dir/xvfb.log" 2>&1 &
+xvfb=$!
+i=0
+while [ ! -s "$dir/display" ]; do
+    i=$((i + 1))
+    if [ $i -gt 100 ] || ! kill -0 "$xvfb" 2>/dev/null; then
+        echo "Xvfb did not start:" >&2
+        cat "$dir/xvfb.log" >&2
+        exit 1
+    fi
+    sleep 0.1
+done
+DISPLAY=:$(cat "$dir/display")
+export DISPLAY
+
+# keep the user's configuration out of the results
+XDG_CONFIG_HOME=$dir/config
+XDG_CACHE_HOME=$dir/cache
+export XDG_CONFIG_HOME XDG_CACHE_HOME
+
+if [ -z "$openbox" ]; then
+    "$@" >"$dir/result" || exit 1
+    result=$(cat "$dir/result")
+else
+    "$openbox" --sm-disable >"$dir/openbox.log" 2>&1 &
+    ob=$!
+    if ! "$obbench" wait; then
+        cat "$dir/openbox.log" >&2
+        exit 1
+    fi
+
+    # user and system time, in clock ticks, from /proc/PID/stat
+    cpu_ticks() {
+        awk '{ print $14 + $15 }' "/proc/$1/stat" 2>/dev/null || echo 0
+    }
+
+    before=$(cpu_ticks "$ob")
+    "$@" >"$dir/result" || exit 1
+    after=$(cpu_ticks "$ob")
+    cpu=$(awk -v t=$((after - before)) -v hz="$(getconf CLK_TCK)" \
+          'BEGIN { printf "%.3f", t / hz }')
+
+    result=$(sed -e "s/}\$/, \"openbox_cpu_seconds\": $cpu}/" \
+             "$dir/result")
+fi
+echo "$result"
+if [ -n "$OB_BENCH_RESULTS" ]; then
+    echo "$result" >>"$OB_BENCH_RESULTS"
+fi
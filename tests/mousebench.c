@@ -0,0 +1,146 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   mousebench.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Replays pointer traffic over a window's frame with the XTest extension,
+   and times how long the window manager takes to get through it.  Buttons
+   that are not bound to anything are used, so that the time is spent
+   finding the bindings for the events, rather than running actions.  The
+   pointer stays over the frame, as events over the client would not go to
+   the window manager without a binding to grab them. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/XTest.h>
+
+static double now(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+int main(int argc, char **argv) {
+  Display   *display;
+  Window     win;
+  XEvent     report;
+  Atom       extents, type;
+  int        x=100,y=100,h=200,w=300;
+  int        i, n, ev, er, maj, min, format;
+  unsigned long nitems, after;
+  unsigned char *prop = NULL;
+  long       top, bottom;
+  double     start, end;
+
+  n = argc > 1 ? atoi(argv[1]) : 10000;
+
+  display = XOpenDisplay(NULL);
+
+  if (display == NULL) {
+    fprintf(stderr, "couldn't connect to X server\n");
+    return 1;
+  }
+  if (!XTestQueryExtension(display, &ev, &er, &maj, &min)) {
+    fprintf(stderr, "the X server does not have the XTEST extension\n");
+    return 1;
+  }
+
+  extents = XInternAtom(display, "_NET_FRAME_EXTENTS", False);
+
+  win = XCreateWindow(display, RootWindow(display, 0),
+                      x, y, w, h, 0, CopyFromParent, CopyFromParent,
+                      CopyFromParent, 0, NULL);
+  XSetWindowBackground(display,win,WhitePixel(display,0));
+  XSelectInput(display, win, StructureNotifyMask | PropertyChangeMask);
+  XMapWindow(display, win);
+
+  /* wait to be placed, and to find out how tall the titlebar and the
+     bottom of the frame are */
+  top = -1;
+  while (top < 0) {
+    XNextEvent(display, &report);
+    if (report.type == ConfigureNotify && report.xconfigure.send_event) {
+      x = report.xconfigure.x;
+      y = report.xconfigure.y;
+    }
+    if (report.type == PropertyNotify && report.xproperty.atom == extents) {
+      if (XGetWindowProperty(display, win, extents, 0, 4, False,
+                             XA_CARDINAL, &type, &format, &nitems, &after,
+                             &prop) == Success && prop && nitems == 4)
+      {
+        top = ((long*)prop)[2];
+        bottom = ((long*)prop)[3];
+      }
+      if (prop) XFree(prop);
+      prop = NULL;
+    }
+  }
+  /* let the window manager settle down */
+  sleep(1);
+  XSync(display, False);
+  while (XPending(display))
+    XNextEvent(display, &report);
+
+  start = now();
+  for (i = 0; i < n; ++i) {
+    /* move over the titlebar, then the bottom of the frame, and click
+       buttons which aren't bound, so each event goes through the binding
+       lookup */
+    XTestFakeMotionEvent(display, 0, x + 10 + i % 50, y - top / 2,
+                         CurrentTime);
+    XTestFakeButtonEvent(display, 6 + i % 4, True, CurrentTime);
+    XTestFakeButtonEvent(display, 6 + i % 4, False, CurrentTime);
+    XTestFakeMotionEvent(display, 0, x + 10 + i % 50, y + h + bottom / 2,
+                         CurrentTime);
+    XTestFakeButtonEvent(display, 6 + i % 4, True, CurrentTime);
+    XTestFakeButtonEvent(display, 6 + i % 4, False, CurrentTime);
+
+    /* don't get too far ahead of the window manager */
+    if (i % 100 == 99)
+      XSync(display, False);
+  }
+  /* ask the window manager to move the window.  it handles its events in
+     order, so when the window moves, it is done with the pointer events */
+  report.xclient.type = ClientMessage;
+  report.xclient.display = display;
+  report.xclient.window = win;
+  report.xclient.message_type =
+    XInternAtom(display, "_NET_MOVERESIZE_WINDOW", False);
+  report.xclient.format = 32;
+  report.xclient.data.l[0] = (1 << 8) | (2 << 12); /* x, from a pager */
+  report.xclient.data.l[1] = x + 1;
+  report.xclient.data.l[2] = 0;
+  report.xclient.data.l[3] = 0;
+  report.xclient.data.l[4] = 0;
+  XSendEvent(display, RootWindow(display, 0), False,
+             SubstructureNotifyMask | SubstructureRedirectMask, &report);
+  do
+    XNextEvent(display, &report);
+  while (report.type != ConfigureNotify);
+  end = now();
+
+  /* the same as obbench prints, for benchmark.sh */
+  printf("{\"scenario\": \"pointer\", \"ops\": %d, \"seconds\": %.6f}\n",
+         n * 6, end - start);
+
+  XCloseDisplay(display);
+  return 0;
+}
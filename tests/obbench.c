@@ -0,0 +1,341 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obbench.c for the Openbox window manager
+   Copyright (c) 2026        The Openbox developers
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Times how long the window manager takes to do things, from asking for
+   them until they are done, and prints the results as one line of JSON.
+
+     obbench wait                wait for the window manager to start
+     obbench map [N]             map N windows (default 100)
+     obbench focus [N] [ROUNDS]  activate each of N windows in turn
+     obbench desktop [ROUNDS]    switch desktops, with windows to hide/show
+     obbench resize [N] [FILE]   drag-resize a window with N pointer motions
+                                 (default 10000), following the path in FILE
+                                 if one is given, as "x y" offsets per line
+
+   It is run by benchmark.sh, against openbox on Xvfb, and needs the XTEST
+   extension for the resize. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/XTest.h>
+
+static Display *display;
+static Window   root;
+
+static double now(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+  double da = *(const double*)a, db = *(const double*)b;
+  return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+static void report(const char *scenario, int ops, double seconds,
+                   double *lat)
+{
+  printf("{\"scenario\": \"%s\", \"ops\": %d, \"seconds\": %.6f",
+         scenario, ops, seconds);
+  if (lat && ops > 0) {
+    double sum = 0;
+    int i;
+    for (i = 0; i < ops; ++i) sum += lat[i];
+    qsort(lat, ops, sizeof(double), cmp_double);
+    printf(", \"mean_ms\": %.3f, \"p50_ms\": %.3f, \"p95_ms\": %.3f"
+           ", \"max_ms\": %.3f",
+           sum / ops * 1000, lat[ops / 2] * 1000,
+           lat[(ops * 95) / 100] * 1000, lat[ops - 1] * 1000);
+  }
+  printf("}\n");
+  fflush(stdout);
+}
+
+static void message(Window w, const char *type, long l0, long l1, long l2,
+                    long l3, long l4)
+{
+  XEvent ce;
+
+  ce.xclient.type = ClientMessage;
+  ce.xclient.display = display;
+  ce.xclient.window = w;
+  ce.xclient.message_type = XInternAtom(display, type, False);
+  ce.xclient.format = 32;
+  ce.xclient.data.l[0] = l0;
+  ce.xclient.data.l[1] = l1;
+  ce.xclient.data.l[2] = l2;
+  ce.xclient.data.l[3] = l3;
+  ce.xclient.data.l[4] = l4;
+  XSendEvent(display, root, False,
+             SubstructureNotifyMask | SubstructureRedirectMask, &ce);
+}
+
+static long get_card32(Window w, const char *name)
+{
+  Atom type;
+  int format;
+  unsigned long nitems, after;
+  unsigned char *prop = NULL;
+  long ret = -1;
+
+  if (XGetWindowProperty(display, w, XInternAtom(display, name, False),
+                         0, 1, False, XA_CARDINAL, &type, &format, &nitems,
+                         &after, &prop) == Success && prop && nitems == 1)
+    ret = ((long*)prop)[0];
+  if (prop) XFree(prop);
+  return ret;
+}
+
+/* wait for the window manager to start, or give up after 10 seconds */
+static int wait_for_wm(void)
+{
+  Atom check = XInternAtom(display, "_NET_SUPPORTING_WM_CHECK", False);
+  int i;
+
+  for (i = 0; i < 1000; ++i) {
+    Atom type;
+    int format;
+    unsigned long nitems, after;
+    unsigned char *prop = NULL;
+    int found;
+
+    found = XGetWindowProperty(display, root, check, 0, 1, False,
+                               XA_WINDOW, &type, &format, &nitems, &after,
+                               &prop) == Success && prop && nitems == 1;
+    if (prop) XFree(prop);
+    if (found) return 1;
+    usleep(10000);
+  }
+  return 0;
+}
+
+/* map n windows, and return when the window manager has mapped them all */
+static Window* map_windows(int n, long mask)
+{
+  Window *wins;
+  XEvent e;
+  int i, mapped;
+
+  wins = malloc(sizeof(Window) * n);
+  for (i = 0; i < n; ++i) {
+    wins[i] = XCreateWindow(display, root, 10 + i % 50 * 10, 10 + i % 40 * 10,
+                            300, 200, 0, CopyFromParent, CopyFromParent,
+                            CopyFromParent, 0, NULL);
+    XSetWindowBackground(display, wins[i], WhitePixel(display, 0));
+    XSelectInput(display, wins[i], StructureNotifyMask | mask);
+    XMapWindow(display, wins[i]);
+  }
+  for (mapped = 0; mapped < n;) {
+    XNextEvent(display, &e);
+    if (e.type == MapNotify) ++mapped;
+  }
+  return wins;
+}
+
+static void bench_map(int n)
+{
+  double start, end;
+  Window *wins;
+
+  start = now();
+  wins = map_windows(n, NoEventMask);
+  end = now();
+  report("map", n, end - start, NULL);
+  free(wins);
+}
+
+static void bench_focus(int n, int rounds)
+{
+  Window *wins;
+  double *lat, start, t;
+  int i, ops;
+
+  if (n < 2) n = 2; /* a focused window doesn't get focused again */
+  ops = n * rounds;
+  wins = map_windows(n, NoEventMask);
+  lat = malloc(sizeof(double) * ops);
+
+  /* watch the focus only once the windows are mapped, and throw away what
+     came before, so focusing the new windows isn't timed as a round */
+  for (i = 0; i < n; ++i)
+    XSelectInput(display, wins[i], StructureNotifyMask | FocusChangeMask);
+  XSync(display, True);
+
+  start = now();
+  for (i = 0; i < ops; ++i) {
+    XEvent e;
+    Window w = wins[i % n];
+    unsigned long serial = NextRequest(display);
+
+    t = now();
+    /* from a pager, so the window manager does not refuse it */
+    message(w, "_NET_ACTIVE_WINDOW", 2, CurrentTime, None, 0, 0);
+    /* a FocusIn from before the message was sent is not the answer */
+    do
+      XWindowEvent(display, w, FocusChangeMask, &e);
+    while (e.type != FocusIn || e.xfocus.serial < serial);
+    lat[i] = now() - t;
+  }
+  report("focus", ops, now() - start, lat);
+  free(lat);
+  free(wins);
+}
+
+static void bench_desktop(int rounds)
+{
+  Window *wins;
+  Atom current = XInternAtom(display, "_NET_CURRENT_DESKTOP", False);
+  double *lat, start, t;
+  long num;
+  int i;
+
+  if ((num = get_card32(root, "_NET_NUMBER_OF_DESKTOPS")) < 2) {
+    message(root, "_NET_NUMBER_OF_DESKTOPS", 4, 0, 0, 0, 0);
+    while (get_card32(root, "_NET_NUMBER_OF_DESKTOPS") < 2)
+      usleep(10000);
+    num = get_card32(root, "_NET_NUMBER_OF_DESKTOPS");
+  }
+  /* windows on the first desktop, to hide and show */
+  wins = map_windows(20, NoEventMask);
+  lat = malloc(sizeof(double) * rounds);
+  XSelectInput(display, root, PropertyChangeMask);
+
+  start = now();
+  for (i = 0; i < rounds; ++i) {
+    XEvent e;
+
+    t = now();
+    message(root, "_NET_CURRENT_DESKTOP", (i + 1) % num, CurrentTime,
+            0, 0, 0);
+    do
+      XWindowEvent(display, root, PropertyChangeMask, &e);
+    while (e.xproperty.atom != current);
+    lat[i] = now() - t;
+  }
+  report("desktop", rounds, now() - start, lat);
+  free(lat);
+  free(wins);
+}
+
+static void bench_resize(int n, const char *path)
+{
+  Window *wins, w, child;
+  XEvent e;
+  int *dx, *dy, i, len, x, y, ev, er, maj, min;
+  double start;
+
+  if (!XTestQueryExtension(display, &ev, &er, &maj, &min)) {
+    fprintf(stderr, "the X server does not have the XTEST extension\n");
+    exit(1);
+  }
+
+  dx = malloc(sizeof(int) * n);
+  dy = malloc(sizeof(int) * n);
+  len = 0;
+  if (path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+      fprintf(stderr, "unable to open %s\n", path);
+      exit(1);
+    }
+    while (len < n && fscanf(f, "%d %d", &dx[len], &dy[len]) == 2)
+      ++len;
+    fclose(f);
+  } else {
+    /* grow and shrink the window, wobbling the way a hand does */
+    for (len = 0; len < n; ++len) {
+      int p = len % 400;
+      dx[len] = (p < 200 ? p : 400 - p) + (len * 7) % 5;
+      dy[len] = (p < 200 ? p : 400 - p) / 2 + (len * 3) % 4;
+    }
+  }
+
+  wins = map_windows(1, NoEventMask);
+  w = wins[0];
+  sleep(1); /* let the window manager settle down */
+  XTranslateCoordinates(display, w, root, 300, 200, &x, &y, &child);
+
+  start = now();
+  /* hold the button, then ask for the resize, like a toolkit does */
+  XTestFakeMotionEvent(display, 0, x, y, CurrentTime);
+  XTestFakeButtonEvent(display, 1, True, CurrentTime);
+  message(w, "_NET_WM_MOVERESIZE", x, y, 4 /* bottomright */, 1, 2);
+  XSync(display, False);
+  for (i = 0; i < len; ++i) {
+    XTestFakeMotionEvent(display, 0, x + dx[i], y + dy[i], CurrentTime);
+    /* don't get too far ahead of the window manager */
+    if (i % 100 == 99)
+      XSync(display, False);
+  }
+  XTestFakeButtonEvent(display, 1, False, CurrentTime);
+
+  /* the window manager handles its events in order, so when the window
+     gets a size that the drag never gives it, it is done with the drag */
+  message(w, "_NET_MOVERESIZE_WINDOW", (1 << 10) | (1 << 11) | (2 << 12),
+          0, 0, 123, 77);
+  do
+    XWindowEvent(display, w, StructureNotifyMask, &e);
+  while (e.type != ConfigureNotify || e.xconfigure.width != 123 ||
+         e.xconfigure.height != 77);
+  report("resize", len, now() - start, NULL);
+
+  free(dx);
+  free(dy);
+  free(wins);
+}
+
+int main(int argc, char **argv)
+{
+  const char *s = argc > 1 ? argv[1] : "";
+
+  if (!(display = XOpenDisplay(NULL))) {
+    fprintf(stderr, "couldn't connect to X server\n");
+    return 1;
+  }
+  root = RootWindow(display, 0);
+  if (!wait_for_wm()) {
+    fprintf(stderr, "no window manager started\n");
+    return 1;
+  }
+
+  if (!strcmp(s, "wait"))
+    ;
+  else if (!strcmp(s, "map"))
+    bench_map(argc > 2 ? atoi(argv[2]) : 100);
+  else if (!strcmp(s, "focus"))
+    bench_focus(argc > 2 ? atoi(argv[2]) : 20, argc > 3 ? atoi(argv[3]) : 50);
+  else if (!strcmp(s, "desktop"))
+    bench_desktop(argc > 2 ? atoi(argv[2]) : 200);
+  else if (!strcmp(s, "resize"))
+    bench_resize(argc > 2 ? atoi(argv[2]) : 10000, argc > 3 ? argv[3] : NULL);
+  else {
+    fprintf(stderr, "usage: obbench wait|map|focus|desktop|resize [ARGS]\n");
+    return 1;
+  }
+
+  XCloseDisplay(display);
+  return 0;
+}